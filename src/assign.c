@@ -0,0 +1,373 @@
+/*
+ * *******************
+ * *** ASSIGN PART ***
+ * *******************
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+
+#include "assign.h"
+#include "netlink.h"
+#include "stats.h"
+#include "sysfs.h"
+#include "verbose.h"
+
+#define ASSIGN_MAP_PREFIX "map:" /* rule prefix of the map file */
+#define ASSIGN_LINE_LEN 256 /* maximum line length in the map file */
+
+/* check and convert pnetid to upper case */
+static int assign_check_pnetid(char *pnetid) {
+	int len = strlen(pnetid);
+
+	if (len < 1 || len > SMC_MAX_PNETID_LEN)
+		return -1;
+	for (int i = 0; i < len; i++) {
+		if (!isalnum((unsigned char) pnetid[i]))
+			return -1;
+		pnetid[i] = toupper((unsigned char) pnetid[i]);
+	}
+	return 0;
+}
+
+/* read the bus-id prefix to pnetid mappings from the file at path, one
+ * "<bus-id prefix> <pnetid>" pair per line
+ */
+static int assign_read_map(const char *path, struct assign_rule *rule) {
+	char line[ASSIGN_LINE_LEN];
+	struct assign_map *maps;
+	char *prefix, *pnetid;
+	int num_line = 0;
+	FILE *file;
+
+	file = fopen(path, "r");
+	if (!file) {
+		log_error("Cannot open map file \"%s\".\n", path);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), file)) {
+		num_line++;
+		prefix = strtok(line, " \t\r\n");
+		if (!prefix || prefix[0] == '#')
+			continue;
+		pnetid = strtok(NULL, " \t\r\n");
+		if (!pnetid || strtok(NULL, " \t\r\n") ||
+		    assign_check_pnetid(pnetid)) {
+			log_error("Invalid mapping in line %d of map file "
+				  "\"%s\".\n", num_line, path);
+			goto fail;
+		}
+		maps = realloc(rule->maps, (rule->num_maps + 1) *
+			       sizeof(*rule->maps));
+		if (!maps)
+			goto fail;
+		rule->maps = maps;
+		maps = &rule->maps[rule->num_maps];
+		maps->prefix = strdup(prefix);
+		if (!maps->prefix)
+			goto fail;
+		strcpy(maps->pnetid, pnetid);
+		rule->num_maps++;
+	}
+	fclose(file);
+	return 0;
+fail:
+	fclose(file);
+	return -1;
+}
+
+/* parse the auto-assign rule in arg: "function", "port", "slot", or
+ * "map:<file>"
+ */
+int assign_parse_rule(const char *arg, struct assign_rule *rule) {
+	memset(rule, 0, sizeof(*rule));
+	if (!strcmp(arg, "function")) {
+		rule->type = ASSIGN_RULE_FUNCTION;
+		return 0;
+	}
+	if (!strcmp(arg, "port")) {
+		rule->type = ASSIGN_RULE_PORT;
+		return 0;
+	}
+	if (!strcmp(arg, "slot")) {
+		rule->type = ASSIGN_RULE_SLOT;
+		return 0;
+	}
+	if (!strncmp(arg, ASSIGN_MAP_PREFIX, strlen(ASSIGN_MAP_PREFIX))) {
+		rule->type = ASSIGN_RULE_MAP;
+		if (assign_read_map(arg + strlen(ASSIGN_MAP_PREFIX), rule)) {
+			assign_free_rule(rule);
+			return -1;
+		}
+		return 0;
+	}
+	log_error("Invalid auto-assign rule \"%s\".\n", arg);
+	return -1;
+}
+
+/* free the mappings of rule */
+void assign_free_rule(struct assign_rule *rule) {
+	for (int i = 0; i < rule->num_maps; i++)
+		free(rule->maps[i].prefix);
+	free(rule->maps);
+	rule->maps = NULL;
+	rule->num_maps = 0;
+}
+
+/* check if device is a net, infiniband, or ism device */
+static int assign_is_net(struct device *device) {
+	return device->kind == DEVICE_KIND_NET;
+}
+
+static int assign_is_partner(struct device *device) {
+	return device->kind == DEVICE_KIND_IB ||
+		device->kind == DEVICE_KIND_ISM;
+}
+
+/* read the physical port of a net device, starting at 1 like ib ports */
+static int assign_read_dev_port(struct device *device) {
+	char path[strlen(sysfs_root) + strlen(device->name) + 32];
+	int dev_port = 0;
+	FILE *file;
+
+	snprintf(path, sizeof(path), "%s/class/net/%s/dev_port", sysfs_root,
+		 device->name);
+	file = fopen(path, "r");
+	if (!file)
+		return 1;
+	stats_inc(STATS_SYSFS_READS);
+	if (fscanf(file, "%d", &dev_port) != 1)
+		dev_port = 0;
+	fclose(file);
+	return dev_port + 1;
+}
+
+/* get the pnetid of the longest bus-id prefix matching the device */
+static const char *assign_map_pnetid(struct assign_rule *rule,
+				     struct device *device) {
+	const char *pnetid = NULL;
+	size_t best = 0;
+	size_t len;
+
+	for (int i = 0; i < rule->num_maps; i++) {
+		len = strlen(rule->maps[i].prefix);
+		if (len > best && !strncmp(device->parent,
+					   rule->maps[i].prefix, len)) {
+			pnetid = rule->maps[i].pnetid;
+			best = len;
+		}
+	}
+	return pnetid;
+}
+
+/* derive the pnetid of device from its pci bus-id according to rule */
+static int assign_topology_pnetid(struct assign_rule *rule,
+				  struct device *device, char *pnetid) {
+	char bus_id[SMC_MAX_PNETID_LEN + 1];
+	char name[32];
+	int port = 1;
+	int len = 0;
+	int rc;
+
+	if (device->bus != DEVICE_BUS_PCI)
+		return -1;
+
+	/* bus-id without separators, the slot ends at the function */
+	for (const char *c = device->parent; *c; c++) {
+		if (rule->type == ASSIGN_RULE_SLOT && *c == '.')
+			break;
+		if (!isalnum((unsigned char) *c))
+			continue;
+		if (len == SMC_MAX_PNETID_LEN)
+			return -1;
+		bus_id[len++] = toupper((unsigned char) *c);
+	}
+	bus_id[len] = 0;
+
+	switch (rule->type) {
+	case ASSIGN_RULE_FUNCTION:
+		rc = snprintf(name, sizeof(name), "PCI%s", bus_id);
+		break;
+	case ASSIGN_RULE_PORT:
+		if (assign_is_net(device))
+			port = assign_read_dev_port(device);
+		else if (device->ib_port > 0)
+			port = device->ib_port;
+		rc = snprintf(name, sizeof(name), "PCI%sP%d", bus_id, port);
+		break;
+	default:
+		rc = snprintf(name, sizeof(name), "SLOT%s", bus_id);
+		break;
+	}
+	if (rc < 0 || rc > SMC_MAX_PNETID_LEN) {
+		log_info("Cannot derive pnetid for device \"%s\".\n",
+			 device->name);
+		return -1;
+	}
+	strcpy(pnetid, name);
+	return 0;
+}
+
+/* compare assignments by pnetid and net devices first */
+static int assign_cmp(const void *a, const void *b) {
+	const struct assignment *x = a;
+	const struct assignment *y = b;
+	int rc;
+
+	rc = strcmp(x->pnetid, y->pnetid);
+	if (rc)
+		return rc;
+	return assign_is_partner(x->device) - assign_is_partner(y->device);
+}
+
+/* only keep groups with a net device and an ib or ism device, the others
+ * cannot be used for smc
+ */
+static int assign_keep_pairs(struct assignment *assignments, int count) {
+	int kept = 0;
+	int net, partner;
+	int start, end;
+
+	qsort(assignments, count, sizeof(*assignments), assign_cmp);
+	for (start = 0; start < count; start = end) {
+		net = 0;
+		partner = 0;
+		for (end = start; end < count; end++) {
+			if (strcmp(assignments[start].pnetid,
+				   assignments[end].pnetid))
+				break;
+			if (assign_is_partner(assignments[end].device))
+				partner = 1;
+			else
+				net = 1;
+		}
+		if (!net || !partner)
+			continue;
+		memmove(&assignments[kept], &assignments[start],
+			(end - start) * sizeof(*assignments));
+		kept += end - start;
+	}
+	return kept;
+}
+
+/* compute the pnetids of all devices without pnetid according to rule in
+ * one pass over the devices list, returns the number of assignments
+ */
+int assign_compute(struct assign_rule *rule, struct assignment **assignments) {
+	struct assignment *new_assignments;
+	struct assignment *assignment;
+	struct device *device;
+	const char *pnetid;
+	int count = 0;
+	int size = 0;
+
+	*assignments = NULL;
+	device = get_next_device(&devices_list);
+	for (; device; device = get_next_device(device)) {
+		/* only physical devices without pnetid */
+		if (device->pnetid[0] || !device->parent ||
+		    (!assign_is_net(device) && !assign_is_partner(device)))
+			continue;
+		if (count == size) {
+			size = size ? size * 2 : 16;
+			new_assignments = realloc(*assignments,
+						  size * sizeof(**assignments));
+			if (!new_assignments) {
+				free(*assignments);
+				*assignments = NULL;
+				return -1;
+			}
+			*assignments = new_assignments;
+		}
+		assignment = &(*assignments)[count];
+		assignment->device = device;
+		if (rule->type == ASSIGN_RULE_MAP) {
+			pnetid = assign_map_pnetid(rule, device);
+			if (!pnetid)
+				continue;
+			strcpy(assignment->pnetid, pnetid);
+		} else if (assign_topology_pnetid(rule, device,
+						  assignment->pnetid)) {
+			continue;
+		}
+		count++;
+	}
+
+	/* user mappings are assigned as they are */
+	if (rule->type != ASSIGN_RULE_MAP)
+		count = assign_keep_pairs(*assignments, count);
+	log_info("Computed %d pnetid assignments.\n", count);
+	return count;
+}
+
+/* print the assignments on screen */
+void assign_print(struct assignment *assignments, int count) {
+	struct device *device;
+	const char *label;
+
+	printf("==========================================================");
+	printf("==========\n");
+	printf("%-16s %5.5s %15.15s %6.6s %5.5s %16.16s\n", "Pnetid:", "Type:",
+	       "Name:", "Port:", "Bus:", "Bus-ID:");
+	printf("==========================================================");
+	printf("==========\n");
+	for (int i = 0; i < count; i++) {
+		device = assignments[i].device;
+		label = device_kind_labels[device->kind];
+		printf("%-16s", assignments[i].pnetid);
+		if (device->kind == DEVICE_KIND_IB)
+			printf(" %5.5s %15.15s %6d", label, device->name,
+			       device->ib_port);
+		else
+			printf(" %5.5s %15.15s %6.6s", label, device->name, "");
+		printf("   %3.3s %16.16s\n", device->parent_subsystem,
+		       device->parent);
+	}
+}
+
+/* apply the assignments via netlink and report the failed ones, call
+ * between nl_init() and nl_cleanup(), returns 0 if all pnetids were added
+ */
+int assign_apply(struct assignment *assignments, int count) {
+	struct nl_pnetid *entries;
+	struct device *device;
+	int *results;
+	int rc = 0;
+
+	entries = calloc(count + 1, sizeof(*entries));
+	results = calloc(count + 1, sizeof(*results));
+	if (!entries || !results) {
+		free(entries);
+		free(results);
+		return -1;
+	}
+	for (int i = 0; i < count; i++) {
+		device = assignments[i].device;
+		entries[i].pnetid = assignments[i].pnetid;
+		entries[i].ib_port = -1;
+		if (assign_is_net(device)) {
+			entries[i].eth_name = device->name;
+		} else {
+			entries[i].ib_name = device->name;
+			if (device->kind == DEVICE_KIND_IB)
+				entries[i].ib_port = device->ib_port;
+		}
+	}
+
+	/* add all pnetids in one batch and check the result of each device */
+	log_info("Adding %d pnetid assignments.\n", count);
+	nl_set_pnetids(entries, count, results);
+	for (int i = 0; i < count; i++) {
+		if (!results[i])
+			continue;
+		log_error("Cannot add pnetid \"%s\" to device \"%s\": %s\n",
+			  assignments[i].pnetid, assignments[i].device->name,
+			  strerror(-results[i]));
+		rc = -1;
+	}
+	free(entries);
+	free(results);
+	return rc;
+}
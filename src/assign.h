@@ -0,0 +1,39 @@
+#ifndef _PNETCTL_ASSIGN_H
+#define _PNETCTL_ASSIGN_H
+
+#include "devices.h"
+
+/* rules for grouping devices that get the same pnetid */
+enum assign_rules {
+	ASSIGN_RULE_FUNCTION, /* same pci function */
+	ASSIGN_RULE_PORT, /* same pci function and physical port */
+	ASSIGN_RULE_SLOT, /* same pci slot */
+	ASSIGN_RULE_MAP, /* bus-id prefixes mapped to pnetids by the user */
+};
+
+/* bus-id prefix mapped to a pnetid */
+struct assign_map {
+	char *prefix;
+	char pnetid[SMC_MAX_PNETID_LEN + 1];
+};
+
+/* auto-assign rule */
+struct assign_rule {
+	int type;
+	struct assign_map *maps;
+	int num_maps;
+};
+
+/* pnetid assignment of a device */
+struct assignment {
+	struct device *device;
+	char pnetid[SMC_MAX_PNETID_LEN + 1];
+};
+
+int assign_parse_rule(const char *arg, struct assign_rule *rule);
+void assign_free_rule(struct assign_rule *rule);
+int assign_compute(struct assign_rule *rule, struct assignment **assignments);
+void assign_print(struct assignment *assignments, int count);
+int assign_apply(struct assignment *assignments, int count);
+
+#endif
@@ -0,0 +1,242 @@
+/*
+ * test for assign
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "test.h"
+#include "assign.h"
+#include "devices.h"
+#include "netlink.h"
+#include "sysfs.h"
+
+/* smc generic netlink family, negative if smc is not available */
+extern int nl_family;
+
+/* add devices of two pci functions in one slot and other devices */
+static void add_devices() {
+	test_add_device("net", "eth0", -1, "0000:3b:00.0", "");
+	test_add_device("net", "eth1", -1, "0000:3b:00.1", "");
+	test_add_device("infiniband", "mlx5_0", 1, "0000:3b:00.0", "");
+	test_add_device("infiniband", "mlx5_1", 1, "0000:3b:00.1", "");
+	test_add_device("net", "eth2", -1, "0000:5e:00.0", "");
+	test_add_device("net", "eth3", -1, "0000:af:00.0", "PNET1");
+	test_add_device("infiniband", "mlx5_2", 1, "0000:af:00.0", "");
+	test_add_device("net", "vlan0", -1, NULL, "");
+}
+
+/* find the pnetid assigned to device with name and ib_port */
+static const char *find_pnetid(struct assignment *assignments, int count,
+			       const char *name, int ib_port) {
+	for (int i = 0; i < count; i++)
+		if (!strcmp(assignments[i].device->name, name) &&
+		    assignments[i].device->ib_port == ib_port)
+			return assignments[i].pnetid;
+	return NULL;
+}
+
+/* compute the assignments with rule arg */
+static int compute(const char *arg, struct assignment **assignments) {
+	struct assign_rule rule;
+	int count;
+
+	if (assign_parse_rule(arg, &rule))
+		return -1;
+	count = assign_compute(&rule, assignments);
+	assign_free_rule(&rule);
+	return count;
+}
+
+// test the function assign_parse_rule()
+int test_assign_parse_rule() {
+	struct assign_rule rule;
+
+	if (assign_parse_rule("function", &rule) ||
+	    rule.type != ASSIGN_RULE_FUNCTION)
+		return -1;
+	if (assign_parse_rule("slot", &rule) || rule.type != ASSIGN_RULE_SLOT)
+		return -1;
+	if (!assign_parse_rule("bus", &rule) ||
+	    !assign_parse_rule("map:/nonexistent", &rule))
+		return -1;
+	return 0;
+}
+
+// test the function assign_compute() with the function and slot rules
+int test_assign_compute() {
+	struct assignment *assignments;
+	const char *pnetid;
+	int count;
+	int rc = -1;
+
+	add_devices();
+
+	/* eth2 has no partner, eth3 already has a pnetid */
+	count = compute("function", &assignments);
+	if (count != 4)
+		goto free;
+	pnetid = find_pnetid(assignments, count, "eth0", -1);
+	if (!pnetid || strcmp(pnetid, "PCI00003B000") ||
+	    strcmp(find_pnetid(assignments, count, "mlx5_0", 1), pnetid) ||
+	    !strcmp(find_pnetid(assignments, count, "eth1", -1), pnetid) ||
+	    find_pnetid(assignments, count, "eth2", -1) ||
+	    find_pnetid(assignments, count, "mlx5_2", 1))
+		goto free;
+	free(assignments);
+
+	count = compute("slot", &assignments);
+	if (count != 4)
+		goto free;
+	pnetid = find_pnetid(assignments, count, "eth1", -1);
+	if (!pnetid || strcmp(pnetid, "SLOT00003B00") ||
+	    strcmp(find_pnetid(assignments, count, "mlx5_0", 1), pnetid))
+		goto free;
+	assign_print(assignments, count);
+	rc = 0;
+free:
+	free(assignments);
+	free_devices();
+	return rc;
+}
+
+// test the function assign_compute() with the port rule
+int test_assign_compute_port() {
+	char root[] = "/tmp/pnetctl_test_assign.XXXXXX";
+	char path[sizeof(root) + 64];
+	struct assignment *assignments;
+	int count;
+	int rc = -1;
+	FILE *file;
+
+	if (!mkdtemp(root))
+		return -1;
+	snprintf(path, sizeof(path), "%s/class", root);
+	mkdir(path, 0755);
+	snprintf(path, sizeof(path), "%s/class/net", root);
+	mkdir(path, 0755);
+	snprintf(path, sizeof(path), "%s/class/net/eth0", root);
+	mkdir(path, 0755);
+	snprintf(path, sizeof(path), "%s/class/net/eth0/dev_port", root);
+	file = fopen(path, "w");
+	if (!file)
+		goto out;
+	fprintf(file, "1\n");
+	fclose(file);
+	sysfs_root = root;
+
+	/* eth0 is on the second port of its function */
+	test_add_device("net", "eth0", -1, "0000:3b:00.0", "");
+	test_add_device("infiniband", "mlx5_0", 1, "0000:3b:00.0", "");
+	test_add_device("infiniband", "mlx5_0", 2, "0000:3b:00.0", "");
+	count = compute("port", &assignments);
+	if (count == 2 &&
+	    !strcmp(find_pnetid(assignments, count, "eth0", -1),
+		    "PCI00003B000P2") &&
+	    !strcmp(find_pnetid(assignments, count, "mlx5_0", 2),
+		    "PCI00003B000P2"))
+		rc = 0;
+	free(assignments);
+	free_devices();
+out:
+	sysfs_root = SYSFS_ROOT;
+	unlink(path);
+	snprintf(path, sizeof(path), "%s/class/net/eth0", root);
+	rmdir(path);
+	snprintf(path, sizeof(path), "%s/class/net", root);
+	rmdir(path);
+	snprintf(path, sizeof(path), "%s/class", root);
+	rmdir(path);
+	rmdir(root);
+	return rc;
+}
+
+// test the function assign_compute() with a map file
+int test_assign_compute_map() {
+	char path[] = "/tmp/pnetctl_test_assign.XXXXXX";
+	char arg[sizeof(path) + 4];
+	struct assignment *assignments;
+	int count;
+	int rc = -1;
+	FILE *file;
+	int fd;
+
+	fd = mkstemp(path);
+	if (fd == -1)
+		return -1;
+	file = fdopen(fd, "w");
+	if (!file) {
+		close(fd);
+		goto out;
+	}
+	fprintf(file, "# bus-id prefix and pnetid\n"
+		"0000:3b pnet2\n"
+		"0000:3b:00.1 PNET3\n"
+		"\n"
+		"0000:5e PNET4\n");
+	fclose(file);
+	snprintf(arg, sizeof(arg), "map:%s", path);
+
+	/* longest prefix wins and single devices are assigned, too */
+	add_devices();
+	count = compute(arg, &assignments);
+	if (count == 5 &&
+	    !strcmp(find_pnetid(assignments, count, "eth0", -1), "PNET2") &&
+	    !strcmp(find_pnetid(assignments, count, "mlx5_0", 1), "PNET2") &&
+	    !strcmp(find_pnetid(assignments, count, "eth1", -1), "PNET3") &&
+	    !strcmp(find_pnetid(assignments, count, "mlx5_1", 1), "PNET3") &&
+	    !strcmp(find_pnetid(assignments, count, "eth2", -1), "PNET4"))
+		rc = 0;
+	free(assignments);
+	free_devices();
+out:
+	unlink(path);
+	return rc;
+}
+
+// test the function assign_apply()
+int test_assign_apply() {
+	struct assignment assignments[2] = {};
+	int expected;
+	int rc = -1;
+
+	assignments[0].device = test_add_device("net", "lo", -1, NULL, "");
+	strcpy(assignments[0].pnetid, "PNETCTL");
+	assignments[1].device = test_add_device("net", "pnetctl0", -1, NULL,
+						"");
+	strcpy(assignments[1].pnetid, "PNETCTL");
+	nl_init();
+
+	/* adding to lo only fails if smc is not available */
+	expected = nl_family >= 0 ? 0 : -1;
+	if (assign_apply(assignments, 1) != expected)
+		goto out;
+
+	/* adding to a missing net device always fails */
+	if (!assign_apply(&assignments[1], 1))
+		goto out;
+	rc = 0;
+out:
+	nl_del_pnetid("PNETCTL");
+	nl_cleanup();
+	free_devices();
+	return rc;
+}
+
+struct test tests[] = {
+	{"assign_parse_rule", test_assign_parse_rule},
+	{"assign_compute", test_assign_compute},
+	{"assign_compute_port", test_assign_compute_port},
+	{"assign_compute_map", test_assign_compute_map},
+	{"assign_apply", test_assign_apply},
+	{NULL, NULL},
+};
+
+int main(int argc, char** argv) {
+	return run_test(tests, argc, argv);
+}
@@ -0,0 +1,153 @@
+/*
+ * helpers shared by the benchmarks
+ */
+
+#include <errno.h>
+#include <malloc.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "bench.h"
+
+#ifdef __GLIBC__
+/* count allocations and live allocations by replacing malloc(), calloc(),
+ * realloc(), the aligned allocators, and free() with wrappers of the glibc
+ * allocator, libraries and glibc itself also call the wrappers
+ */
+static uint64_t bench_allocs;
+static int64_t bench_live;
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void *__libc_valloc(size_t size);
+extern void *__libc_pvalloc(size_t size);
+extern void __libc_free(void *ptr);
+
+void *malloc(size_t size) {
+	void *ptr = __libc_malloc(size);
+
+	bench_allocs++;
+	bench_live += !!ptr;
+	return ptr;
+}
+
+void *calloc(size_t nmemb, size_t size) {
+	void *ptr = __libc_calloc(nmemb, size);
+
+	bench_allocs++;
+	bench_live += !!ptr;
+	return ptr;
+}
+
+void *realloc(void *ptr, size_t size) {
+	void *new_ptr = __libc_realloc(ptr, size);
+
+	bench_allocs++;
+	if (!ptr && new_ptr)
+		bench_live++;
+	else if (ptr && !size)
+		bench_live--;
+	return new_ptr;
+}
+
+void *memalign(size_t alignment, size_t size) {
+	void *ptr = __libc_memalign(alignment, size);
+
+	bench_allocs++;
+	bench_live += !!ptr;
+	return ptr;
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+	return memalign(alignment, size);
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size) {
+	void *ptr;
+
+	/* alignment must be a power of two multiple of sizeof(void *) */
+	if (alignment % sizeof(void *) || !alignment ||
+	    (alignment & (alignment - 1)))
+		return EINVAL;
+	ptr = memalign(alignment, size);
+	if (!ptr)
+		return ENOMEM;
+	*memptr = ptr;
+	return 0;
+}
+
+void *valloc(size_t size) {
+	void *ptr = __libc_valloc(size);
+
+	bench_allocs++;
+	bench_live += !!ptr;
+	return ptr;
+}
+
+void *pvalloc(size_t size) {
+	void *ptr = __libc_pvalloc(size);
+
+	bench_allocs++;
+	bench_live += !!ptr;
+	return ptr;
+}
+
+void free(void *ptr) {
+	bench_live -= !!ptr;
+	__libc_free(ptr);
+}
+
+/* get the number of allocations since the start */
+int64_t bench_allocations() {
+	return bench_allocs;
+}
+
+/* get the number of allocations that are not freed yet */
+int64_t bench_live_allocations() {
+	return bench_live;
+}
+#else
+/* allocations are not counted without glibc */
+int64_t bench_allocations() {
+	return -1;
+}
+
+int64_t bench_live_allocations() {
+	return -1;
+}
+#endif
+
+/* get the maximum resident set size of the process in kB */
+long bench_maxrss_kb() {
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage))
+		return -1;
+	return usage.ru_maxrss;
+}
+
+/* get the current resident set size of the process in kB */
+long bench_rss_kb() {
+	long pages = -1;
+	FILE *file;
+
+	file = fopen("/proc/self/statm", "r");
+	if (!file)
+		return -1;
+	if (fscanf(file, "%*s %ld", &pages) != 1)
+		pages = -1;
+	fclose(file);
+	return pages < 0 ? -1 : pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/* open file for appending json lines with results, stdout if path is "-" */
+FILE *bench_json_open(const char *path) {
+	if (!path)
+		return NULL;
+	if (path[0] == '-' && !path[1])
+		return stdout;
+	return fopen(path, "a");
+}
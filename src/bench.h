@@ -0,0 +1,13 @@
+#ifndef _PNETCTL_BENCH_H
+#define _PNETCTL_BENCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+int64_t bench_allocations();
+int64_t bench_live_allocations();
+long bench_maxrss_kb();
+long bench_rss_kb();
+FILE *bench_json_open(const char *path);
+
+#endif
@@ -0,0 +1,238 @@
+/*
+ * compare benchmark results with a baseline and fail on regressions
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#define COMPARE_MAX_LINE 1024 /* maximum length of json lines */
+#define COMPARE_MAX_NAME 128 /* maximum length of names in json lines */
+
+/* json lines of a file */
+struct compare_lines {
+	char **lines;
+	int count;
+};
+
+/* read the json lines of file at path, skip empty lines */
+static int compare_read(const char *path, struct compare_lines *lines) {
+	char buffer[COMPARE_MAX_LINE];
+	char **new_lines;
+	FILE *file;
+
+	file = fopen(path, "r");
+	if (!file)
+		return -1;
+	while (fgets(buffer, sizeof(buffer), file)) {
+		buffer[strcspn(buffer, "\n")] = 0;
+		if (!strchr(buffer, '{'))
+			continue;
+		new_lines = realloc(lines->lines, (lines->count + 1) *
+				    sizeof(*lines->lines));
+		if (!new_lines)
+			break;
+		lines->lines = new_lines;
+		lines->lines[lines->count] = strdup(buffer);
+		if (!lines->lines[lines->count])
+			break;
+		lines->count++;
+	}
+	fclose(file);
+	return 0;
+}
+
+/* free the json lines */
+static void compare_free(struct compare_lines *lines) {
+	for (int i = 0; i < lines->count; i++)
+		free(lines->lines[i]);
+	free(lines->lines);
+}
+
+/* find the value of key in the flat json object in line */
+static const char *compare_find(const char *line, const char *key) {
+	size_t len = strlen(key);
+	const char *p = line;
+
+	while ((p = strchr(p, '"'))) {
+		p++;
+		if (strncmp(p, key, len) || p[len] != '"') {
+			/* skip the rest of this string */
+			p = strchr(p, '"');
+			if (!p)
+				return NULL;
+			p++;
+			continue;
+		}
+		p += len + 1;
+		p += strspn(p, " \t");
+		if (*p != ':')
+			continue;
+		p++;
+		return p + strspn(p, " \t");
+	}
+	return NULL;
+}
+
+/* get the string value of key in line */
+static int compare_string(const char *line, const char *key, char *buffer,
+			  size_t len) {
+	const char *value = compare_find(line, key);
+	size_t n;
+
+	if (!value || *value != '"')
+		return -1;
+	value++;
+	n = strcspn(value, "\"");
+	if (value[n] != '"' || n >= len)
+		return -1;
+	memcpy(buffer, value, n);
+	buffer[n] = 0;
+	return 0;
+}
+
+/* get the number value of key in line */
+static int compare_number(const char *line, const char *key, double *number) {
+	const char *value = compare_find(line, key);
+	char *end;
+
+	if (!value)
+		return -1;
+	*number = strtod(value, &end);
+	return end == value ? -1 : 0;
+}
+
+/* find the last result line of benchmark, the results are reset at the
+ * start of each regression run
+ */
+static const char *compare_result(struct compare_lines *results,
+				  const char *benchmark) {
+	char name[COMPARE_MAX_NAME];
+
+	for (int i = results->count - 1; i >= 0; i--)
+		if (!compare_string(results->lines[i], "benchmark", name,
+				    sizeof(name)) && !strcmp(name, benchmark))
+			return results->lines[i];
+	return NULL;
+}
+
+/* check if higher values of metric are better, e.g., ops_per_sec */
+static int compare_higher_is_better(const char *metric) {
+	size_t len = strlen(metric);
+
+	return len > 8 && !strcmp(metric + len - 8, "_per_sec");
+}
+
+/* compare the results with each baseline line like
+ * {"benchmark":"discovery 1000","metric":"ns_per_device","value":2000,
+ * "tolerance":1.5}, a result is a regression if it is worse than the value
+ * by more than the tolerance, e.g., 150%. If update is set, print the
+ * baseline with the values of the results instead.
+ */
+static int compare_run(struct compare_lines *baseline,
+		       struct compare_lines *results, int update) {
+	char benchmark[COMPARE_MAX_NAME];
+	char metric[COMPARE_MAX_NAME];
+	double tolerance;
+	const char *line;
+	int regressions = 0;
+	double result;
+	int regression;
+	double limit;
+	double value;
+	int higher;
+
+	for (int i = 0; i < baseline->count; i++) {
+		if (compare_string(baseline->lines[i], "benchmark", benchmark,
+				   sizeof(benchmark)) ||
+		    compare_string(baseline->lines[i], "metric", metric,
+				   sizeof(metric)) ||
+		    compare_number(baseline->lines[i], "value", &value) ||
+		    compare_number(baseline->lines[i], "tolerance",
+				   &tolerance)) {
+			printf("Invalid baseline line \"%s\".\n",
+			       baseline->lines[i]);
+			return -1;
+		}
+		line = compare_result(results, benchmark);
+		if (!line || compare_number(line, metric, &result)) {
+			printf("%-28s %-20s missing\n", benchmark, metric);
+			regressions++;
+			continue;
+		}
+		if (update) {
+			printf("{\"benchmark\":\"%s\",\"metric\":\"%s\","
+			       "\"value\":%.1f,\"tolerance\":%g}\n", benchmark,
+			       metric, result, tolerance);
+			continue;
+		}
+
+		/* negative results were not measured, e.g., allocations
+		 * without glibc
+		 */
+		if (result < 0) {
+			printf("%-28s %-20s not measured\n", benchmark, metric);
+			continue;
+		}
+		higher = compare_higher_is_better(metric);
+		limit = higher ? value * (1 - tolerance) :
+			value * (1 + tolerance);
+		regression = higher ? result < limit : result > limit;
+		printf("%-28s %-20s %12.1f (baseline %12.1f, limit %12.1f) "
+		       "%s\n", benchmark, metric, result, value, limit,
+		       regression ? "REGRESSION" : "ok");
+		regressions += regression;
+	}
+	return regressions;
+}
+
+int main(int argc, char **argv) {
+	struct compare_lines baseline = {};
+	struct compare_lines results = {};
+	int update = 0;
+	FILE *file;
+	int rc;
+
+	/* remove the results of previous runs, so a benchmark that did not
+	 * run in this run is missing instead of passing with old results
+	 */
+	if (argc == 3 && !strcmp(argv[1], "-r")) {
+		file = fopen(argv[2], "w");
+		if (!file) {
+			printf("Cannot reset results \"%s\".\n", argv[2]);
+			return EXIT_FAILURE;
+		}
+		fclose(file);
+		return EXIT_SUCCESS;
+	}
+	if (argc > 1 && !strcmp(argv[1], "-u")) {
+		update = 1;
+		argv++;
+		argc--;
+	}
+	if (argc < 3) {
+		printf("Usage: %s [-u] <baseline> <results>\n"
+		       "       %s -r <results>\n"
+		       "-u	Print the baseline with the latest results\n"
+		       "-r	Remove the results of previous runs\n",
+		       argv[0], argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (compare_read(argv[1], &baseline)) {
+		printf("Cannot read baseline \"%s\".\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	if (compare_read(argv[2], &results)) {
+		printf("Cannot read results \"%s\".\n", argv[2]);
+		compare_free(&baseline);
+		return EXIT_FAILURE;
+	}
+	rc = compare_run(&baseline, &results, update);
+	compare_free(&baseline);
+	compare_free(&results);
+	if (rc > 0)
+		printf("%d regressions or missing results.\n", rc);
+	return rc ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,197 @@
+/*
+ * ******************
+ * *** CACHE PART ***
+ * ******************
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cache.h"
+#include "devices.h"
+#include "sysfs.h"
+#include "verbose.h"
+
+/* mapped cache file of the loaded devices */
+static struct cache_header *cache_header;
+static size_t cache_size;
+
+/* uevent sequence number, network namespace, and boot id read before the
+ * device scan
+ */
+static uint64_t cache_seqnum;
+static uint64_t cache_netns;
+static char cache_boot_id[CACHE_BOOT_ID_LEN];
+static int cache_state_valid;
+
+/* read the first line of a small file into buffer */
+static int cache_read_line(const char *path, char *buffer, size_t len) {
+	ssize_t count;
+	int fd;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return -1;
+	count = read(fd, buffer, len - 1);
+	close(fd);
+	if (count <= 0)
+		return -1;
+	buffer[count] = 0;
+	buffer[strcspn(buffer, "\r\n")] = 0;
+	return 0;
+}
+
+/* read the current uevent sequence number, network namespace, and boot id */
+static int cache_read_state() {
+	char path[strlen(sysfs_root) + strlen(CACHE_SEQNUM_FILE) + 1];
+	char seqnum[32];
+	struct stat st;
+
+	cache_state_valid = 0;
+	snprintf(path, sizeof(path), "%s%s", sysfs_root, CACHE_SEQNUM_FILE);
+	if (stat(CACHE_NETNS_FILE, &st) ||
+	    cache_read_line(path, seqnum, sizeof(seqnum)) ||
+	    cache_read_line(CACHE_BOOT_ID_FILE, cache_boot_id,
+			    sizeof(cache_boot_id)))
+		return -1;
+	cache_seqnum = strtoull(seqnum, NULL, 10);
+	cache_netns = st.st_ino;
+	cache_state_valid = 1;
+	return 0;
+}
+
+/* load devices from the cache at path if no uevent happened since it was
+ * written in the current network namespace, the device strings point into
+ * the mapped cache until cache_unload() is called
+ */
+int cache_load(const char *path) {
+	struct cache_header *header;
+	struct device *device;
+	struct stat st;
+	size_t size;
+	int fd;
+
+	if (cache_read_state())
+		return -1;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return -1;
+	if (fstat(fd, &st) || st.st_size < sizeof(*header)) {
+		close(fd);
+		return -1;
+	}
+	size = st.st_size;
+	header = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (header == MAP_FAILED)
+		return -1;
+
+	/* check the layout and if the devices changed */
+	if (header->magic != CACHE_MAGIC ||
+	    header->version != CACHE_VERSION ||
+	    header->header_size != sizeof(*header) ||
+	    header->record_size != sizeof(struct device_record) ||
+	    size < header->header_size +
+	    (size_t) header->count * header->record_size) {
+		log_error("Invalid cache \"%s\".\n", path);
+		munmap(header, size);
+		return -1;
+	}
+	header->boot_id[CACHE_BOOT_ID_LEN - 1] = 0;
+	if (header->seqnum != cache_seqnum ||
+	    header->netns != cache_netns ||
+	    strcmp(header->boot_id, cache_boot_id)) {
+		log_info("Cache \"%s\" is outdated.\n", path);
+		munmap(header, size);
+		return -1;
+	}
+
+	cache_header = header;
+	cache_size = size;
+	add_device_records((struct device_record *) (header + 1),
+			   header->count);
+	device = get_next_device(&devices_list);
+	for (; device; device = get_next_device(device))
+		memcpy(device->util_pnetid, device->pnetid,
+		       sizeof(device->util_pnetid));
+	log_info("Loaded %u devices from cache \"%s\".\n", header->count,
+		 path);
+	return 0;
+}
+
+/* save the scanned devices in the cache at path */
+int cache_save(const char *path) {
+	struct device_record *records;
+	struct cache_header header;
+	char tmp_path[strlen(path) + 5];
+	struct device *device;
+	uint32_t count = 0;
+	size_t size;
+	int rc = -1;
+	int fd;
+
+	/* the state before the scan is needed to detect changes later */
+	if (!cache_state_valid)
+		return -1;
+
+	device = get_next_device(&devices_list);
+	for (; device; device = get_next_device(device))
+		count++;
+	records = calloc(count ? count : 1, sizeof(*records));
+	if (!records)
+		return -1;
+	device = get_next_device(&devices_list);
+	for (uint32_t i = 0; i < count; i++) {
+		device_to_record(device, &records[i]);
+		memcpy(records[i].pnetid, device->util_pnetid,
+		       sizeof(records[i].pnetid));
+		device = get_next_device(device);
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.magic = CACHE_MAGIC;
+	header.version = CACHE_VERSION;
+	header.header_size = sizeof(header);
+	header.record_size = sizeof(*records);
+	header.count = count;
+	header.seqnum = cache_seqnum;
+	header.netns = cache_netns;
+	memcpy(header.boot_id, cache_boot_id, sizeof(header.boot_id));
+
+	/* write to temporary file and move it to path */
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd == -1)
+		goto out;
+	size = count * sizeof(*records);
+	if (write(fd, &header, sizeof(header)) != sizeof(header) ||
+	    write(fd, records, size) != size) {
+		close(fd);
+		unlink(tmp_path);
+		goto out;
+	}
+	close(fd);
+	if (rename(tmp_path, path)) {
+		unlink(tmp_path);
+		goto out;
+	}
+	log_debug("Saved %u devices in cache \"%s\".\n", count, path);
+	rc = 0;
+out:
+	free(records);
+	return rc;
+}
+
+/* unmap the loaded cache, call after free_devices() */
+void cache_unload() {
+	if (!cache_header)
+		return;
+	munmap(cache_header, cache_size);
+	cache_header = NULL;
+}
@@ -0,0 +1,35 @@
+#ifndef _PNETCTL_CACHE_H
+#define _PNETCTL_CACHE_H
+
+#include <stdint.h>
+
+#define CACHE_PATH "/run/pnetctl.cache" /* default cache path */
+#define CACHE_MAGIC 0x41434e50 /* "PNCA" */
+#define CACHE_VERSION 2 /* layout version */
+#define CACHE_BOOT_ID_LEN 40 /* length of boot id including terminator */
+#define CACHE_SEQNUM_FILE "/kernel/uevent_seqnum" /* in sysfs */
+#define CACHE_BOOT_ID_FILE "/proc/sys/kernel/random/boot_id"
+#define CACHE_NETNS_FILE "/proc/self/ns/net"
+
+/* header at the start of the cache file, followed by count device records.
+ * The pnetids in the records are the ones read from util_strings. The cache
+ * is only valid if no uevent happened since it was written in the same boot
+ * and network namespace, which is identified by the inode of its ns file.
+ */
+struct cache_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t header_size;
+	uint32_t record_size;
+	uint32_t count;
+	uint32_t reserved;
+	uint64_t seqnum;
+	uint64_t netns;
+	char boot_id[CACHE_BOOT_ID_LEN];
+};
+
+int cache_load(const char *path);
+int cache_save(const char *path);
+void cache_unload();
+
+#endif
@@ -0,0 +1,131 @@
+/*
+ * test for cache
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "test.h"
+#include "cache.h"
+#include "devices.h"
+#include "fixture.h"
+#include "sysfs.h"
+
+/* count devices and devices with util string pnetids in devices list */
+static int count_devices(int *pnetids) {
+	struct device *device = get_next_device(&devices_list);
+	int count = 0;
+
+	*pnetids = 0;
+	for (; device; device = get_next_device(device)) {
+		count++;
+		if (device->util_pnetid[0] &&
+		    !strcmp(device->pnetid, device->util_pnetid))
+			(*pnetids)++;
+	}
+	return count;
+}
+
+/* set uevent sequence number in fixture at root */
+static int set_seqnum(const char *root, const char *seqnum) {
+	char path[strlen(root) + strlen(CACHE_SEQNUM_FILE) + 1];
+	int rc;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s%s", root, CACHE_SEQNUM_FILE);
+	fd = open(path, O_WRONLY | O_TRUNC);
+	if (fd == -1)
+		return -1;
+	rc = write(fd, seqnum, strlen(seqnum)) == strlen(seqnum) ? 0 : -1;
+	close(fd);
+	return rc;
+}
+
+/* set network namespace in the header of the cache at path */
+static int set_netns(const char *path, uint64_t netns) {
+	struct cache_header header;
+	int rc = -1;
+	int fd;
+
+	fd = open(path, O_RDWR);
+	if (fd == -1)
+		return -1;
+	if (pread(fd, &header, sizeof(header), 0) == sizeof(header)) {
+		header.netns = netns;
+		if (pwrite(fd, &header, sizeof(header), 0) == sizeof(header))
+			rc = 0;
+	}
+	close(fd);
+	return rc;
+}
+
+// test the functions cache_save(), cache_load(), and cache_unload()
+int test_cache_load() {
+	struct fixture_config config;
+	char root[] = "/tmp/pnetctl_test_cache.XXXXXX";
+	char path[sizeof(root) + 6];
+	int scanned_pnetids;
+	int scanned;
+	int pnetids;
+	int rc = -1;
+
+	if (!mkdtemp(root))
+		return -1;
+	snprintf(path, sizeof(path), "%s.cache", root);
+	fixture_config_for_size(&config, 100);
+	if (fixture_create(root, &config))
+		goto out;
+	sysfs_root = root;
+
+	/* no cache yet, scan devices and save them */
+	if (!cache_load(path) || sysfs_scan_devices() || cache_save(path))
+		goto out;
+	scanned = count_devices(&scanned_pnetids);
+	free_devices();
+
+	/* unchanged devices, load them from cache */
+	if (cache_load(path) ||
+	    count_devices(&pnetids) != scanned || pnetids != scanned_pnetids) {
+		printf("Cache does not match scanned devices.\n");
+		goto out;
+	}
+	free_devices();
+	cache_unload();
+
+	/* other network namespace, cache is not used */
+	if (set_netns(path, 0) || !cache_load(path)) {
+		printf("Cache of other network namespace was loaded.\n");
+		goto out;
+	}
+	if (sysfs_scan_devices() || cache_save(path))
+		goto out;
+	free_devices();
+
+	/* changed devices, cache is outdated */
+	if (set_seqnum(root, "2\n") || !cache_load(path)) {
+		printf("Outdated cache was loaded.\n");
+		goto out;
+	}
+	rc = 0;
+out:
+	free_devices();
+	cache_unload();
+	sysfs_root = SYSFS_ROOT;
+	fixture_remove(root);
+	unlink(path);
+	return rc;
+}
+
+struct test tests[] = {
+	{"cache_load", test_cache_load},
+	{NULL, NULL},
+};
+
+int main(int argc, char** argv) {
+	return run_test(tests, argc, argv);
+}
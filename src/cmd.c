@@ -1,19 +1,102 @@
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <getopt.h>
 #include <stdio.h>
 
 #include "netlink.h"
 #include "devices.h"
 #include "udev.h"
+#include "sysfs.h"
 #include "verbose.h"
 #include "print.h"
+#include "stats.h"
+#include "trace.h"
+#include "daemon.h"
+#include "shmtable.h"
+#include "cache.h"
+#include "netns.h"
+#include "pairing.h"
+#include "assign.h"
+#include "select.h"
+#include "locality.h"
+#include "filter.h"
+#include "export.h"
 
 /* pnetid filter when printing the device table */
-const char *pnetid_filter = NULL;
+const char *pnetid_filters[MAX_PNETID_FILTERS];
+int num_pnetid_filters;
 
-/* verbose output, disabled by default */
-int verbose_mode = 0;
+/* log level, only errors by default */
+int log_level = LOG_LEVEL_ERROR;
+
+/* statistics mode, disabled by default */
+int stats_mode = STATS_MODE_OFF;
+
+/* use the daemon if it is running, enabled by default */
+int use_daemon = 1;
+
+/* read devices from this published table instead of scanning, if set */
+const char *shmtable_path = NULL;
+
+/* cache scanned devices in this file, if set */
+const char *cache_path = NULL;
+
+/* print pairs instead of the device table, disabled by default */
+int pairs_mode = 0;
+
+/* only print pairs of this net device, if set */
+const char *pairs_device = NULL;
+
+/* read and print locality of devices, disabled by default */
+int locality_mode = 0;
+
+/* only print devices matching this filter, if set */
+struct filter *device_filter = NULL;
+
+/* command line options without short option */
+enum long_only_options {
+	OPT_SOCKET = 256,
+	OPT_NO_DAEMON,
+	OPT_PUBLISH,
+	OPT_SHM,
+	OPT_SYSFS_ROOT,
+	OPT_CACHE,
+	OPT_AUTO_ASSIGN,
+	OPT_DRY_RUN,
+	OPT_PNET_TABLE,
+	OPT_REGEX,
+	OPT_BUS_ID,
+	OPT_PARENT,
+	OPT_LOCALITY,
+	OPT_FILTER,
+	OPT_EXPORT,
+};
+
+/* long command line options */
+static struct option long_options[] = {
+	{"stats", optional_argument, NULL, 's'},
+	{"trace", required_argument, NULL, 't'},
+	{"daemon", no_argument, NULL, 'D'},
+	{"all-namespaces", no_argument, NULL, 'A'},
+	{"pairs", optional_argument, NULL, 'P'},
+	{"socket", required_argument, NULL, OPT_SOCKET},
+	{"no-daemon", no_argument, NULL, OPT_NO_DAEMON},
+	{"publish", optional_argument, NULL, OPT_PUBLISH},
+	{"shm", optional_argument, NULL, OPT_SHM},
+	{"sysfs-root", required_argument, NULL, OPT_SYSFS_ROOT},
+	{"cache", optional_argument, NULL, OPT_CACHE},
+	{"auto-assign", required_argument, NULL, OPT_AUTO_ASSIGN},
+	{"dry-run", no_argument, NULL, OPT_DRY_RUN},
+	{"pnet-table", no_argument, NULL, OPT_PNET_TABLE},
+	{"regex", no_argument, NULL, OPT_REGEX},
+	{"bus-id", required_argument, NULL, OPT_BUS_ID},
+	{"parent", required_argument, NULL, OPT_PARENT},
+	{"locality", no_argument, NULL, OPT_LOCALITY},
+	{"filter", required_argument, NULL, OPT_FILTER},
+	{"export", optional_argument, NULL, OPT_EXPORT},
+	{NULL, 0, NULL, 0},
+};
 
 /* print usage */
 void print_usage() {
@@ -27,84 +110,478 @@ void print_usage() {
 	       "Options:\n"
 	       "------------------------------------------------------------\n"
 	       "-a <pnetid>		Add pnetid. Requires -n or -i\n"
+	       "			or selectors below\n"
 	       "-r <pnetid>		Remove pnetid\n"
-	       "-g <pnetid>		Get devices with pnetid\n"
+	       "-g <pnetid>		Get devices with pnetid, repeat for\n"
+	       "			more pnetids\n"
 	       "-f			Flush pnetids\n"
-	       "-n <name>		Specify net device\n"
-	       "-i <name>		Specify infiniband or ism device\n"
+	       "-n <name>		Specify net device, get its pnetid\n"
+	       "			without other command. With -a,\n"
+	       "			name can be a glob pattern\n"
+	       "-i <name>		Specify infiniband or ism device, get\n"
+	       "			its pnetid without other command.\n"
+	       "			With -a, name can be a glob pattern\n"
 	       "-p <port>		Specify infiniband port\n"
 	       "			(default: %d)\n"
-	       "-v			Print verbose output\n"
+	       "-v			Print verbose output, repeat for more\n"
+	       "			details (-vv debug, -vvv trace)\n"
+	       "-s, --stats[=json]	Print statistics to stderr at exit\n"
+	       "-t, --trace <file>	Write chrome trace events to file\n"
+	       "-D, --daemon		Run as daemon serving devices and\n"
+	       "			pnetids on a unix socket\n"
+	       "--socket <path>		Specify daemon socket\n"
+	       "			(default: %s)\n"
+	       "--no-daemon		Do not use a running daemon\n"
+	       "-A, --all-namespaces	Get or flush pnetids in the current\n"
+	       "			and all named network namespaces\n"
+	       "-P, --pairs[=<name>]	Print usable SMC pairs of net device\n"
+	       "			name or all net devices\n"
+	       "--publish[=<path>]	Publish devices and pnetids of the\n"
+	       "			daemon in a mapped table\n"
+	       "			(default: %s)\n"
+	       "--shm[=<path>]		Print devices and pnetids from a\n"
+	       "			published table\n"
+	       "--sysfs-root <dir>	Scan devices in sysfs mounted at\n"
+	       "			dir without udev and daemon\n"
+	       "--cache[=<path>]	Cache scanned devices until devices\n"
+	       "			change (default: %s)\n"
+	       "--auto-assign <rule>	Add pnetids to devices without pnetid\n"
+	       "			grouped by rule: function, port,\n"
+	       "			slot, or map:<file> with lines\n"
+	       "			\"<bus-id prefix> <pnetid>\"\n"
+	       "--dry-run		Only print the pnetids --auto-assign\n"
+	       "			would add\n"
+	       "--pnet-table		Only print the pnetid table of SMC\n"
+	       "			without devices, combine with -g\n"
+	       "			to get specific pnetids\n"
+	       "--regex			With -a, -n and -i names are\n"
+	       "			extended regular expressions\n"
+	       "--bus-id <prefix>	With -a, select devices with bus-id\n"
+	       "			prefix\n"
+	       "--parent <bus-id>	With -a, select devices on parent\n"
+	       "			device or its virtual functions\n"
+	       "--locality		Print numa node, local cpus, and pci\n"
+	       "			path of devices and the locality\n"
+	       "			score of pnetids and pairs\n"
+	       "--filter <expr>		Only print devices matching expr like\n"
+	       "			\"pnetid in {A,B} and type=ib or\n"
+	       "			not name~^eth\" with fields pnetid,\n"
+	       "			name, type, bus, parent, and port\n"
+	       "--export[=<path>]	Export pnetid metrics of the daemon\n"
+	       "			in prometheus text format\n"
+	       "			(default: %s)\n"
 	       "-h			Print this help\n",
-	       IB_DEFAULT_PORT
-	       );
+	       IB_DEFAULT_PORT, DAEMON_SOCKET_PATH, SHMTABLE_PATH, CACHE_PATH,
+	       EXPORT_PATH);
+}
+
+/* try to run a command via the daemon, returns the number of devices in
+ * the response or -1 if the daemon is not available
+ */
+int run_daemon_command(int cmd, const char *pnetid, const char *net_device,
+		       const char *ib_device, int ib_port,
+		       struct device_record **records) {
+	struct daemon_request request = {};
+
+	*records = NULL;
+	if (!use_daemon)
+		return -1;
+
+	request.cmd = cmd;
+	request.ib_port = ib_port;
+	if (pnetid)
+		strncpy(request.pnetid, pnetid, SMC_MAX_PNETID_LEN);
+	if (net_device)
+		strncpy(request.net_device, net_device, DEVICE_NAME_LEN - 1);
+	if (ib_device)
+		strncpy(request.ib_device, ib_device, DEVICE_NAME_LEN - 1);
+	return daemon_query(&request, records);
 }
 
 /* run the "flush" command to remove all pnetid entries */
 int run_flush_command() {
+	struct device_record *records;
+	int rc;
+
+	/* remove entries via daemon if it is running */
+	rc = run_daemon_command(DAEMON_CMD_FLUSH, NULL, NULL, NULL, -1,
+				&records);
+	if (rc != -1)
+		return rc < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+
 	/* remove entries via netlink */
 	nl_init();
-	nl_flush_pnetids();
+	rc = nl_flush_pnetids();
 	nl_cleanup();
-	return EXIT_SUCCESS;
+	return rc ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
 /* run the "remove"/"del" command to remove a pnetid entry */
 int run_del_command(const char *pnetid) {
+	struct device_record *records;
+	int rc;
+
+	/* remove entry via daemon if it is running */
+	rc = run_daemon_command(DAEMON_CMD_DEL, pnetid, NULL, NULL, -1,
+				&records);
+	if (rc != -1)
+		return rc < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+
 	/* remove entry via netlink */
 	nl_init();
-	nl_del_pnetid(pnetid);
+	rc = nl_del_pnetid(pnetid);
 	nl_cleanup();
-	return EXIT_SUCCESS;
+	return rc ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
 /* run the "add" command to add a pnetid entry */
 int run_add_command(const char *pnetid, const char *net_device,
 		    const char *ib_device, int ib_port) {
+	struct device_record *records;
+	int rc;
+
 	/* at least one device must be present */
 	if (!ib_device && !net_device) {
-		verbose("Missing ib or net device.\n");
+		log_error("Missing ib or net device.\n");
 		print_usage();
 		return EXIT_FAILURE;
 	}
 
+	/* add entry via daemon if it is running */
+	rc = run_daemon_command(DAEMON_CMD_ADD, pnetid, net_device, ib_device,
+				ib_port, &records);
+	if (rc != -1)
+		return rc < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+
 	/* add entry via netlink */
 	nl_init();
-	nl_set_pnetid(pnetid, net_device, ib_device, ib_port);
+	rc = nl_set_pnetid(pnetid, net_device, ib_device, ib_port);
 	nl_cleanup();
-	return EXIT_SUCCESS;
+	return rc ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
-/* run the "get" command to get devices and pnetids */
-int run_get_command() {
+/* run the "add" command for all devices matching selectors, the pnetids are
+ * added in one netlink session
+ */
+int run_bulk_add_command(const char *pnetid, struct selector *selectors,
+			 int num_selectors, int ib_port) {
+	struct nl_pnetid *entries = NULL;
+	struct device **devices = NULL;
+	struct device *device;
+	int *results = NULL;
+	int count;
 	int rc;
 
-	/* get all devices via udev and put them in devices list */
-	verbose("Trying to find devices and read their pnetids from "
-		"util_strings.\n");
-	rc = udev_scan_devices();
+	/* get all devices and match them once */
+	if (strcmp(sysfs_root, SYSFS_ROOT))
+		rc = sysfs_scan_devices();
+	else
+		rc = udev_scan_devices();
 	if (rc)
 		return rc;
+	count = select_devices(selectors, num_selectors, ib_port, &devices);
+	if (count <= 0) {
+		log_error("No matching devices found.\n");
+		rc = EXIT_FAILURE;
+		goto out;
+	}
+	entries = calloc(count, sizeof(*entries));
+	results = calloc(count, sizeof(*results));
+	if (!entries || !results) {
+		rc = EXIT_FAILURE;
+		goto out;
+	}
+	for (int i = 0; i < count; i++) {
+		device = devices[i];
+		entries[i].pnetid = pnetid;
+		entries[i].ib_port = -1;
+		if (device->kind == DEVICE_KIND_NET) {
+			entries[i].eth_name = device->name;
+		} else {
+			entries[i].ib_name = device->name;
+			if (device->kind == DEVICE_KIND_IB)
+				entries[i].ib_port = device->ib_port;
+		}
+	}
+
+	/* add pnetid to all devices and report the result of each device */
+	log_info("Adding pnetid \"%s\" to %d devices.\n", pnetid, count);
+	nl_init();
+	nl_set_pnetids(entries, count, results);
+	nl_cleanup();
+	print_add_results(pnetid, devices, results, count);
+	for (int i = 0; i < count; i++)
+		if (results[i])
+			rc = EXIT_FAILURE;
+out:
+	free(results);
+	free(entries);
+	free(devices);
+	free_devices();
+	return rc;
+}
+
+/* run the "auto-assign" command to add pnetids to groups of devices */
+int run_assign_command(const char *rule_arg, int dry_run) {
+	struct assignment *assignments;
+	struct assign_rule rule;
+	int count;
+	int rc;
+
+	if (assign_parse_rule(rule_arg, &rule))
+		return EXIT_FAILURE;
+
+	/* get all devices and their current pnetids */
+	if (strcmp(sysfs_root, SYSFS_ROOT))
+		rc = sysfs_scan_devices();
+	else
+		rc = udev_scan_devices();
+	if (rc) {
+		assign_free_rule(&rule);
+		return rc;
+	}
+	nl_init();
+	nl_get_pnetids();
 
-	/* try to receive pnetids via netlink */
-	verbose("Trying to read pnetids via netlink.\n");
+	/* compute all assignments and add them in the same netlink session */
+	count = assign_compute(&rule, &assignments);
+	if (count < 0) {
+		log_error("Cannot compute pnetid assignments.\n");
+		rc = EXIT_FAILURE;
+	} else if (dry_run) {
+		assign_print(assignments, count);
+	} else if (assign_apply(assignments, count)) {
+		rc = EXIT_FAILURE;
+	}
+	nl_cleanup();
+	free(assignments);
+	free_devices();
+	assign_free_rule(&rule);
+	return rc;
+}
+
+/* run the "query" command to get the pnetid of a single device */
+int run_query_command(const char *net_device, const char *ib_device,
+		      int ib_port) {
+	struct device_record *records = NULL;
+	const char *name;
+	int kind;
+	int count;
+	int rc;
+
+	/* get device from daemon if it is running */
+	name = net_device ? net_device : ib_device;
+	count = run_daemon_command(DAEMON_CMD_GET_DEVICE, NULL, net_device,
+				   ib_device, ib_port, &records);
+	if (count >= 0) {
+		log_info("Got %d devices from daemon.\n", count);
+		add_device_records(records, count);
+		goto print;
+	}
+
+	/* only look up the device, do not scan all devices */
+	kind = net_device ? DEVICE_KIND_NET : DEVICE_KIND_IB;
+	if (strcmp(sysfs_root, SYSFS_ROOT))
+		rc = sysfs_scan_device(kind, name, ib_port);
+	else
+		rc = udev_scan_device(kind, name, ib_port);
+	if (rc || !get_next_device(&devices_list)) {
+		log_error("Device \"%s\" not found.\n", name);
+		free_devices();
+		return EXIT_FAILURE;
+	}
+
+	/* check the device against the pnetid table */
 	nl_init();
 	nl_get_pnetids();
 	nl_cleanup();
 
-	/* print devices to the screen, cleanup, and exit */
-	verbose("Printing device table.\n");
+print:
+	/* remove the device if it does not match the filter */
+	if (device_filter)
+		filter_devices(device_filter);
+
+	/* read locality of the device if requested */
+	if (locality_mode)
+		locality_read_devices();
+	stats_start(STATS_PHASE_PRINT);
+	trace_begin(print, name, 0);
 	print_device_table();
+	trace_end(print, name, 0);
+	stats_stop(STATS_PHASE_PRINT);
+	rc = get_next_device(&devices_list) ? EXIT_SUCCESS : EXIT_FAILURE;
 	free_devices();
+	free(records);
+	return rc;
+}
+
+/* run the "pnet table" command to print the pnetid table of the kernel
+ * without looking up devices
+ */
+int run_pnet_table_command() {
+	/* print each entry while it is parsed */
+	nl_init();
+	print_pnet_header();
+	nl_pnetid_handler = print_pnet_entry;
+	if (num_pnetid_filters)
+		nl_get_pnetids_by_name(pnetid_filters, num_pnetid_filters);
+	else
+		nl_get_pnetids();
+	nl_pnetid_handler = NULL;
+	nl_cleanup();
 	return EXIT_SUCCESS;
 }
 
+/* read devices and pnetids from the published table */
+int read_shmtable(struct device_record **records) {
+	struct shmtable *table;
+	int count;
+
+	table = shmtable_map(shmtable_path);
+	if (!table) {
+		log_error("Cannot map table \"%s\".\n", shmtable_path);
+		return -1;
+	}
+	count = shmtable_snapshot(table, records);
+	shmtable_unmap(table);
+	if (count < 0) {
+		log_error("Cannot read table \"%s\".\n", shmtable_path);
+		return -1;
+	}
+	add_device_records(*records, count);
+	return count;
+}
+
+/* run the "get" command to get devices and pnetids */
+int run_get_command() {
+	struct device_record *records = NULL;
+	int rc = EXIT_SUCCESS;
+	int count;
+
+	/* get devices and pnetids from published table if requested */
+	if (shmtable_path) {
+		count = read_shmtable(&records);
+		if (count < 0)
+			return EXIT_FAILURE;
+		log_info("Got %d devices from table.\n", count);
+		goto print;
+	}
+
+	/* get all devices from an alternative sysfs root if requested */
+	if (strcmp(sysfs_root, SYSFS_ROOT)) {
+		discovery_filter = device_filter;
+		rc = sysfs_scan_devices();
+		discovery_filter = NULL;
+		if (rc)
+			return rc;
+		goto netlink;
+	}
+
+	/* get devices and pnetids from daemon if it is running */
+	count = run_daemon_command(num_pnetid_filters == 1 ?
+				   DAEMON_CMD_GET_PNETID : DAEMON_CMD_LIST,
+				   pnetid_filters[0], NULL, NULL, -1, &records);
+	if (count >= 0) {
+		log_info("Got %d devices from daemon.\n", count);
+		add_device_records(records, count);
+		goto print;
+	}
+
+	/* get all devices from cache or via udev and put them in devices
+	 * list
+	 */
+	if (!cache_path || cache_load(cache_path)) {
+		log_info("Trying to find devices and read their pnetids from "
+			"util_strings.\n");
+		if (!cache_path)
+			discovery_filter = device_filter;
+		rc = udev_scan_devices();
+		discovery_filter = NULL;
+		if (rc)
+			return rc;
+		if (cache_path && cache_save(cache_path))
+			log_info("Cannot save cache \"%s\".\n", cache_path);
+	}
+
+netlink:
+	/* try to receive pnetids via netlink */
+	log_info("Trying to read pnetids via netlink.\n");
+	nl_init();
+	if (num_pnetid_filters)
+		nl_get_pnetids_by_name(pnetid_filters, num_pnetid_filters);
+	else
+		nl_get_pnetids();
+	nl_cleanup();
+
+print:
+	/* remove devices not matching the filter in one pass */
+	if (device_filter)
+		filter_devices(device_filter);
+
+	/* read locality of the devices if requested */
+	if (locality_mode)
+		locality_read_devices();
+
+	/* print devices or pairs to the screen, cleanup, and exit */
+	stats_start(STATS_PHASE_PRINT);
+	trace_begin(print, pnetid_filters[0], 0);
+	if (pairs_mode) {
+		log_info("Printing pairs.\n");
+		if (pairing_print_devices(pairs_device))
+			rc = EXIT_FAILURE;
+	} else {
+		log_info("Printing device table.\n");
+		print_device_table();
+	}
+	trace_end(print, pnetid_filters[0], 0);
+	stats_stop(STATS_PHASE_PRINT);
+	free_devices();
+	cache_unload();
+	free(records);
+	return rc;
+}
+
+/* run the "add" command with device name patterns of net_device and
+ * ib_device and the other selectors
+ */
+int run_select_add_command(const char *pnetid, const char *net_device,
+			   const char *ib_device, int regex,
+			   struct selector *selectors, int num_selectors,
+			   int ib_port) {
+	int type = regex ? SELECT_TYPE_REGEX : SELECT_TYPE_GLOB;
+	int rc = EXIT_FAILURE;
+
+	if (net_device && select_init(&selectors[num_selectors++], type,
+				      DEVICE_KIND_NET, net_device))
+		goto out;
+	if (ib_device && select_init(&selectors[num_selectors++], type,
+				     DEVICE_KIND_IB, ib_device))
+		goto out;
+	if (!num_selectors) {
+		log_error("Missing ib or net device.\n");
+		goto out;
+	}
+	rc = run_bulk_add_command(pnetid, selectors, num_selectors, ib_port);
+out:
+	for (int i = 0; i < num_selectors; i++)
+		select_free(&selectors[i]);
+	return rc;
+}
+
 /* parse command line arguments and call other functions */
 int parse_cmd_line(int argc, char **argv) {
+	struct selector selectors[MAX_SELECTORS];
+	char *assign_rule = NULL;
 	char *net_device = NULL;
 	char *ib_device = NULL;
 	char *pnetid = NULL;
 	char ib_port = -1;
+	int all_netns = 0;
+	int num_selectors = 0;
+	int pnet_table = 0;
+	int dry_run = 0;
+	int regex = 0;
+	int daemon = 0;
 	int remove = 0;
 	int flush = 0;
 	int add = 0;
@@ -112,12 +589,29 @@ int parse_cmd_line(int argc, char **argv) {
 	int c;
 
 	/* reset global variables */
-	pnetid_filter = NULL;
-	verbose_mode = 0;
+	pnetid_filters[0] = NULL;
+	num_pnetid_filters = 0;
+	log_level = LOG_LEVEL_ERROR;
+	stats_mode = STATS_MODE_OFF;
+	stats_reset();
+	trace_close();
+	daemon_socket_path = DAEMON_SOCKET_PATH;
+	use_daemon = 1;
+	daemon_publish_path = NULL;
+	daemon_export_path = NULL;
+	shmtable_path = NULL;
+	sysfs_root = SYSFS_ROOT;
+	cache_path = NULL;
+	pairs_mode = 0;
+	pairs_device = NULL;
+	locality_mode = 0;
+	filter_free(device_filter);
+	device_filter = NULL;
 
 	/* try to get all arguments */
 	optind = 1;
-	while ((c = getopt (argc, argv, "a:fhi:n:p:r:g:v")) != -1) {
+	while ((c = getopt_long(argc, argv, "a:ADfhi:n:p:P::r:g:s::t:v",
+				long_options, NULL)) != -1) {
 		switch (c) {
 		case 'a':
 			add = 1;
@@ -131,8 +625,13 @@ int parse_cmd_line(int argc, char **argv) {
 			pnetid = optarg;
 			break;
 		case 'g':
+			if (num_pnetid_filters == MAX_PNETID_FILTERS) {
+				log_error("Too many pnetids.\n");
+				goto fail;
+			}
 			get = 1;
 			pnetid = optarg;
+			pnetid_filters[num_pnetid_filters++] = optarg;
 			break;
 		case 'n':
 			net_device = optarg;
@@ -144,7 +643,86 @@ int parse_cmd_line(int argc, char **argv) {
 			ib_port = atoi(optarg);
 			break;
 		case 'v':
-			verbose_mode = 1;
+			if (log_level < LOG_LEVEL_TRACE)
+				log_level++;
+			break;
+		case 's':
+			if (optarg && strcmp(optarg, "json"))
+				goto fail;
+			stats_mode = optarg ? STATS_MODE_JSON : STATS_MODE_TEXT;
+			break;
+		case 't':
+			if (trace_open(optarg)) {
+				log_error("Cannot open trace file \"%s\".\n",
+					  optarg);
+				goto fail;
+			}
+			break;
+		case 'D':
+			daemon = 1;
+			break;
+		case 'A':
+			all_netns = 1;
+			break;
+		case 'P':
+			pairs_mode = 1;
+			pairs_device = optarg;
+			break;
+		case OPT_SOCKET:
+			daemon_socket_path = optarg;
+			break;
+		case OPT_NO_DAEMON:
+			use_daemon = 0;
+			break;
+		case OPT_PUBLISH:
+			daemon_publish_path = optarg ? optarg : SHMTABLE_PATH;
+			break;
+		case OPT_EXPORT:
+			daemon_export_path = optarg ? optarg : EXPORT_PATH;
+			break;
+		case OPT_SHM:
+			shmtable_path = optarg ? optarg : SHMTABLE_PATH;
+			break;
+		case OPT_SYSFS_ROOT:
+			sysfs_root = optarg;
+			break;
+		case OPT_CACHE:
+			cache_path = optarg ? optarg : CACHE_PATH;
+			break;
+		case OPT_AUTO_ASSIGN:
+			assign_rule = optarg;
+			break;
+		case OPT_DRY_RUN:
+			dry_run = 1;
+			break;
+		case OPT_PNET_TABLE:
+			pnet_table = 1;
+			break;
+		case OPT_LOCALITY:
+			locality_mode = 1;
+			break;
+		case OPT_FILTER:
+			filter_free(device_filter);
+			device_filter = filter_compile(optarg);
+			if (!device_filter)
+				goto fail;
+			break;
+		case OPT_REGEX:
+			regex = 1;
+			break;
+		case OPT_BUS_ID:
+		case OPT_PARENT:
+			/* leave room for the selectors of -n and -i */
+			if (num_selectors == MAX_SELECTORS - 2) {
+				log_error("Too many device selectors.\n");
+				goto fail;
+			}
+			if (select_init(&selectors[num_selectors],
+					c == OPT_BUS_ID ? SELECT_TYPE_BUS_ID :
+					SELECT_TYPE_PARENT, DEVICE_KIND_UNKNOWN,
+					optarg))
+				goto fail;
+			num_selectors++;
 			break;
 		case 'h':
 			print_usage();
@@ -156,42 +734,108 @@ int parse_cmd_line(int argc, char **argv) {
 
 	/* check for conflicting command line parameters */
 	if ((add && flush) || (add && remove) || (remove && flush) ||
-	    (get && add) || (get && remove) || (get && flush)) {
-		verbose("Conflicting command line arguments.\n");
+	    (get && add) || (get && remove) || (get && flush) ||
+	    (daemon && (add || remove || flush || get)) ||
+	    (all_netns && (add || remove || daemon || net_device || ib_device ||
+			   locality_mode || device_filter || cache_path ||
+			   shmtable_path || strcmp(sysfs_root, SYSFS_ROOT))) ||
+	    (pairs_mode && (add || remove || flush || daemon)) ||
+	    (assign_rule && (add || remove || flush || get || daemon ||
+			     all_netns || pairs_mode)) ||
+	    (dry_run && !assign_rule) ||
+	    (daemon_export_path && !daemon) ||
+	    ((regex || num_selectors) && !add) ||
+	    (locality_mode && (add || remove || flush || daemon ||
+			       assign_rule || pnet_table)) ||
+	    (device_filter && (add || remove || flush || daemon ||
+			       assign_rule || pnet_table)) ||
+	    (pnet_table && (add || remove || flush || daemon || all_netns ||
+			    pairs_mode || assign_rule || net_device ||
+			    ib_device))) {
+		log_error("Conflicting command line arguments.\n");
 		goto fail;
 	}
 
+	if (daemon) {
+		/* serve devices and pnetids until stopped */
+		log_info("Running as daemon.\n");
+		return daemon_run();
+	}
+
 	if (flush) {
 		/* flush all pnetids and quit */
-		verbose("Flushing all pnetids.\n");
+		log_info("Flushing all pnetids.\n");
+		if (all_netns)
+			return netns_run_all(1);
 		return run_flush_command();
 	}
 
+	if (assign_rule) {
+		/* add pnetids to groups of devices */
+		log_info("Auto-assigning pnetids with rule \"%s\".\n",
+			 assign_rule);
+		return run_assign_command(assign_rule, dry_run);
+	}
+
 	if (remove) {
 		/* remove a specific pnetid */
-		verbose("Removing pnetid \"%s\".\n", pnetid);
+		log_info("Removing pnetid \"%s\".\n", pnetid);
 		return run_del_command(pnetid);
 	}
 
 	if (add) {
 		/* add a pnetid entry */
-		verbose("Adding pnetid \"%s\".\n", pnetid);
+		log_info("Adding pnetid \"%s\".\n", pnetid);
+		if (regex || num_selectors ||
+		    (net_device && select_is_pattern(net_device)) ||
+		    (ib_device && select_is_pattern(ib_device)))
+			return run_select_add_command(pnetid, net_device,
+						      ib_device, regex,
+						      selectors, num_selectors,
+						      ib_port);
 		return run_add_command(pnetid, net_device, ib_device, ib_port);
 	}
 
+	if ((net_device || ib_device) && !get && !all_netns && !pairs_mode) {
+		/* get the pnetid of a single device */
+		if (net_device && ib_device) {
+			log_error("Conflicting command line arguments.\n");
+			goto fail;
+		}
+		log_info("Getting pnetid of device \"%s\".\n",
+			 net_device ? net_device : ib_device);
+		return run_query_command(net_device, ib_device, ib_port);
+	}
+
+	if (pnet_table) {
+		/* only print the pnetid table */
+		log_info("Getting pnetid table.\n");
+		return run_pnet_table_command();
+	}
+
 	if (get) {
 		/* get a specific pnetid */
-		verbose("Getting devices with pnetid \"%s\".\n", pnetid);
-		pnetid_filter = pnetid;
+		for (int i = 0; i < num_pnetid_filters; i++)
+			log_info("Getting devices with pnetid \"%s\".\n",
+				 pnetid_filters[i]);
+		if (all_netns)
+			return netns_run_all(0);
 		return run_get_command();
 	}
 
 	/* No special commands, print device table to screen if there was
-	 * no command line argument or if we are in verbose mode
+	 * no command line argument, if we are in verbose, stats, trace,
+	 * pairs, or locality mode, if devices are filtered, or if devices
+	 * are read from another source
 	 */
-	if (argc == 1 || verbose_mode) {
+	if (argc == 1 || log_level > LOG_LEVEL_ERROR || stats_mode ||
+	    trace_file || shmtable_path || strcmp(sysfs_root, SYSFS_ROOT) ||
+	    cache_path || all_netns || pairs_mode || locality_mode ||
+	    device_filter) {
 		/* get all devices and pnetids */
-		verbose("Getting all devices and pnetids.\n");
+		log_info("Getting all devices and pnetids.\n");
+		if (all_netns)
+			return netns_run_all(0);
 		return run_get_command();
 	}
 fail:
@@ -4,16 +4,27 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 #include "test.h"
 #include "cmd.h"
+#include "netlink.h"
+
+/* smc generic netlink family, negative if smc is not available */
+extern int nl_family;
 
 // test the function parse_cmd_line()
 int test_parse_cmd_line() {
 	char *exe = "pnetctl";
+	int nl_rc;
 	int rc;
 
+	// changing pnetids fails if smc is not available
+	nl_init();
+	nl_rc = nl_family >= 0 ? 0 : EXIT_FAILURE;
+	nl_cleanup();
+
 	// no command line arguments
 	char *args_none[] = {exe};
 	rc = parse_cmd_line(1, args_none);
@@ -28,6 +39,31 @@ int test_parse_cmd_line() {
 		return -1;
 	}
 
+	// export without daemon
+	char *args_export[] = {exe, "--export"};
+	rc = parse_cmd_line(2, args_export);
+	if (!rc) {
+		return -1;
+	}
+
+	// all namespaces with options that are not handled per namespace
+	char *args_all_netns[][3] = {
+		{exe, "-A", "-nlo"},
+		{exe, "-A", "-ilo"},
+		{exe, "-A", "--filter=name=lo"},
+		{exe, "-A", "--locality"},
+		{exe, "-A", "--cache"},
+		{exe, "-A", "--shm"},
+		{exe, "-A", "--sysfs-root=/tmp"},
+	};
+	for (size_t i = 0; i < sizeof(args_all_netns) /
+	     sizeof(args_all_netns[0]); i++) {
+		rc = parse_cmd_line(3, args_all_netns[i]);
+		if (!rc) {
+			return -1;
+		}
+	}
+
 	// help
 	char *args_help[] = {exe, "-h"};
 	rc = parse_cmd_line(2, args_help);
@@ -38,8 +74,8 @@ int test_parse_cmd_line() {
 	// add
 	char *args_add[] = {exe, "-a", "PNETCTL", "-n", "lo"};
 	rc = parse_cmd_line(5, args_add);
-	if (rc) {
-		return rc;
+	if (rc != nl_rc) {
+		return -1;
 	}
 
 	// get
@@ -52,15 +88,15 @@ int test_parse_cmd_line() {
 	// remove
 	char *args_remove[] = {exe, "-r", "PNETCTL"};
 	rc = parse_cmd_line(3, args_remove);
-	if (rc) {
-		return rc;
+	if (rc != nl_rc) {
+		return -1;
 	}
 
 	// flush
 	char *args_flush[] = {exe, "-f"};
 	rc = parse_cmd_line(2, args_flush);
-	if (rc) {
-		return rc;
+	if (rc != nl_rc) {
+		return -1;
 	}
 
 	// no command line arguments, verbose
@@ -87,8 +123,8 @@ int test_parse_cmd_line() {
 	// add, verbose
 	char *args_add_verbose[] = {exe, "-v", "-a", "PNETCTL", "-n", "lo"};
 	rc = parse_cmd_line(6, args_add_verbose);
-	if (rc) {
-		return rc;
+	if (rc != nl_rc) {
+		return -1;
 	}
 
 	// get, verbose
@@ -101,15 +137,15 @@ int test_parse_cmd_line() {
 	// remove, verbose
 	char *args_remove_verbose[] = {exe, "-v", "-r", "PNETCTL"};
 	rc = parse_cmd_line(4, args_remove_verbose);
-	if (rc) {
-		return rc;
+	if (rc != nl_rc) {
+		return -1;
 	}
 
 	// flush, verbose
 	char *args_flush_verbose[] = {exe, "-v", "-f"};
 	rc = parse_cmd_line(3, args_flush_verbose);
-	if (rc) {
-		return rc;
+	if (rc != nl_rc) {
+		return -1;
 	}
 
 	return 0;
@@ -121,9 +157,5 @@ struct test tests[] = {
 };
 
 int main(int argc, char** argv) {
-	const char *name = NULL;
-	if (argc > 1) {
-		name = argv[1];
-	}
-	return run_test(tests, name);
+	return run_test(tests, argc, argv);
 }
@@ -4,7 +4,10 @@
 #define SMC_MAX_PNETID_LEN 16 /* maximum length of pnetids */
 #define IB_DEFAULT_PORT 1 /* default port for infiniband devices */
 
-/* pnetid filter when printing the device table */
-extern const char *pnetid_filter;
+#define MAX_PNETID_FILTERS 16 /* maximum number of pnetid filters */
+
+/* pnetid filters when printing the device table */
+extern const char *pnetid_filters[MAX_PNETID_FILTERS];
+extern int num_pnetid_filters;
 
 #endif
@@ -0,0 +1,493 @@
+/*
+ * *******************
+ * *** DAEMON PART ***
+ * *******************
+ */
+
+#include <libudev.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "daemon.h"
+#include "devices.h"
+#include "netlink.h"
+#include "udev.h"
+#include "verbose.h"
+#include "shmtable.h"
+#include "export.h"
+#include "stats.h"
+#include "lazy.h"
+
+/* socket path of the daemon */
+const char *daemon_socket_path = DAEMON_SOCKET_PATH;
+
+/* path of the published table, not published by default */
+const char *daemon_publish_path = NULL;
+
+/* path of the exported metrics, not exported by default */
+const char *daemon_export_path = NULL;
+
+/* durations and counts of scans and dumps for exported metrics */
+static struct export_stats daemon_export_stats;
+
+/* time of the last netlink dump, the next one is due after
+ * DAEMON_REFRESH_INTERVAL even if clients keep the socket busy
+ */
+static uint64_t daemon_last_refresh;
+
+/* set by signal handler to stop the daemon */
+static volatile sig_atomic_t daemon_stop;
+
+/* signal handler for stopping the daemon */
+static void daemon_signal(int sig) {
+	daemon_stop = 1;
+}
+
+/* read exactly len bytes from fd */
+static int read_full(int fd, void *buffer, size_t len) {
+	char *ptr = buffer;
+	ssize_t count;
+
+	while (len) {
+		count = read(fd, ptr, len);
+		if (count == -1 && errno == EINTR)
+			continue;
+		if (count <= 0)
+			return -1;
+		ptr += count;
+		len -= count;
+	}
+	return 0;
+}
+
+/* write exactly len bytes to socket fd */
+static int write_full(int fd, const void *buffer, size_t len) {
+	const char *ptr = buffer;
+	ssize_t count;
+
+	while (len) {
+		count = send(fd, ptr, len, MSG_NOSIGNAL);
+		if (count == -1 && errno == EINTR)
+			continue;
+		if (count <= 0)
+			return -1;
+		ptr += count;
+		len -= count;
+	}
+	return 0;
+}
+
+/* fill unix socket address with socket path */
+static int daemon_addr(struct sockaddr_un *addr) {
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	if (strlen(daemon_socket_path) >= sizeof(addr->sun_path))
+		return -1;
+	strcpy(addr->sun_path, daemon_socket_path);
+	return 0;
+}
+
+/* check if device matches the request */
+static int daemon_match(struct daemon_request *request,
+			struct device *device) {
+	switch (request->cmd) {
+	case DAEMON_CMD_GET_PNETID:
+		return !strncmp(device->pnetid, request->pnetid,
+				SMC_MAX_PNETID_LEN);
+	case DAEMON_CMD_GET_DEVICE:
+		if (request->net_device[0])
+			return device->kind == DEVICE_KIND_NET &&
+				!strcmp(device->name, request->net_device);
+		if (request->ib_port > 0 && device->ib_port != request->ib_port)
+			return 0;
+		return !strcmp(device->name, request->ib_device);
+	}
+	return 1;
+}
+
+/* refresh pnetids of all devices from util_strings and netlink */
+static void daemon_refresh_pnetids() {
+	uint64_t start_ns = stats_now();
+
+	log_debug("Refreshing pnetids via netlink.\n");
+	daemon_last_refresh = start_ns;
+	reset_pnetids();
+	nl_init();
+	nl_get_pnetids();
+	nl_cleanup();
+	daemon_export_stats.dump_ns = stats_now() - start_ns;
+	daemon_export_stats.dumps++;
+	if (daemon_publish_path)
+		shmtable_publish();
+	if (daemon_export_path &&
+	    export_write(daemon_export_path, &daemon_export_stats))
+		log_error("Cannot export metrics to \"%s\": %s\n",
+			  daemon_export_path, strerror(errno));
+}
+
+/* rescan all devices and refresh their pnetids */
+static void daemon_rescan() {
+	uint64_t start_ns = stats_now();
+
+	log_debug("Rescanning devices.\n");
+	free_devices();
+	if (udev_scan_devices())
+		log_error("Error scanning devices.\n");
+	daemon_export_stats.scan_ns = stats_now() - start_ns;
+	daemon_export_stats.scans++;
+	daemon_refresh_pnetids();
+}
+
+/* run a command that changes pnetids, returns 0 on success or a negative
+ * error code
+ */
+static int daemon_change(struct daemon_request *request) {
+	int rc = 0;
+
+	nl_init();
+	switch (request->cmd) {
+	case DAEMON_CMD_ADD:
+		rc = nl_set_pnetid(request->pnetid,
+				   request->net_device[0] ?
+				   request->net_device : NULL,
+				   request->ib_device[0] ?
+				   request->ib_device : NULL,
+				   request->ib_port);
+		break;
+	case DAEMON_CMD_DEL:
+		rc = nl_del_pnetid(request->pnetid);
+		break;
+	case DAEMON_CMD_FLUSH:
+		rc = nl_flush_pnetids();
+		break;
+	}
+	nl_cleanup();
+	daemon_refresh_pnetids();
+	return rc;
+}
+
+/* handle a request of a client connected on fd */
+static void daemon_handle_client(int fd) {
+	struct timeval timeout = { .tv_sec = DAEMON_TIMEOUT };
+	struct daemon_response response = {
+		.magic = DAEMON_MAGIC,
+		.version = DAEMON_VERSION,
+	};
+	struct daemon_request request;
+	struct device_record record;
+	struct device *next;
+	int rc;
+
+	/* do not let a slow client block the daemon */
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+	if (read_full(fd, &request, sizeof(request)))
+		return;
+	if (request.magic != DAEMON_MAGIC ||
+	    request.version != DAEMON_VERSION) {
+		log_error("Invalid daemon request.\n");
+		response.status = 1;
+		write_full(fd, &response, sizeof(response));
+		return;
+	}
+	request.pnetid[SMC_MAX_PNETID_LEN] = 0;
+	request.net_device[DEVICE_NAME_LEN - 1] = 0;
+	request.ib_device[DEVICE_NAME_LEN - 1] = 0;
+	log_debug("Handling daemon request %d.\n", request.cmd);
+
+	switch (request.cmd) {
+	case DAEMON_CMD_ADD:
+	case DAEMON_CMD_DEL:
+	case DAEMON_CMD_FLUSH:
+		/* the status is the errno of the failed netlink request */
+		rc = daemon_change(&request);
+		if (rc)
+			response.status = -rc < 256 ? -rc : EIO;
+		write_full(fd, &response, sizeof(response));
+		return;
+	}
+
+	/* count matching devices first, then send them */
+	next = get_next_device(&devices_list);
+	while (next) {
+		if (daemon_match(&request, next))
+			response.count++;
+		next = get_next_device(next);
+	}
+	if (write_full(fd, &response, sizeof(response)))
+		return;
+
+	next = get_next_device(&devices_list);
+	while (next) {
+		if (!daemon_match(&request, next)) {
+			next = get_next_device(next);
+			continue;
+		}
+		device_to_record(next, &record);
+		if (write_full(fd, &record, sizeof(record)))
+			return;
+		next = get_next_device(next);
+	}
+}
+
+/* check if a daemon answers on the socket path */
+static int daemon_running(struct sockaddr_un *addr) {
+	int running;
+	int fd;
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd == -1)
+		return 0;
+	running = !connect(fd, (struct sockaddr *) addr, sizeof(*addr));
+	close(fd);
+	return running;
+}
+
+/* create the listening socket of the daemon */
+static int daemon_listen() {
+	struct sockaddr_un addr;
+	mode_t mask;
+	int rc;
+	int fd;
+
+	if (daemon_addr(&addr))
+		return -1;
+
+	/* do not take over the socket of another running daemon, only
+	 * remove a stale socket
+	 */
+	if (daemon_running(&addr)) {
+		errno = EADDRINUSE;
+		return -1;
+	}
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd == -1)
+		return -1;
+	unlink(daemon_socket_path);
+
+	/* only allow root to query and change pnetids via the daemon, the
+	 * socket is created with these permissions
+	 */
+	mask = umask(S_IXUSR | S_IRWXG | S_IRWXO);
+	rc = bind(fd, (struct sockaddr *) &addr, sizeof(addr));
+	umask(mask);
+	if (rc || listen(fd, 64)) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/* create udev monitor for device changes */
+static struct udev_monitor *daemon_monitor(struct udev *udev_ctx) {
+	struct udev_monitor *monitor;
+
+	monitor = udev_monitor_new_from_netlink(udev_ctx, "udev");
+	if (!monitor)
+		return NULL;
+	udev_monitor_filter_add_match_subsystem_devtype(monitor, "net", NULL);
+	udev_monitor_filter_add_match_subsystem_devtype(monitor, "infiniband",
+							NULL);
+	udev_monitor_filter_add_match_subsystem_devtype(monitor, "pci", NULL);
+	if (udev_monitor_enable_receiving(monitor)) {
+		udev_monitor_unref(monitor);
+		return NULL;
+	}
+	return monitor;
+}
+
+/* get the poll timeout in ms until the next netlink dump is due */
+static int daemon_timeout() {
+	uint64_t interval_ns = DAEMON_REFRESH_INTERVAL * 1000000000ULL;
+	uint64_t elapsed_ns = stats_now() - daemon_last_refresh;
+
+	if (elapsed_ns >= interval_ns)
+		return 0;
+	return (interval_ns - elapsed_ns + 999999) / 1000000;
+}
+
+/* run the daemon until it is stopped by a signal */
+int daemon_run() {
+	struct udev_monitor *monitor = NULL;
+	struct udev_device *udev_device;
+	struct pollfd fds[2];
+	struct udev *udev_ctx = NULL;
+	struct sigaction sa;
+	int nfds = 1;
+	int rescan;
+	int rc;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = daemon_signal;
+	sigaction(SIGTERM, &sa, NULL);
+	sigaction(SIGINT, &sa, NULL);
+	daemon_stop = 0;
+	memset(&daemon_export_stats, 0, sizeof(daemon_export_stats));
+
+	fds[0].fd = daemon_listen();
+	if (fds[0].fd == -1) {
+		log_error("Cannot listen on socket \"%s\": %s\n",
+			  daemon_socket_path, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	fds[0].events = POLLIN;
+
+	/* publish devices in a mapped table for local readers */
+	if (daemon_publish_path && shmtable_create(daemon_publish_path)) {
+		log_error("Cannot create table \"%s\": %s\n",
+			  daemon_publish_path, strerror(errno));
+		close(fds[0].fd);
+		unlink(daemon_socket_path);
+		return EXIT_FAILURE;
+	}
+
+	/* monitor device changes, fall back to periodic rescans without */
+	if (!lazy_load_udev())
+		udev_ctx = udev_new();
+	if (udev_ctx)
+		monitor = daemon_monitor(udev_ctx);
+	if (monitor) {
+		fds[1].fd = udev_monitor_get_fd(monitor);
+		fds[1].events = POLLIN;
+		nfds = 2;
+	} else {
+		log_error("Cannot monitor udev events, rescanning "
+			  "periodically.\n");
+	}
+
+	log_info("Serving devices on socket \"%s\".\n", daemon_socket_path);
+	daemon_rescan();
+	while (!daemon_stop) {
+		rc = poll(fds, nfds, daemon_timeout());
+		if (rc == -1)
+			continue;
+
+		/* periodic netlink dump, also while clients keep polling */
+		if (!daemon_timeout()) {
+			if (monitor)
+				daemon_refresh_pnetids();
+			else
+				daemon_rescan();
+		}
+		if (rc == 0)
+			continue;
+
+		/* coalesce all pending udev events into one rescan */
+		rescan = 0;
+		if (nfds == 2 && (fds[1].revents & POLLIN)) {
+			while ((udev_device =
+				udev_monitor_receive_device(monitor))) {
+				log_debug("Got udev event \"%s\" for device "
+					  "\"%s\".\n",
+					  udev_device_get_action(udev_device),
+					  udev_device_get_sysname(udev_device));
+				udev_device_unref(udev_device);
+				rescan = 1;
+			}
+		}
+		if (rescan)
+			daemon_rescan();
+
+		if (fds[0].revents & POLLIN) {
+			int fd = accept(fds[0].fd, NULL, NULL);
+			if (fd == -1)
+				continue;
+			daemon_handle_client(fd);
+			close(fd);
+		}
+	}
+
+	log_info("Stopping daemon.\n");
+	close(fds[0].fd);
+	unlink(daemon_socket_path);
+	shmtable_destroy();
+	if (monitor)
+		udev_monitor_unref(monitor);
+	if (udev_ctx)
+		udev_unref(udev_ctx);
+	free_devices();
+	return EXIT_SUCCESS;
+}
+
+/* send request to daemon and receive device records in response, returns
+ * number of records, -1 if the request could not be sent to the daemon, or
+ * DAEMON_ERROR if the daemon failed or did not answer the request
+ */
+int daemon_query(struct daemon_request *request,
+		 struct device_record **records) {
+	struct timeval timeout = { .tv_sec = DAEMON_TIMEOUT };
+	struct daemon_response response;
+	struct sockaddr_un addr;
+	int fd;
+
+	*records = NULL;
+	if (daemon_addr(&addr))
+		return -1;
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd == -1)
+		return -1;
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+	if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)))
+		goto fail;
+	log_debug("Sending request %d to daemon on socket \"%s\".\n",
+		  request->cmd, daemon_socket_path);
+
+	request->magic = DAEMON_MAGIC;
+	request->version = DAEMON_VERSION;
+	if (write_full(fd, request, sizeof(*request)))
+		goto fail;
+
+	/* the daemon may have run the request, so the caller must not run it
+	 * again if the response is missing
+	 */
+	if (read_full(fd, &response, sizeof(response)) ||
+	    response.magic != DAEMON_MAGIC ||
+	    response.version != DAEMON_VERSION) {
+		log_error("No valid response from daemon on socket \"%s\".\n",
+			  daemon_socket_path);
+		close(fd);
+		return DAEMON_ERROR;
+	}
+	if (response.status) {
+		log_error("Daemon request failed: %s\n",
+			  strerror(response.status));
+		close(fd);
+		return DAEMON_ERROR;
+	}
+	if (response.count > DAEMON_MAX_RECORDS) {
+		log_error("Invalid daemon response with %u records.\n",
+			  response.count);
+		close(fd);
+		return DAEMON_ERROR;
+	}
+
+	if (response.count) {
+		*records = calloc(response.count, sizeof(**records));
+		if (!*records ||
+		    read_full(fd, *records,
+			      response.count * sizeof(**records))) {
+			log_error("Cannot read daemon response with %u "
+				  "records.\n", response.count);
+			free(*records);
+			*records = NULL;
+			close(fd);
+			return DAEMON_ERROR;
+		}
+	}
+	close(fd);
+	return response.count;
+fail:
+	log_debug("Daemon on socket \"%s\" not available.\n",
+		  daemon_socket_path);
+	close(fd);
+	return -1;
+}
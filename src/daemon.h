@@ -0,0 +1,60 @@
+#ifndef _PNETCTL_DAEMON_H
+#define _PNETCTL_DAEMON_H
+
+#include <stdint.h>
+
+#include "devices.h"
+
+#define DAEMON_SOCKET_PATH "/run/pnetctl.sock" /* default socket path */
+#define DAEMON_MAGIC 0x504e /* "PN", first bytes of every message */
+#define DAEMON_VERSION 1 /* protocol version */
+#define DAEMON_REFRESH_INTERVAL 5 /* seconds between netlink dumps */
+#define DAEMON_TIMEOUT 5 /* client timeout in seconds */
+#define DAEMON_MAX_RECORDS 65536 /* maximum records in a response */
+#define DAEMON_ERROR -2 /* daemon failed or did not answer the request */
+
+/* daemon request commands */
+enum daemon_cmds {
+	DAEMON_CMD_LIST,
+	DAEMON_CMD_GET_PNETID,
+	DAEMON_CMD_GET_DEVICE,
+	DAEMON_CMD_ADD,
+	DAEMON_CMD_DEL,
+	DAEMON_CMD_FLUSH,
+};
+
+/* request sent from client to daemon */
+struct daemon_request {
+	uint16_t magic;
+	uint8_t version;
+	uint8_t cmd;
+	int32_t ib_port;
+	char pnetid[SMC_MAX_PNETID_LEN + 1];
+	char net_device[DEVICE_NAME_LEN];
+	char ib_device[DEVICE_NAME_LEN];
+};
+
+/* response header sent from daemon to client, followed by count device
+ * records
+ */
+struct daemon_response {
+	uint16_t magic;
+	uint8_t version;
+	uint8_t status;
+	uint32_t count;
+};
+
+/* socket path of the daemon */
+extern const char *daemon_socket_path;
+
+/* path of the published table, not published by default */
+extern const char *daemon_publish_path;
+
+/* path of the exported metrics, not exported by default */
+extern const char *daemon_export_path;
+
+int daemon_run();
+int daemon_query(struct daemon_request *request,
+		 struct device_record **records);
+
+#endif
@@ -0,0 +1,222 @@
+/*
+ * test for daemon
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "test.h"
+#include "daemon.h"
+#include "devices.h"
+#include "netlink.h"
+
+/* smc generic netlink family, negative if smc is not available */
+extern int nl_family;
+
+// start daemon in child process and wait until it accepts requests
+static pid_t start_daemon() {
+	struct daemon_request request = {.cmd = DAEMON_CMD_LIST};
+	struct device_record *devices;
+	pid_t pid;
+
+	pid = fork();
+	if (pid == 0) {
+		exit(daemon_run());
+	}
+	for (int i = 0; i < 100; i++) {
+		if (daemon_query(&request, &devices) >= 0) {
+			free(devices);
+			return pid;
+		}
+		usleep(50000);
+	}
+	kill(pid, SIGTERM);
+	waitpid(pid, NULL, 0);
+	return -1;
+}
+
+// stop daemon in child process
+static int stop_daemon(pid_t pid) {
+	int status;
+
+	kill(pid, SIGTERM);
+	waitpid(pid, &status, 0);
+	if (!WIFEXITED(status)) {
+		return -1;
+	}
+	return WEXITSTATUS(status);
+}
+
+// test the function daemon_query() without daemon
+int test_daemon_query() {
+	struct daemon_request request = {.cmd = DAEMON_CMD_LIST};
+	struct device_record *devices;
+
+	daemon_socket_path = "/tmp/pnetctl_test_does_not_exist.sock";
+	if (daemon_query(&request, &devices) != -1) {
+		return -1;
+	}
+	if (devices) {
+		return -1;
+	}
+	return 0;
+}
+
+// test the function daemon_query() with a daemon that does not answer
+int test_daemon_query_no_response() {
+	struct daemon_request request = {.cmd = DAEMON_CMD_ADD};
+	struct sockaddr_un addr = {.sun_family = AF_UNIX};
+	struct device_record *devices;
+	char buf[sizeof(request)];
+	int rc = 0;
+	pid_t pid;
+	int fd;
+
+	daemon_socket_path = "/tmp/pnetctl_test_no_response.sock";
+	strcpy(addr.sun_path, daemon_socket_path);
+	unlink(daemon_socket_path);
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd == -1 || bind(fd, (struct sockaddr *) &addr, sizeof(addr)) ||
+	    listen(fd, 1)) {
+		return -1;
+	}
+
+	// receive the request and close the connection without a response
+	fflush(stdout);
+	pid = fork();
+	if (pid == 0) {
+		int conn = accept(fd, NULL, NULL);
+		ssize_t len = read(conn, buf, sizeof(buf));
+
+		close(conn);
+		exit(len > 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	// request was sent, so it must not be run again by the caller
+	if (daemon_query(&request, &devices) != DAEMON_ERROR || devices) {
+		rc = -1;
+	}
+	waitpid(pid, NULL, 0);
+	close(fd);
+	unlink(daemon_socket_path);
+	return rc;
+}
+
+// test the function daemon_run()
+int test_daemon_run() {
+	struct daemon_request request = {};
+	struct device_record *devices;
+	struct device *device;
+	struct stat st;
+	pid_t second;
+	int expected;
+	int status;
+	int count;
+	pid_t pid;
+
+	daemon_socket_path = "/tmp/pnetctl_test_daemon.sock";
+	pid = start_daemon();
+	if (pid == -1) {
+		return -1;
+	}
+
+	// list all devices
+	request.cmd = DAEMON_CMD_LIST;
+	count = daemon_query(&request, &devices);
+	if (count < 0) {
+		stop_daemon(pid);
+		return -1;
+	}
+	add_device_records(devices, count);
+	device = get_next_device(&devices_list);
+	for (int i = 0; i < count; i++) {
+		if (!device || strcmp(device->name, devices[i].name)) {
+			stop_daemon(pid);
+			return -1;
+		}
+		device = get_next_device(device);
+	}
+	free_devices();
+	free(devices);
+
+	// get devices with a pnetid
+	request.cmd = DAEMON_CMD_GET_PNETID;
+	strcpy(request.pnetid, "DOES_NOT_MATCH");
+	count = daemon_query(&request, &devices);
+	free(devices);
+	if (count != 0) {
+		stop_daemon(pid);
+		return -1;
+	}
+
+	// get device by name
+	request.cmd = DAEMON_CMD_GET_DEVICE;
+	strcpy(request.net_device, "lo");
+	count = daemon_query(&request, &devices);
+	if (count != 1 || strcmp(devices[0].name, "lo")) {
+		free(devices);
+		stop_daemon(pid);
+		return -1;
+	}
+	free(devices);
+
+	// change pnetids, netlink errors are passed to the client
+	nl_init();
+	expected = nl_family >= 0 ? 0 : DAEMON_ERROR;
+	nl_cleanup();
+	request.cmd = DAEMON_CMD_ADD;
+	strcpy(request.pnetid, "PNETCTL");
+	if (daemon_query(&request, &devices) != expected) {
+		stop_daemon(pid);
+		return -1;
+	}
+	request.cmd = DAEMON_CMD_FLUSH;
+	if (daemon_query(&request, &devices) != expected) {
+		stop_daemon(pid);
+		return -1;
+	}
+
+	// socket is only accessible by its owner
+	if (stat(daemon_socket_path, &st) ||
+	    (st.st_mode & 0777) != (S_IRUSR | S_IWUSR)) {
+		stop_daemon(pid);
+		return -1;
+	}
+
+	// a second daemon does not take over the socket
+	fflush(stdout);
+	second = fork();
+	if (second == 0) {
+		exit(daemon_run());
+	}
+	waitpid(second, &status, 0);
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_FAILURE ||
+	    daemon_query(&request, &devices) != expected) {
+		stop_daemon(pid);
+		return -1;
+	}
+
+	// socket is removed when the daemon stops
+	if (stop_daemon(pid) || !access(daemon_socket_path, F_OK)) {
+		return -1;
+	}
+	return 0;
+}
+
+struct test tests[] = {
+	{"daemon_query", test_daemon_query},
+	{"daemon_query_no_response", test_daemon_query_no_response},
+	{"daemon_run", test_daemon_run},
+	{NULL, NULL},
+};
+
+int main(int argc, char** argv) {
+	return run_test(tests, argc, argv);
+}
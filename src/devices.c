@@ -8,11 +8,64 @@
 #include <stdlib.h>
 
 #include "devices.h"
+#include "udev.h"
 #include "verbose.h"
 
 /* list of devices */
 struct device devices_list = {};
 
+/* subsystem names of device kinds, ism devices are pci devices with the ism
+ * driver but use their own name in device records
+ */
+const char *device_kind_names[DEVICE_KIND_MAX] = {
+	[DEVICE_KIND_UNKNOWN] = "",
+	[DEVICE_KIND_NET] = "net",
+	[DEVICE_KIND_IB] = "infiniband",
+	[DEVICE_KIND_ISM] = "ism",
+};
+
+/* short names of device kinds for output */
+const char *device_kind_labels[DEVICE_KIND_MAX] = {
+	[DEVICE_KIND_UNKNOWN] = "n/a",
+	[DEVICE_KIND_NET] = "net",
+	[DEVICE_KIND_IB] = "ib",
+	[DEVICE_KIND_ISM] = "ism",
+};
+
+/* subsystem names of parent bus types */
+static const char *device_bus_names[DEVICE_BUS_MAX] = {
+	[DEVICE_BUS_PCI] = "pci",
+	[DEVICE_BUS_CCWGROUP] = "ccwgroup",
+};
+
+/* get the device kind of subsystem */
+int device_kind(const char *subsystem) {
+	if (!subsystem)
+		return DEVICE_KIND_UNKNOWN;
+	for (int i = DEVICE_KIND_UNKNOWN + 1; i < DEVICE_KIND_MAX; i++)
+		if (!strcmp(subsystem, device_kind_names[i]))
+			return i;
+	return DEVICE_KIND_UNKNOWN;
+}
+
+/* get the bus type of parent subsystem */
+int device_bus(const char *parent_subsystem) {
+	if (!parent_subsystem)
+		return DEVICE_BUS_NONE;
+	for (int i = DEVICE_BUS_NONE + 1; i < DEVICE_BUS_OTHER; i++)
+		if (!strcmp(parent_subsystem, device_bus_names[i]))
+			return i;
+	return DEVICE_BUS_OTHER;
+}
+
+/* classify device by its subsystem and parent subsystem, call once after
+ * they are set
+ */
+void classify_device(struct device *device) {
+	device->kind = device_kind(device->subsystem);
+	device->bus = device_bus(device->parent_subsystem);
+}
+
 /* get next device in devices list */
 struct device *get_next_device(struct device *device) {
 	return device->next;
@@ -39,20 +92,92 @@ struct device *new_device() {
 	return device;
 }
 
+/* free device that is not in devices list any more */
+void free_device(struct device *device) {
+	if (device->udev_device)
+		udev_release_device(device);
+	free(device->names);
+	free(device->locality);
+	free(device);
+}
+
 /* free all devices in devices list */
 void free_devices() {
 	struct device *next;
 	struct device *cur;
 
-	verbose("Freeing devices in device table.\n");
+	log_debug("Freeing devices in device table.\n");
 	next = get_next_device(&devices_list);
 	while (next) {
-		// TODO: also free udev devices?
 		cur = next;
 		next = get_next_device(next);
-		free(cur);
+		free_device(cur);
 	}
 	devices_list.next = NULL;
+	udev_cleanup();
+}
+
+/* reset pnetids of all devices to the ones read from util_strings */
+void reset_pnetids() {
+	struct device *next;
+
+	next = get_next_device(&devices_list);
+	while (next) {
+		memcpy(next->pnetid, next->util_pnetid, sizeof(next->pnetid));
+		next = get_next_device(next);
+	}
+}
+
+/* copy string to fixed size field, empty string for NULL */
+static void copy_name(char *dst, const char *src, size_t len) {
+	if (!src)
+		src = "";
+	strncpy(dst, src, len - 1);
+	dst[len - 1] = 0;
+}
+
+/* fill device record from device */
+void device_to_record(struct device *device, struct device_record *record) {
+	memset(record, 0, sizeof(*record));
+	copy_name(record->subsystem, device->kind ?
+		  device_kind_names[device->kind] : device->subsystem,
+		  sizeof(record->subsystem));
+	copy_name(record->name, device->name, sizeof(record->name));
+	copy_name(record->parent, device->parent, sizeof(record->parent));
+	copy_name(record->parent_subsystem, device->parent_subsystem,
+		  sizeof(record->parent_subsystem));
+	copy_name(record->lowest, device->lowest, sizeof(record->lowest));
+	record->ib_port = device->ib_port;
+	memcpy(record->pnetid, device->pnetid, sizeof(record->pnetid));
+}
+
+/* add devices from records to devices list, the strings of the devices
+ * point into the records
+ */
+void add_device_records(struct device_record *records, int count) {
+	struct device_record *record;
+	struct device *device;
+
+	for (int i = 0; i < count; i++) {
+		record = &records[i];
+		record->subsystem[DEVICE_SUBSYSTEM_LEN - 1] = 0;
+		record->name[DEVICE_NAME_LEN - 1] = 0;
+		record->parent[DEVICE_NAME_LEN - 1] = 0;
+		record->parent_subsystem[DEVICE_SUBSYSTEM_LEN - 1] = 0;
+		record->lowest[DEVICE_NAME_LEN - 1] = 0;
+		record->pnetid[SMC_MAX_PNETID_LEN] = 0;
+
+		device = new_device();
+		device->subsystem = record->subsystem;
+		device->name = record->name;
+		device->parent = record->parent[0] ? record->parent : NULL;
+		device->parent_subsystem = record->parent_subsystem[0] ?
+			record->parent_subsystem : NULL;
+		device->lowest = record->lowest[0] ? record->lowest : NULL;
+		device->ib_port = record->ib_port;
+		memcpy(device->pnetid, record->pnetid, sizeof(device->pnetid));
+		classify_device(device);
+	}
 }
 
 /* set pnetid for eth device */
@@ -61,13 +186,13 @@ void set_pnetid_for_eth(const char *dev_name, const char* pnetid) {
 
 	next = get_next_device(&devices_list);
 	while (next) {
-		if (!strncmp(next->subsystem, "net", 3)) {
+		if (next->kind == DEVICE_KIND_NET) {
 			// TODO: use strncmp?
 			if (!strcmp(next->name, dev_name) ||
 			    !strcmp(next->lowest, dev_name)) {
 				strncpy(next->pnetid, pnetid,
 					SMC_MAX_PNETID_LEN);
-				verbose("Set pnetid of net device \"%s\" "
+				log_debug("Set pnetid of net device \"%s\" "
 					"to \"%s\".\n", dev_name, pnetid);
 			}
 
@@ -82,14 +207,14 @@ void set_pnetid_for_ib(const char *dev_name, int dev_port, const char* pnetid) {
 
 	next = get_next_device(&devices_list);
 	while (next) {
-		if (!strncmp(next->subsystem, "infiniband", 10)) {
+		if (next->kind == DEVICE_KIND_IB) {
 			// TODO: use strncmp?
 			if ((!strcmp(next->name, dev_name) ||
 			     !strcmp (next->parent, dev_name)) &&
 			    next->ib_port == dev_port) {
 				strncpy(next->pnetid, pnetid,
 					SMC_MAX_PNETID_LEN);
-				verbose("Set pnetid of ib device \"%s\" "
+				log_debug("Set pnetid of ib device \"%s\" "
 					"to \"%s\".\n", dev_name, pnetid);
 			}
 
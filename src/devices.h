@@ -1,8 +1,34 @@
 #ifndef _PNETCTL_DEVICES_H
 #define _PNETCTL_DEVICES_H
 
+#include <stdint.h>
+
 #include "common.h"
 
+/* kinds of devices */
+enum device_kinds {
+	DEVICE_KIND_UNKNOWN,
+	DEVICE_KIND_NET,
+	DEVICE_KIND_IB,
+	DEVICE_KIND_ISM,
+	DEVICE_KIND_MAX,
+};
+
+/* bus types of the parents of devices */
+enum device_buses {
+	DEVICE_BUS_NONE,
+	DEVICE_BUS_PCI,
+	DEVICE_BUS_CCWGROUP,
+	DEVICE_BUS_OTHER,
+	DEVICE_BUS_MAX,
+};
+
+/* subsystem names of device kinds in device records and short names for
+ * output
+ */
+extern const char *device_kind_names[DEVICE_KIND_MAX];
+extern const char *device_kind_labels[DEVICE_KIND_MAX];
+
 /* struct for devices */
 struct device {
 	/* list */
@@ -13,18 +39,30 @@ struct device {
 	struct udev_device *udev_parent;
 	struct udev_device *udev_lowest;
 
-	/* names */
+	/* names, owned by names buffer if it is set */
+	char *names;
 	const char *subsystem;
 	const char *name;
 	const char *parent;
 	const char *parent_subsystem;
 	const char *lowest;
 
+	/* classification of subsystem and parent subsystem */
+	int kind;
+	int bus;
+
 	/* infiniband */
 	int ib_port;
 
+	/* locality of the pci parent, strings owned by locality buffer */
+	char *locality;
+	const char *local_cpulist;
+	const char *pci_path;
+	int numa_node;
+
 	/* pnetid */
 	char pnetid[SMC_MAX_PNETID_LEN + 1];
+	char util_pnetid[SMC_MAX_PNETID_LEN + 1];
 
 	/* terminal output */
 	int output;
@@ -33,10 +71,31 @@ struct device {
 /* list of devices */
 extern struct device devices_list;
 
+#define DEVICE_NAME_LEN 64 /* maximum length of names in device records */
+#define DEVICE_SUBSYSTEM_LEN 16 /* maximum length of subsystems */
+
+/* fixed size device record for passing devices to other processes */
+struct device_record {
+	char subsystem[DEVICE_SUBSYSTEM_LEN];
+	char name[DEVICE_NAME_LEN];
+	char parent[DEVICE_NAME_LEN];
+	char parent_subsystem[DEVICE_SUBSYSTEM_LEN];
+	char lowest[DEVICE_NAME_LEN];
+	int32_t ib_port;
+	char pnetid[SMC_MAX_PNETID_LEN + 1];
+};
+
 struct device *new_device();
+int device_kind(const char *subsystem);
+int device_bus(const char *parent_subsystem);
+void classify_device(struct device *device);
 struct device *get_next_device(struct device *device);
 void set_pnetid_for_eth(const char *dev_name, const char* pnetid);
 void set_pnetid_for_ib(const char *dev_name, int dev_port, const char* pnetid);
+void reset_pnetids();
+void device_to_record(struct device *device, struct device_record *record);
+void add_device_records(struct device_record *records, int count);
+void free_device(struct device *device);
 void free_devices();
 
 #endif
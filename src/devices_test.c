@@ -33,11 +33,42 @@ int test_get_next_device() {
 	return 0;
 }
 
+// test the function classify_device()
+int test_classify_device() {
+	struct device *device = new_device();
+	int rc = -1;
+
+	device->subsystem = "infiniband";
+	device->parent_subsystem = "pci";
+	classify_device(device);
+	if (device->kind != DEVICE_KIND_IB || device->bus != DEVICE_BUS_PCI)
+		goto out;
+	device->subsystem = "net";
+	device->parent_subsystem = "ccwgroup";
+	classify_device(device);
+	if (device->kind != DEVICE_KIND_NET ||
+	    device->bus != DEVICE_BUS_CCWGROUP)
+		goto out;
+	device->subsystem = "tty";
+	device->parent_subsystem = NULL;
+	classify_device(device);
+	if (device->kind != DEVICE_KIND_UNKNOWN ||
+	    device->bus != DEVICE_BUS_NONE ||
+	    device_bus("platform") != DEVICE_BUS_OTHER ||
+	    device_kind("ism") != DEVICE_KIND_ISM)
+		goto out;
+	rc = 0;
+out:
+	free_devices();
+	return rc;
+}
+
 // test the function set_pnetid_for_eth()
 int test_set_pnetid_for_eth() {
 	struct device *device = new_device();
 	device->name = "lo";
 	device->subsystem = "net";
+	classify_device(device);
 	set_pnetid_for_eth("lo", "PNETID");
 	if (strncmp(device->pnetid, "PNETID", sizeof(device->pnetid))) {
 	    return -1;
@@ -51,6 +82,7 @@ int test_set_pnetid_for_ib() {
 	struct device *device = new_device();
 	device->name = "mlx5_1";
 	device->subsystem = "infiniband";
+	classify_device(device);
 	device->ib_port = 1;
 	set_pnetid_for_ib("mlx5_1", 1, "PNETID");
 	if (strncmp(device->pnetid, "PNETID", sizeof(device->pnetid))) {
@@ -60,6 +92,22 @@ int test_set_pnetid_for_ib() {
 	return 0;
 }
 
+// test the function reset_pnetids()
+int test_reset_pnetids() {
+	struct device *device = new_device();
+	device->name = "lo";
+	device->subsystem = "net";
+	classify_device(device);
+	strcpy(device->util_pnetid, "UTIL");
+	set_pnetid_for_eth("lo", "PNETID");
+	reset_pnetids();
+	if (strncmp(device->pnetid, "UTIL", sizeof(device->pnetid))) {
+	    return -1;
+	}
+	free_devices();
+	return 0;
+}
+
 // test the function free_devices()
 int test_free_devices() {
 	struct device *device;
@@ -80,16 +128,14 @@ int test_free_devices() {
 struct test tests[] = {
 	{"new_device", test_new_device},
 	{"get_next_device", test_get_next_device},
+	{"classify_device", test_classify_device},
 	{"set_pnetid_for_eth", test_set_pnetid_for_eth},
 	{"set_pnetid_for_ib", test_set_pnetid_for_ib},
+	{"reset_pnetids", test_reset_pnetids},
 	{"free_devices", test_free_devices},
 	{NULL, NULL},
 };
 
 int main(int argc, char **argv) {
-	const char *name = NULL;
-	if (argc > 1) {
-		name = argv[1];
-	}
-	return run_test(tests, name);
+	return run_test(tests, argc, argv);
 }
@@ -0,0 +1,182 @@
+/*
+ * benchmark for device discovery on a synthetic sysfs tree with the sysfs
+ * backend and on the devices of this system with udev
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "devices.h"
+#include "fixture.h"
+#include "print.h"
+#include "stats.h"
+#include "sysfs.h"
+#include "udev.h"
+
+#define BENCH_RUNS 5 /* default number of timed runs of each benchmark */
+
+/* apply a pnetid to each device like a netlink dump does */
+static void bench_apply_pnetids() {
+	struct device *device = get_next_device(&devices_list);
+	char pnetid[SMC_MAX_PNETID_LEN + 1];
+	int i = 0;
+
+	for (; device; device = get_next_device(device), i++) {
+		snprintf(pnetid, sizeof(pnetid), "BENCH%d",
+			 i % FIXTURE_PNETIDS);
+		if (device->ib_port > 0)
+			set_pnetid_for_ib(device->name, device->ib_port,
+					  pnetid);
+		else
+			set_pnetid_for_eth(device->name, pnetid);
+	}
+}
+
+/* print the device table to /dev/null */
+static void bench_print() {
+	int null_fd = open("/dev/null", O_WRONLY);
+	int stdout_fd = dup(STDOUT_FILENO);
+
+	fflush(stdout);
+	dup2(null_fd, STDOUT_FILENO);
+	print_device_table();
+	fflush(stdout);
+	dup2(stdout_fd, STDOUT_FILENO);
+	close(stdout_fd);
+	close(null_fd);
+}
+
+/* run benchmark name on the devices found by scan, append the results as a
+ * json line to json if it is set
+ */
+static int bench_run(const char *name, int (*scan)(), int devices, int runs,
+		     FILE *json) {
+	uint64_t min_ns = UINT64_MAX;
+	int64_t allocations = 0;
+	uint64_t total_ns = 0;
+	int count = 0;
+
+	for (int i = 0; i < runs; i++) {
+		struct device *device;
+		int64_t start_allocations = 0;
+		uint64_t start_ns = 0;
+		uint64_t ns;
+
+		if (!strcmp(name, "discovery") || !strcmp(name, "udev")) {
+			start_allocations = bench_allocations();
+			start_ns = stats_now();
+		}
+		if (scan())
+			return EXIT_FAILURE;
+		if (!strcmp(name, "pnetids")) {
+			start_allocations = bench_allocations();
+			start_ns = stats_now();
+			bench_apply_pnetids();
+		} else if (!strcmp(name, "print")) {
+			start_allocations = bench_allocations();
+			start_ns = stats_now();
+			bench_print();
+		} else if (strcmp(name, "discovery") && strcmp(name, "udev")) {
+			printf("Benchmark not found.\n");
+			return EXIT_FAILURE;
+		}
+		ns = stats_now() - start_ns;
+		allocations = bench_allocations() - start_allocations;
+
+		count = 0;
+		device = get_next_device(&devices_list);
+		for (; device; device = get_next_device(device))
+			count++;
+		free_devices();
+
+		total_ns += ns;
+		if (ns < min_ns)
+			min_ns = ns;
+	}
+
+	/* the devices of this system are not requested */
+	if (!devices)
+		devices = count;
+	printf("%s: %d devices (%d requested), %d runs, min %.3f ms, "
+	       "avg %.3f ms\n", name, count, devices, runs,
+	       min_ns / 1e6, total_ns / runs / 1e6);
+	if (json)
+		fprintf(json, "{\"benchmark\":\"%s %d\",\"devices\":%d,"
+			"\"runs\":%d,\"min_ms\":%.3f,\"avg_ms\":%.3f,"
+			"\"ns_per_device\":%.1f,\"allocations\":%lld,"
+			"\"maxrss_kb\":%ld}\n", name, devices, count, runs,
+			min_ns / 1e6, total_ns / runs / 1e6,
+			count ? (double) min_ns / count : 0,
+			(long long) (allocations < 0 ? -1 : allocations),
+			bench_maxrss_kb());
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+	struct fixture_config config;
+	char root[] = "/tmp/pnetctl_bench.XXXXXX";
+	int runs = BENCH_RUNS;
+	FILE *json = NULL;
+	int devices;
+	int rc;
+
+	/* append results as json lines to a file with -j <file> */
+	if (argc > 2 && !strcmp(argv[1], "-j")) {
+		json = bench_json_open(argv[2]);
+		if (!json) {
+			printf("Cannot open \"%s\".\n", argv[2]);
+			return EXIT_FAILURE;
+		}
+		argv[2] = argv[0];
+		argv += 2;
+		argc -= 2;
+	}
+	/* discovery of the devices of this system with udev like pnetctl
+	 * without --sysfs-root, the other benchmarks use the sysfs backend
+	 */
+	if (argc > 1 && !strcmp(argv[1], "udev")) {
+		if (argc > 2 && atoi(argv[2]) > 0)
+			runs = atoi(argv[2]);
+		rc = bench_run("udev", udev_scan_devices, 0, runs, json);
+		if (json && json != stdout)
+			fclose(json);
+		return rc;
+	}
+	if (argc < 3) {
+		printf("Usage: %s [-j <file>] <discovery|pnetids|print> "
+		       "<devices> [runs]\n"
+		       "       %s [-j <file>] udev [runs]\n"
+		       "       %s create <devices> <dir>\n", argv[0], argv[0],
+		       argv[0]);
+		return EXIT_FAILURE;
+	}
+	devices = atoi(argv[2]);
+	fixture_config_for_size(&config, devices);
+
+	/* only create a fixture in dir */
+	if (!strcmp(argv[1], "create")) {
+		if (argc < 4 || fixture_create(argv[3], &config))
+			return EXIT_FAILURE;
+		return EXIT_SUCCESS;
+	}
+
+	if (argc > 3 && atoi(argv[3]) > 0)
+		runs = atoi(argv[3]);
+	if (!mkdtemp(root) || fixture_create(root, &config)) {
+		printf("Cannot create fixture in \"%s\".\n", root);
+		fixture_remove(root);
+		return EXIT_FAILURE;
+	}
+	sysfs_root = root;
+	rc = bench_run(argv[1], sysfs_scan_devices, devices, runs, json);
+	fixture_remove(root);
+	if (json && json != stdout)
+		fclose(json);
+	return rc;
+}
@@ -0,0 +1,160 @@
+/*
+ * *******************
+ * *** EXPORT PART ***
+ * *******************
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "export.h"
+#include "devices.h"
+#include "verbose.h"
+
+/* print help and type lines of a metric */
+static void export_header(FILE *file, const char *name, const char *type,
+			  const char *help) {
+	fprintf(file, "# HELP pnetctl_%s %s\n", name, help);
+	fprintf(file, "# TYPE pnetctl_%s %s\n", name, type);
+}
+
+/* compare devices by pnetid */
+static int export_cmp_pnetid(const void *a, const void *b) {
+	const struct device *x = *(struct device * const *) a;
+	const struct device *y = *(struct device * const *) b;
+
+	return strncmp(x->pnetid, y->pnetid, SMC_MAX_PNETID_LEN);
+}
+
+/* print the number of devices of each kind with the pnetid of devices, the
+ * devices with the same pnetid are adjacent
+ */
+static void export_pnetids(FILE *file, struct device **devices, int count) {
+	int counts[DEVICE_KIND_MAX];
+	int next;
+
+	for (int i = 0; i < count; i = next) {
+		memset(counts, 0, sizeof(counts));
+		next = i;
+		while (next < count &&
+		       !export_cmp_pnetid(&devices[i], &devices[next]))
+			counts[devices[next++]->kind]++;
+		for (int kind = DEVICE_KIND_NET; kind < DEVICE_KIND_MAX; kind++)
+			if (counts[kind])
+				fprintf(file, "pnetctl_devices{pnetid=\"%s\","
+					"type=\"%s\"} %d\n",
+					devices[i]->pnetid,
+					device_kind_labels[kind],
+					counts[kind]);
+	}
+}
+
+/* print the metrics of the devices in devices list */
+static int export_devices(FILE *file) {
+	int without[DEVICE_KIND_MAX] = {0};
+	struct device **devices;
+	struct device *device;
+	int mismatches = 0;
+	int count = 0;
+
+	device = get_next_device(&devices_list);
+	for (; device; device = get_next_device(device))
+		count++;
+	devices = calloc(count + 1, sizeof(*devices));
+	if (!devices)
+		return -1;
+
+	/* sort the devices with pnetid once to count them by pnetid */
+	count = 0;
+	device = get_next_device(&devices_list);
+	for (; device; device = get_next_device(device)) {
+		if (!device->pnetid[0]) {
+			without[device->kind]++;
+			continue;
+		}
+		if (device->util_pnetid[0] &&
+		    strncmp(device->util_pnetid, device->pnetid,
+			    SMC_MAX_PNETID_LEN))
+			mismatches++;
+		devices[count++] = device;
+	}
+	qsort(devices, count, sizeof(*devices), export_cmp_pnetid);
+
+	export_header(file, "devices", "gauge",
+		      "Number of devices with pnetid.");
+	export_pnetids(file, devices, count);
+	free(devices);
+
+	export_header(file, "devices_without_pnetid", "gauge",
+		      "Number of devices without pnetid.");
+	for (int kind = DEVICE_KIND_NET; kind < DEVICE_KIND_MAX; kind++)
+		fprintf(file, "pnetctl_devices_without_pnetid{type=\"%s\"} "
+			"%d\n", device_kind_labels[kind], without[kind]);
+
+	export_header(file, "pnetid_mismatches", "gauge",
+		      "Number of devices with a util_string pnetid that "
+		      "differs from the netlink pnetid.");
+	fprintf(file, "pnetctl_pnetid_mismatches %d\n", mismatches);
+	return 0;
+}
+
+/* print the durations and counts of scans and dumps */
+static void export_durations(FILE *file, struct export_stats *export_stats) {
+	export_header(file, "scan_duration_seconds", "gauge",
+		      "Duration of the last device scan.");
+	fprintf(file, "pnetctl_scan_duration_seconds %.9f\n",
+		export_stats->scan_ns / 1e9);
+	export_header(file, "dump_duration_seconds", "gauge",
+		      "Duration of the last netlink dump of pnetids.");
+	fprintf(file, "pnetctl_dump_duration_seconds %.9f\n",
+		export_stats->dump_ns / 1e9);
+	export_header(file, "scans_total", "counter",
+		      "Number of device scans.");
+	fprintf(file, "pnetctl_scans_total %llu\n",
+		(unsigned long long) export_stats->scans);
+	export_header(file, "dumps_total", "counter",
+		      "Number of netlink dumps of pnetids.");
+	fprintf(file, "pnetctl_dumps_total %llu\n",
+		(unsigned long long) export_stats->dumps);
+}
+
+/* write the metrics of devices list and export_stats in prometheus text
+ * format to a temporary file and move it to path, so the textfile collector
+ * never reads a partial file
+ */
+int export_write(const char *path, struct export_stats *export_stats) {
+	char tmp_path[strlen(path) + 5];
+	FILE *file;
+	int fd;
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd == -1)
+		return -1;
+	file = fdopen(fd, "w");
+	if (!file) {
+		close(fd);
+		unlink(tmp_path);
+		return -1;
+	}
+	if (export_devices(file)) {
+		fclose(file);
+		unlink(tmp_path);
+		return -1;
+	}
+	export_durations(file, export_stats);
+	if (fflush(file) || ferror(file) || fsync(fd)) {
+		fclose(file);
+		unlink(tmp_path);
+		return -1;
+	}
+	if (fclose(file) || rename(tmp_path, path)) {
+		unlink(tmp_path);
+		return -1;
+	}
+	log_debug("Exported metrics to \"%s\".\n", path);
+	return 0;
+}
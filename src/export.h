@@ -0,0 +1,19 @@
+#ifndef _PNETCTL_EXPORT_H
+#define _PNETCTL_EXPORT_H
+
+#include <stdint.h>
+
+/* default path in the directory of the node exporter textfile collector */
+#define EXPORT_PATH "/var/lib/prometheus/node-exporter/pnetctl.prom"
+
+/* durations and counts of the device scans and netlink dumps of the daemon */
+struct export_stats {
+	uint64_t scan_ns;
+	uint64_t dump_ns;
+	uint64_t scans;
+	uint64_t dumps;
+};
+
+int export_write(const char *path, struct export_stats *export_stats);
+
+#endif
@@ -0,0 +1,97 @@
+/*
+ * test for export
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "test.h"
+#include "export.h"
+#include "devices.h"
+
+#define TEST_EXPORT "/tmp/pnetctl_test.prom"
+
+// check if file contains line
+static int contains_line(const char *path, const char *line) {
+	char buffer[256];
+	FILE *file;
+	int found = 0;
+
+	file = fopen(path, "r");
+	if (!file)
+		return 0;
+	while (!found && fgets(buffer, sizeof(buffer), file)) {
+		buffer[strcspn(buffer, "\n")] = 0;
+		found = !strcmp(buffer, line);
+	}
+	fclose(file);
+	return found;
+}
+
+// test the function export_write()
+int test_export_write() {
+	struct export_stats export_stats = {
+		.scan_ns = 1500000000,
+		.dump_ns = 2000000,
+		.scans = 1,
+		.dumps = 3,
+	};
+	const char *lines[] = {
+		"pnetctl_devices{pnetid=\"PNET0\",type=\"net\"} 2",
+		"pnetctl_devices{pnetid=\"PNET0\",type=\"ib\"} 1",
+		"pnetctl_devices{pnetid=\"PNET1\",type=\"ism\"} 1",
+		"pnetctl_devices_without_pnetid{type=\"net\"} 1",
+		"pnetctl_devices_without_pnetid{type=\"ib\"} 0",
+		"pnetctl_pnetid_mismatches 1",
+		"pnetctl_scan_duration_seconds 1.500000000",
+		"pnetctl_dump_duration_seconds 0.002000000",
+		"pnetctl_scans_total 1",
+		"pnetctl_dumps_total 3",
+	};
+	struct device *device;
+	int rc = -1;
+
+	device = test_add_device("net", "eth0", -1, NULL, "PNET0");
+	strcpy(device->util_pnetid, "PNET0");
+	test_add_device("infiniband", "mlx5_0", 1, NULL, "PNET0");
+	device = test_add_device("net", "eth1", -1, NULL, "PNET0");
+	strcpy(device->util_pnetid, "PNET2");
+	device = test_add_device("ism", "0000:00:00.5", -1, NULL, "PNET1");
+	strcpy(device->util_pnetid, "PNET1");
+	test_add_device("net", "eth2", -1, NULL, "");
+
+	unlink(TEST_EXPORT);
+	if (export_write(TEST_EXPORT, &export_stats))
+		goto out;
+	for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++) {
+		if (!contains_line(TEST_EXPORT, lines[i])) {
+			printf("Missing line \"%s\".\n", lines[i]);
+			goto out;
+		}
+	}
+
+	// temporary file is moved to path
+	if (!access(TEST_EXPORT ".tmp", F_OK))
+		goto out;
+
+	// directory of path does not exist
+	if (!export_write("/tmp/pnetctl_test_missing/pnetctl.prom",
+			  &export_stats))
+		goto out;
+	rc = 0;
+out:
+	unlink(TEST_EXPORT);
+	free_devices();
+	return rc;
+}
+
+struct test tests[] = {
+	{"export_write", test_export_write},
+	{NULL, NULL},
+};
+
+int main(int argc, char** argv) {
+	return run_test(tests, argc, argv);
+}
@@ -0,0 +1,348 @@
+/*
+ * *******************
+ * *** FILTER PART ***
+ * *******************
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+
+#include "filter.h"
+#include "verbose.h"
+
+/* names of fields in filter expressions */
+static const char *filter_field_names[FILTER_FIELD_MAX] = {
+	[FILTER_FIELD_PNETID] = "pnetid",
+	[FILTER_FIELD_NAME] = "name",
+	[FILTER_FIELD_TYPE] = "type",
+	[FILTER_FIELD_BUS] = "bus",
+	[FILTER_FIELD_PARENT] = "parent",
+	[FILTER_FIELD_PORT] = "port",
+};
+
+/* fields known before a device is resolved during discovery */
+#define FILTER_DISCOVERY_FIELDS ((1 << FILTER_FIELD_NAME) | \
+				 (1 << FILTER_FIELD_TYPE) | \
+				 (1 << FILTER_FIELD_BUS) | \
+				 (1 << FILTER_FIELD_PARENT))
+#define FILTER_ALL_FIELDS ((1 << FILTER_FIELD_MAX) - 1)
+
+/* filter checked during device discovery */
+struct filter *discovery_filter;
+
+/* fnv-1a hash of string */
+static uint32_t filter_hash(const char *s) {
+	uint32_t hash = 2166136261u;
+
+	for (; *s; s++)
+		hash = (hash ^ (unsigned char) *s) * 16777619u;
+	return hash;
+}
+
+/* find the slot of string s in set, empty if s is not in the set */
+static char **filter_set_slot(struct filter_set *set, const char *s) {
+	uint32_t i = filter_hash(s) & set->mask;
+
+	while (set->slots[i] && strcmp(set->slots[i], s))
+		i = (i + 1) & set->mask;
+	return &set->slots[i];
+}
+
+/* add string s to set */
+static void filter_set_add(struct filter_set *set, char *s) {
+	char **slot = filter_set_slot(set, s);
+
+	if (*slot)
+		free(s);
+	else
+		*slot = s;
+}
+
+/* check if string s is in set */
+static int filter_set_contains(struct filter_set *set, const char *s) {
+	return *filter_set_slot(set, s) != NULL;
+}
+
+/* skip white space in expression */
+static const char *filter_skip_space(const char *p) {
+	while (isspace((unsigned char) *p))
+		p++;
+	return p;
+}
+
+/* read a lowercase word like a field name or keyword */
+static const char *filter_word(const char *p, char *word, size_t len) {
+	size_t n = strspn(p, "abcdefghijklmnopqrstuvwxyz_");
+
+	if (n >= len)
+		n = len - 1;
+	memcpy(word, p, n);
+	word[n] = 0;
+	return p + n;
+}
+
+/* read a value up to white space or one of the stop characters */
+static const char *filter_value(const char *p, const char *stop,
+				char **value) {
+	size_t n = 0;
+
+	while (p[n] && !isspace((unsigned char) p[n]) && !strchr(stop, p[n]))
+		n++;
+	*value = n ? strndup(p, n) : NULL;
+	return p + n;
+}
+
+/* parse the value list of an "in" predicate into its set */
+static const char *filter_parse_set(const char *p, struct filter_pred *pred) {
+	char *values[256];
+	uint32_t size = 4;
+	int count = 0;
+	char *value;
+
+	if (*p != '{')
+		return NULL;
+	do {
+		p = filter_skip_space(p + 1);
+		p = filter_value(p, ",}", &value);
+		if (!value || count == 256)
+			goto fail;
+		values[count++] = value;
+		p = filter_skip_space(p);
+	} while (*p == ',');
+	if (*p != '}')
+		goto fail;
+
+	/* keep the set at most half full */
+	while (size < 2 * count)
+		size *= 2;
+	pred->set.slots = calloc(size, sizeof(char *));
+	if (!pred->set.slots)
+		goto fail;
+	pred->set.mask = size - 1;
+	for (int i = 0; i < count; i++)
+		filter_set_add(&pred->set, values[i]);
+	return p + 1;
+fail:
+	for (int i = 0; i < count; i++)
+		free(values[i]);
+	return NULL;
+}
+
+/* parse a predicate like "[not] <field> (=|!=|~|in) <value>" */
+static const char *filter_parse_pred(const char *p, struct filter_pred *pred) {
+	char word[16];
+
+	p = filter_word(filter_skip_space(p), word, sizeof(word));
+	if (!strcmp(word, "not")) {
+		pred->negate = 1;
+		p = filter_word(filter_skip_space(p), word, sizeof(word));
+	}
+	for (pred->field = 0; pred->field < FILTER_FIELD_MAX; pred->field++)
+		if (!strcmp(word, filter_field_names[pred->field]))
+			break;
+	if (pred->field == FILTER_FIELD_MAX)
+		return NULL;
+
+	p = filter_skip_space(p);
+	if (*p == '=') {
+		pred->op = FILTER_OP_EQ;
+		p++;
+	} else if (!strncmp(p, "!=", 2)) {
+		pred->op = FILTER_OP_EQ;
+		pred->negate = !pred->negate;
+		p += 2;
+	} else if (*p == '~') {
+		pred->op = FILTER_OP_REGEX;
+		p++;
+	} else if (!strncmp(p, "in", 2)) {
+		pred->op = FILTER_OP_IN;
+		return filter_parse_set(filter_skip_space(p + 2), pred);
+	} else {
+		return NULL;
+	}
+
+	p = filter_value(filter_skip_space(p), "", &pred->value);
+	if (!pred->value)
+		return NULL;
+	if (pred->op == FILTER_OP_REGEX &&
+	    regcomp(&pred->regex, pred->value, REG_EXTENDED | REG_NOSUB)) {
+		free(pred->value);
+		pred->value = NULL;
+		return NULL;
+	}
+	return p;
+}
+
+/* compile filter expression like
+ * "pnetid in {A,B} and type=ib or not name~^mlx5"
+ * into predicates, "and" binds stronger than "or"
+ */
+struct filter *filter_compile(const char *expr) {
+	struct filter_pred *new_preds;
+	struct filter *filter;
+	const char *p = expr;
+	char word[16];
+	int or = 0;
+
+	filter = calloc(1, sizeof(*filter));
+	if (!filter)
+		return NULL;
+	for (;;) {
+		new_preds = realloc(filter->preds, (filter->num_preds + 1) *
+				    sizeof(*filter->preds));
+		if (!new_preds)
+			goto fail;
+		filter->preds = new_preds;
+		memset(&filter->preds[filter->num_preds], 0,
+		       sizeof(*filter->preds));
+		filter->preds[filter->num_preds].or = or;
+		p = filter_parse_pred(p, &filter->preds[filter->num_preds]);
+		if (!p)
+			goto fail;
+		filter->num_preds++;
+
+		p = filter_skip_space(p);
+		if (!*p)
+			break;
+		p = filter_word(p, word, sizeof(word));
+		if (strcmp(word, "and") && strcmp(word, "or"))
+			goto fail;
+		or = !strcmp(word, "or");
+	}
+	log_debug("Compiled filter \"%s\" into %d predicates.\n", expr,
+		  filter->num_preds);
+	return filter;
+fail:
+	log_error("Invalid filter \"%s\".\n", expr);
+	filter_free(filter);
+	return NULL;
+}
+
+/* free compiled filter */
+void filter_free(struct filter *filter) {
+	struct filter_pred *pred;
+
+	if (!filter)
+		return;
+	for (int i = 0; i < filter->num_preds; i++) {
+		pred = &filter->preds[i];
+		if (pred->op == FILTER_OP_REGEX && pred->value)
+			regfree(&pred->regex);
+		free(pred->value);
+		if (pred->set.slots) {
+			for (uint32_t j = 0; j <= pred->set.mask; j++)
+				free(pred->set.slots[j]);
+			free(pred->set.slots);
+		}
+	}
+	free(filter->preds);
+	free(filter);
+}
+
+/* get the value of field of device as in the device table */
+static const char *filter_field_value(struct device *device, int field,
+				      char *buffer, size_t len) {
+	switch (field) {
+	case FILTER_FIELD_PNETID:
+		return device->pnetid[0] ? device->pnetid : "n/a";
+	case FILTER_FIELD_NAME:
+		return device->name;
+	case FILTER_FIELD_TYPE:
+		return device_kind_labels[device->kind];
+	case FILTER_FIELD_BUS:
+		return device->parent_subsystem ? device->parent_subsystem :
+			"n/a";
+	case FILTER_FIELD_PARENT:
+		return device->parent ? device->parent : "n/a";
+	case FILTER_FIELD_PORT:
+		if (device->kind != DEVICE_KIND_IB)
+			return "n/a";
+		snprintf(buffer, len, "%d", device->ib_port);
+		return buffer;
+	}
+	return "";
+}
+
+/* check if predicate matches device */
+static int filter_pred_match(struct filter_pred *pred,
+			     struct device *device) {
+	const char *value;
+	char buffer[16];
+
+	value = filter_field_value(device, pred->field, buffer,
+				   sizeof(buffer));
+	switch (pred->op) {
+	case FILTER_OP_EQ:
+		return !strcmp(value, pred->value);
+	case FILTER_OP_REGEX:
+		return !regexec(&pred->regex, value, 0, NULL, 0);
+	case FILTER_OP_IN:
+		return filter_set_contains(&pred->set, value);
+	}
+	return 0;
+}
+
+/* evaluate filter on device, predicates on fields that are not in known
+ * count as matching
+ */
+static int filter_eval(struct filter *filter, struct device *device,
+		       int known) {
+	struct filter_pred *pred;
+	int clause = 1;
+
+	for (int i = 0; i < filter->num_preds; i++) {
+		pred = &filter->preds[i];
+		if (pred->or) {
+			if (clause)
+				return 1;
+			clause = 1;
+		}
+		if (!clause || !(known & (1 << pred->field)))
+			continue;
+		clause = filter_pred_match(pred, device) != pred->negate;
+	}
+	return clause;
+}
+
+/* check if device matches filter */
+int filter_match(struct filter *filter, struct device *device) {
+	return filter_eval(filter, device, FILTER_ALL_FIELDS);
+}
+
+/* check if a device found during discovery may match the discovery filter,
+ * before its lower device and util_string are resolved
+ */
+int filter_may_discover(int kind, const char *name, const char *parent,
+			const char *parent_subsystem) {
+	struct device device = {
+		.name = name,
+		.parent = parent,
+		.parent_subsystem = parent_subsystem,
+		.kind = kind,
+		.ib_port = -1,
+	};
+
+	if (!discovery_filter)
+		return 1;
+	if (filter_eval(discovery_filter, &device, FILTER_DISCOVERY_FIELDS))
+		return 1;
+	log_debug("Skipping device \"%s\" not matching filter.\n", name);
+	return 0;
+}
+
+/* remove devices not matching filter from devices list in one pass */
+void filter_devices(struct filter *filter) {
+	struct device *prev = &devices_list;
+	struct device *device;
+
+	while ((device = get_next_device(prev))) {
+		if (filter_match(filter, device)) {
+			prev = device;
+			continue;
+		}
+		prev->next = device->next;
+		free_device(device);
+	}
+}
@@ -0,0 +1,65 @@
+#ifndef _PNETCTL_FILTER_H
+#define _PNETCTL_FILTER_H
+
+#include <stdint.h>
+#include <regex.h>
+
+#include "devices.h"
+
+/* device fields in filter expressions */
+enum filter_fields {
+	FILTER_FIELD_PNETID,
+	FILTER_FIELD_NAME,
+	FILTER_FIELD_TYPE,
+	FILTER_FIELD_BUS,
+	FILTER_FIELD_PARENT,
+	FILTER_FIELD_PORT,
+	FILTER_FIELD_MAX,
+};
+
+/* operators of predicates */
+enum filter_ops {
+	FILTER_OP_EQ, /* field=value */
+	FILTER_OP_REGEX, /* field~regex */
+	FILTER_OP_IN, /* field in {value,...} */
+};
+
+/* hashed set of strings with open addressing */
+struct filter_set {
+	char **slots;
+	uint32_t mask;
+};
+
+/* compiled predicate, a predicate with "or" starts a new clause */
+struct filter_pred {
+	int field;
+	int op;
+	int negate;
+	int or;
+	char *value;
+	regex_t regex;
+	struct filter_set set;
+};
+
+/* compiled filter expression, clauses of predicates joined with "and" are
+ * joined with "or"
+ */
+struct filter {
+	struct filter_pred *preds;
+	int num_preds;
+};
+
+/* only print devices matching this filter, if set */
+extern struct filter *device_filter;
+
+/* filter checked during device discovery before resolving devices, if set */
+extern struct filter *discovery_filter;
+
+struct filter *filter_compile(const char *expr);
+void filter_free(struct filter *filter);
+int filter_match(struct filter *filter, struct device *device);
+int filter_may_discover(int kind, const char *name, const char *parent,
+			const char *parent_subsystem);
+void filter_devices(struct filter *filter);
+
+#endif
@@ -0,0 +1,173 @@
+/*
+ * test for filter
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "test.h"
+#include "devices.h"
+#include "filter.h"
+
+/* check if expression matches device as expected */
+static int check_match(const char *expr, struct device *device,
+		       int expected) {
+	struct filter *filter = filter_compile(expr);
+	int match;
+
+	if (!filter)
+		return -1;
+	match = filter_match(filter, device);
+	filter_free(filter);
+	if (match != expected) {
+		printf("Filter \"%s\" on \"%s\" is %d instead of %d.\n", expr,
+		       device->name, match, expected);
+		return -1;
+	}
+	return 0;
+}
+
+// test the function filter_compile()
+int test_filter_compile() {
+	const char *invalid[] = {
+		"",
+		"pnetid",
+		"color=red",
+		"name=eth0 and",
+		"name=eth0 nand type=net",
+		"pnetid in {}",
+		"pnetid in {A,B",
+		"name~(",
+	};
+	struct filter *filter;
+
+	filter = filter_compile("pnetid in {A, B,A} and type=ib or "
+				"not name~^mlx5 and port!=1");
+	if (!filter || filter->num_preds != 4 || !filter->preds[2].or ||
+	    !filter->preds[2].negate || !filter->preds[3].negate) {
+		filter_free(filter);
+		return -1;
+	}
+	filter_free(filter);
+
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+		filter = filter_compile(invalid[i]);
+		if (filter) {
+			printf("Filter \"%s\" is valid.\n", invalid[i]);
+			filter_free(filter);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+// test the function filter_match()
+int test_filter_match() {
+	struct device *eth0;
+	struct device *mlx0;
+	struct device *vlan0;
+	int rc = -1;
+
+	eth0 = test_add_device("net", "eth0", -1, "0000:3b:00.0", "PNET0");
+	mlx0 = test_add_device("infiniband", "mlx5_0", 1, "0000:3b:00.0",
+			       "PNET1");
+	vlan0 = test_add_device("net", "vlan0", -1, NULL, "");
+
+	if (check_match("pnetid in {PNET0,PNET1} and type=ib", eth0, 0) ||
+	    check_match("pnetid in {PNET0,PNET1} and type=ib", mlx0, 1) ||
+	    check_match("pnetid in {PNET2}", mlx0, 0) ||
+	    check_match("pnetid=n/a", vlan0, 1) ||
+	    check_match("bus=pci and name~^mlx5", mlx0, 1) ||
+	    check_match("bus=pci and name~^mlx5", eth0, 0) ||
+	    check_match("bus=n/a", vlan0, 1) ||
+	    check_match("parent=0000:3b:00.0 and port=1", mlx0, 1) ||
+	    check_match("port=1", eth0, 0) ||
+	    check_match("type=ib or name=eth0", eth0, 1) ||
+	    check_match("type=ib and port=2 or name=vlan0", mlx0, 0) ||
+	    check_match("type=ib and port=2 or name=vlan0", vlan0, 1) ||
+	    check_match("not type=net", eth0, 0) ||
+	    check_match("type!=net", mlx0, 1))
+		goto out;
+	rc = 0;
+out:
+	free_devices();
+	return rc;
+}
+
+// test the function filter_may_discover()
+int test_filter_may_discover() {
+	int rc = -1;
+
+	/* without a discovery filter all devices are discovered */
+	if (!filter_may_discover(DEVICE_KIND_NET, "eth0", NULL, NULL))
+		return -1;
+
+	/* predicates on the pnetid are not known during discovery */
+	discovery_filter = filter_compile("type=net and pnetid=PNET0");
+	if (!discovery_filter ||
+	    !filter_may_discover(DEVICE_KIND_NET, "eth0", NULL, NULL) ||
+	    filter_may_discover(DEVICE_KIND_IB, "mlx5_0", "0000:3b:00.0",
+				"pci"))
+		goto out;
+	filter_free(discovery_filter);
+
+	discovery_filter = filter_compile("bus=pci or name=lo");
+	if (!discovery_filter ||
+	    !filter_may_discover(DEVICE_KIND_NET, "eth0", "0000:3b:00.0",
+				 "pci") ||
+	    !filter_may_discover(DEVICE_KIND_NET, "lo", NULL, NULL) ||
+	    filter_may_discover(DEVICE_KIND_NET, "vlan0", NULL, NULL))
+		goto out;
+	rc = 0;
+out:
+	filter_free(discovery_filter);
+	discovery_filter = NULL;
+	return rc;
+}
+
+// test the function filter_devices()
+int test_filter_devices() {
+	struct filter *filter;
+	struct device *device;
+	int rc = -1;
+	int count = 0;
+
+	test_add_device("net", "eth0", -1, "0000:3b:00.0", "PNET0");
+	test_add_device("infiniband", "mlx5_0", 1, "0000:3b:00.0", "PNET0");
+	test_add_device("infiniband", "mlx5_0", 2, "0000:3b:00.0", "PNET1");
+	test_add_device("net", "vlan0", -1, NULL, "PNET0");
+
+	filter = filter_compile("pnetid=PNET0 and bus=pci");
+	if (!filter)
+		goto out;
+	filter_devices(filter);
+	filter_free(filter);
+
+	device = get_next_device(&devices_list);
+	for (; device; device = get_next_device(device)) {
+		if (strcmp(device->pnetid, "PNET0") || !device->parent)
+			goto out;
+		count++;
+	}
+	if (count != 2)
+		goto out;
+	rc = 0;
+out:
+	free_devices();
+	return rc;
+}
+
+struct test tests[] = {
+	{"filter_compile", test_filter_compile},
+	{"filter_match", test_filter_match},
+	{"filter_may_discover", test_filter_may_discover},
+	{"filter_devices", test_filter_devices},
+	{NULL, NULL},
+};
+
+int main(int argc, char** argv) {
+	return run_test(tests, argc, argv);
+}
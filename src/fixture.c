@@ -0,0 +1,336 @@
+/*
+ * ********************
+ * *** FIXTURE PART ***
+ * ********************
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <ftw.h>
+#include <sys/stat.h>
+
+#include "fixture.h"
+#include "common.h"
+
+#define FIXTURE_DIR_LEN 256 /* maximum length of device directories */
+
+/* root of the fixture that is currently created */
+static const char *fixture_root;
+
+/* write path and format arguments below the fixture root into buffer */
+#define fixture_path(buffer, ...) do {					\
+	int _len = snprintf(buffer, PATH_MAX, "%s/", fixture_root);	\
+	snprintf(buffer + _len, PATH_MAX - _len, __VA_ARGS__);		\
+} while (0)
+
+/* create directory path below the fixture root and all its parents */
+__attribute__((format(printf, 1, 2)))
+static int fixture_mkdir(const char *format, ...) {
+	char path[PATH_MAX];
+	va_list args;
+	int len;
+
+	len = snprintf(path, sizeof(path), "%s/", fixture_root);
+	va_start(args, format);
+	vsnprintf(path + len, sizeof(path) - len, format, args);
+	va_end(args);
+
+	for (char *p = path + len; *p; p++) {
+		if (*p != '/')
+			continue;
+		*p = 0;
+		if (mkdir(path, 0755) && access(path, F_OK))
+			return -1;
+		*p = '/';
+	}
+	if (mkdir(path, 0755) && access(path, F_OK))
+		return -1;
+	return 0;
+}
+
+/* create symlink at link pointing to target, both below the fixture root */
+static int fixture_link(const char *target, const char *link) {
+	char target_path[PATH_MAX];
+	char link_path[PATH_MAX];
+
+	fixture_path(target_path, "%s", target);
+	fixture_path(link_path, "%s", link);
+	return symlink(target_path, link_path);
+}
+
+/* write data to file below the fixture root */
+static int fixture_write(const char *file, const void *data, size_t len) {
+	char path[PATH_MAX];
+	int fd;
+	int rc;
+
+	fixture_path(path, "%s", file);
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd == -1)
+		return -1;
+	rc = write(fd, data, len) == len ? 0 : -1;
+	close(fd);
+	return rc;
+}
+
+/* convert uppercase letters and digits of ascii string to ebcdic */
+static void fixture_ebcdic(const char *ascii, char *ebcdic) {
+	for (; *ascii; ascii++, ebcdic++) {
+		char c = *ascii;
+
+		if (c >= 'A' && c <= 'I')
+			*ebcdic = 0xc1 + c - 'A';
+		else if (c >= 'J' && c <= 'R')
+			*ebcdic = 0xd1 + c - 'J';
+		else if (c >= 'S' && c <= 'Z')
+			*ebcdic = 0xe2 + c - 'S';
+		else if (c >= '0' && c <= '9')
+			*ebcdic = 0xf0 + c - '0';
+		else
+			*ebcdic = 0x40;
+	}
+}
+
+/* write pnetid number n as ebcdic util_string into directory */
+static int fixture_util_string(const char *dir, int n) {
+	char pnetid[SMC_MAX_PNETID_LEN + 1];
+	char ebcdic[SMC_MAX_PNETID_LEN];
+	char file[PATH_MAX];
+	int len;
+
+	len = snprintf(pnetid, sizeof(pnetid), "PNET%d", n % FIXTURE_PNETIDS);
+	fixture_ebcdic(pnetid, ebcdic);
+	snprintf(file, sizeof(file), "%s/util_string", dir);
+	return fixture_write(file, ebcdic, len);
+}
+
+/* create pci function number n bound to driver, returns its directory */
+static int fixture_pci(int n, const char *driver, char *dir, size_t len) {
+	char bus_id[16];
+	char path[PATH_MAX];
+	char link[PATH_MAX];
+
+	snprintf(bus_id, sizeof(bus_id), "%04x:%02x:%02x.%x", n / 65536,
+		 (n / 256) % 256, (n / 8) % 32, n % 8);
+	snprintf(dir, len, "devices/pci0000:00/%s", bus_id);
+	snprintf(path, sizeof(path), "bus/pci/drivers/%s", driver);
+	if (fixture_mkdir("%s", dir) || fixture_mkdir("%s", path))
+		return -1;
+
+	snprintf(link, sizeof(link), "%s/subsystem", dir);
+	if (fixture_link("bus/pci", link))
+		return -1;
+	snprintf(link, sizeof(link), "%s/driver", dir);
+	if (fixture_link(path, link))
+		return -1;
+
+	/* two numa nodes with four cpus each */
+	snprintf(path, sizeof(path), "%s/numa_node", dir);
+	if (fixture_write(path, n % 2 ? "1\n" : "0\n", 2))
+		return -1;
+	snprintf(path, sizeof(path), "%s/local_cpulist", dir);
+	if (fixture_write(path, n % 2 ? "4-7\n" : "0-3\n", 4))
+		return -1;
+	snprintf(path, sizeof(path), "bus/pci/devices/%s", bus_id);
+	return fixture_link(dir, path);
+}
+
+/* create class device name below parent directory */
+static int fixture_class_device(const char *class, const char *parent,
+				const char *name, char *dir, size_t len) {
+	char path[PATH_MAX];
+
+	snprintf(dir, len, "%s/%s/%s", parent, class, name);
+	if (fixture_mkdir("%s", dir))
+		return -1;
+	snprintf(path, sizeof(path), "%s/subsystem", dir);
+	if (fixture_link(!strcmp(class, "net") ? "class/net" :
+			 "class/infiniband", path))
+		return -1;
+	snprintf(path, sizeof(path), "class/%s/%s", class, name);
+	return fixture_link(dir, path);
+}
+
+/* create a pci net device */
+static int fixture_net(int n, int pci) {
+	char pci_dir[FIXTURE_DIR_LEN];
+	char dir[FIXTURE_DIR_LEN];
+	char path[PATH_MAX];
+	char name[32];
+
+	if (fixture_pci(pci, "mlx5_core", pci_dir, sizeof(pci_dir)))
+		return -1;
+	if (n % 2 == 0 && fixture_util_string(pci_dir, n / 2))
+		return -1;
+	snprintf(name, sizeof(name), "eth%d", n);
+	if (fixture_class_device("net", pci_dir, name, dir, sizeof(dir)))
+		return -1;
+	snprintf(path, sizeof(path), "%s/device", dir);
+	return fixture_link(pci_dir, path);
+}
+
+/* create a virtual net device on top of lower devices */
+static int fixture_virtual(const char *name, const char *lower1,
+			   const char *lower2) {
+	const char *lowers[] = {lower1, lower2};
+	char target[PATH_MAX];
+	char dir[FIXTURE_DIR_LEN];
+	char path[PATH_MAX];
+
+	if (fixture_class_device("net", "devices/virtual", name, dir,
+				 sizeof(dir)))
+		return -1;
+	for (int i = 0; i < 2; i++) {
+		if (!lowers[i])
+			continue;
+		snprintf(target, sizeof(target), "class/net/%s", lowers[i]);
+		snprintf(path, sizeof(path), "%s/lower_%s", dir, lowers[i]);
+		if (fixture_link(target, path))
+			return -1;
+	}
+	return 0;
+}
+
+/* create bond and vlan devices on net device pair n */
+static int fixture_stack(int n) {
+	char lower1[32];
+	char lower2[32];
+	char bond[32];
+	char vlan[32];
+
+	snprintf(lower1, sizeof(lower1), "eth%d", 2 * n);
+	snprintf(lower2, sizeof(lower2), "eth%d", 2 * n + 1);
+	snprintf(bond, sizeof(bond), "bond%d", n);
+	snprintf(vlan, sizeof(vlan), "bond%d.10", n);
+	if (fixture_virtual(bond, lower1, lower2))
+		return -1;
+	return fixture_virtual(vlan, bond, NULL);
+}
+
+/* create a pci infiniband device with ports */
+static int fixture_ib(int n, int pci, int ports) {
+	char pci_dir[FIXTURE_DIR_LEN];
+	char dir[FIXTURE_DIR_LEN];
+	char path[PATH_MAX];
+	char name[32];
+
+	if (fixture_pci(pci, "mlx5_core", pci_dir, sizeof(pci_dir)))
+		return -1;
+	if (fixture_util_string(pci_dir, n))
+		return -1;
+	snprintf(name, sizeof(name), "mlx5_%d", n);
+	if (fixture_class_device("infiniband", pci_dir, name, dir,
+				 sizeof(dir)))
+		return -1;
+	snprintf(path, sizeof(path), "%s/device", dir);
+	if (fixture_link(pci_dir, path))
+		return -1;
+	for (int i = 1; i <= ports; i++)
+		if (fixture_mkdir("%s/ports/%d", dir, i))
+			return -1;
+	return 0;
+}
+
+/* create a ccwgroup net device with a chpid */
+static int fixture_ccw(int n) {
+	char group_dir[FIXTURE_DIR_LEN];
+	char chp_dir[FIXTURE_DIR_LEN];
+	char dir[FIXTURE_DIR_LEN];
+	char path[PATH_MAX];
+	char chpid[8];
+	char name[32];
+	int len;
+
+	len = snprintf(chpid, sizeof(chpid), "%02x\n", n % 256);
+	snprintf(chp_dir, sizeof(chp_dir), "devices/css0/chp0.%02x", n % 256);
+	if (fixture_mkdir("%s", chp_dir) || fixture_util_string(chp_dir, n))
+		return -1;
+
+	snprintf(group_dir, sizeof(group_dir), "devices/qeth/0.0.%04x",
+		 (n * 3) % 65536);
+	if (fixture_mkdir("%s", group_dir))
+		return -1;
+	snprintf(path, sizeof(path), "%s/subsystem", group_dir);
+	if (fixture_link("bus/ccwgroup", path))
+		return -1;
+	snprintf(path, sizeof(path), "%s/chpid", group_dir);
+	if (fixture_write(path, chpid, len))
+		return -1;
+
+	snprintf(name, sizeof(name), "enc%d", n);
+	if (fixture_class_device("net", group_dir, name, dir, sizeof(dir)))
+		return -1;
+	snprintf(path, sizeof(path), "%s/device", dir);
+	return fixture_link(group_dir, path);
+}
+
+/* create a pci ism function */
+static int fixture_ism(int n, int pci) {
+	char pci_dir[FIXTURE_DIR_LEN];
+
+	if (fixture_pci(pci, "ism", pci_dir, sizeof(pci_dir)))
+		return -1;
+	return fixture_util_string(pci_dir, n);
+}
+
+/* get a configuration with a mix of device types for about devices */
+void fixture_config_for_size(struct fixture_config *config, int devices) {
+	memset(config, 0, sizeof(*config));
+	config->net_devices = devices * 4 / 10 > 2 ? devices * 4 / 10 : 2;
+	config->stacks = 1;
+	config->ib_devices = devices / 20 > 1 ? devices / 20 : 1;
+	config->ib_ports = 2;
+	config->ccw_devices = devices / 20 > 1 ? devices / 20 : 1;
+	config->ism_devices = devices / 20 > 1 ? devices / 20 : 1;
+}
+
+/* create a synthetic sysfs tree in root */
+int fixture_create(const char *root, struct fixture_config *config) {
+	const char *dirs[] = {"class/net", "class/infiniband",
+		"bus/pci/devices", "bus/ccwgroup", "devices/virtual/net",
+		"devices/css0", NULL};
+	int pci = 0;
+
+	fixture_root = root;
+	for (int i = 0; dirs[i]; i++)
+		if (fixture_mkdir("%s", dirs[i]))
+			return -1;
+	if (fixture_mkdir("kernel") ||
+	    fixture_write("kernel/uevent_seqnum", "1\n", 2))
+		return -1;
+
+	for (int i = 0; i < config->net_devices; i++)
+		if (fixture_net(i, pci++))
+			return -1;
+	for (int i = 0; config->stacks && i < config->net_devices / 2; i++)
+		if (fixture_stack(i))
+			return -1;
+	for (int i = 0; i < config->ib_devices; i++)
+		if (fixture_ib(i, pci++, config->ib_ports))
+			return -1;
+	for (int i = 0; i < config->ccw_devices; i++)
+		if (fixture_ccw(i))
+			return -1;
+	for (int i = 0; i < config->ism_devices; i++)
+		if (fixture_ism(i, pci++))
+			return -1;
+	return 0;
+}
+
+/* remove a file or directory in fixture_remove() */
+static int fixture_remove_entry(const char *path, const struct stat *st,
+				int flag, struct FTW *ftw) {
+	return remove(path);
+}
+
+/* remove the synthetic sysfs tree in root */
+int fixture_remove(const char *root) {
+	return nftw(root, fixture_remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+}
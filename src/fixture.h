@@ -0,0 +1,20 @@
+#ifndef _PNETCTL_FIXTURE_H
+#define _PNETCTL_FIXTURE_H
+
+#define FIXTURE_PNETIDS 32 /* number of different pnetids in util strings */
+
+/* configuration of a synthetic sysfs tree */
+struct fixture_config {
+	int net_devices; /* pci net devices */
+	int stacks; /* bond on each pair of net devices, vlan on each bond */
+	int ib_devices; /* pci infiniband devices */
+	int ib_ports; /* ports of each infiniband device */
+	int ccw_devices; /* ccwgroup net devices with chpids */
+	int ism_devices; /* pci ism functions */
+};
+
+void fixture_config_for_size(struct fixture_config *config, int devices);
+int fixture_create(const char *root, struct fixture_config *config);
+int fixture_remove(const char *root);
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * *****************
+ * *** LAZY PART ***
+ * *****************
+ */
+
+#include <dlfcn.h>
+
+#define PNETCTL_LAZY_IMPL
+#include "lazy.h"
+#include "verbose.h"
+
+/* library functions, set when the library is loaded */
+struct lazy_udev lazy_udev;
+struct lazy_nl lazy_nl;
+
+/* name and pointer of a library function */
+struct lazy_symbol {
+	const char *name;
+	void **ptr;
+};
+
+#define LAZY_UDEV_SYMBOL(name) {#name, (void **) &lazy_udev.name},
+#define LAZY_NL_SYMBOL(name) {#name, (void **) &lazy_nl.name},
+
+static struct lazy_symbol lazy_udev_symbols[] = {
+	LAZY_UDEV_SYMBOLS(LAZY_UDEV_SYMBOL)
+	{NULL, NULL},
+};
+
+static struct lazy_symbol lazy_nl_symbols[] = {
+	LAZY_NL_SYMBOLS(LAZY_NL_SYMBOL)
+	{NULL, NULL},
+};
+
+static struct lazy_symbol lazy_genl_symbols[] = {
+	LAZY_GENL_SYMBOLS(LAZY_NL_SYMBOL)
+	{NULL, NULL},
+};
+
+/* open library lib and resolve symbols, the library stays loaded */
+static int lazy_load(const char *lib, struct lazy_symbol *symbols) {
+	void *handle;
+
+	handle = dlopen(lib, RTLD_NOW | RTLD_GLOBAL);
+	if (!handle) {
+		log_error("Cannot load %s: %s\n", lib, dlerror());
+		return -1;
+	}
+	for (; symbols->name; symbols++) {
+		*symbols->ptr = dlsym(handle, symbols->name);
+		if (!*symbols->ptr) {
+			log_error("Cannot find %s in %s.\n", symbols->name,
+				  lib);
+			return -1;
+		}
+	}
+	log_debug("Loaded %s.\n", lib);
+	return 0;
+}
+
+/* load libudev if it is not loaded yet */
+int lazy_load_udev() {
+	static int loaded;
+
+#ifdef PNETCTL_NO_LAZY_LOAD
+	loaded = 1;
+#endif
+	if (loaded)
+		return 0;
+	if (lazy_load(LAZY_UDEV_LIB, lazy_udev_symbols))
+		return -1;
+	loaded = 1;
+	return 0;
+}
+
+/* load libnl-3 and libnl-genl-3 if they are not loaded yet */
+int lazy_load_nl() {
+	static int loaded;
+
+#ifdef PNETCTL_NO_LAZY_LOAD
+	loaded = 1;
+#endif
+	if (loaded)
+		return 0;
+	if (lazy_load(LAZY_NL_LIB, lazy_nl_symbols) ||
+	    lazy_load(LAZY_GENL_LIB, lazy_genl_symbols))
+		return -1;
+	loaded = 1;
+	return 0;
+}
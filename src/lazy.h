@@ -0,0 +1,174 @@
+#ifndef _PNETCTL_LAZY_H
+#define _PNETCTL_LAZY_H
+
+/* libudev and libnl are loaded on demand, so commands that do not need them
+ * do not pay for loading and relocating them at startup. Include this header
+ * after all other headers, it redirects the library functions to pointers
+ * that are set by lazy_load_udev() and lazy_load_nl().
+ */
+
+#include <libudev.h>
+#include <netlink/netlink.h>
+#include <netlink/socket.h>
+#include <netlink/msg.h>
+#include <netlink/attr.h>
+#include <netlink/genl/genl.h>
+#include <netlink/genl/ctrl.h>
+
+#define LAZY_UDEV_LIB "libudev.so.1"
+#define LAZY_NL_LIB "libnl-3.so.200"
+#define LAZY_GENL_LIB "libnl-genl-3.so.200"
+
+/* used functions of libudev */
+#define LAZY_UDEV_SYMBOLS(X) \
+	X(udev_device_get_action) \
+	X(udev_device_get_driver) \
+	X(udev_device_get_parent) \
+	X(udev_device_get_subsystem) \
+	X(udev_device_get_sysattr_list_entry) \
+	X(udev_device_get_sysname) \
+	X(udev_device_get_syspath) \
+	X(udev_device_get_udev) \
+	X(udev_device_new_from_subsystem_sysname) \
+	X(udev_device_new_from_syspath) \
+	X(udev_device_ref) \
+	X(udev_device_unref) \
+	X(udev_enumerate_add_match_subsystem) \
+	X(udev_enumerate_get_list_entry) \
+	X(udev_enumerate_new) \
+	X(udev_enumerate_scan_devices) \
+	X(udev_enumerate_unref) \
+	X(udev_list_entry_get_name) \
+	X(udev_list_entry_get_next) \
+	X(udev_monitor_enable_receiving) \
+	X(udev_monitor_filter_add_match_subsystem_devtype) \
+	X(udev_monitor_get_fd) \
+	X(udev_monitor_new_from_netlink) \
+	X(udev_monitor_receive_device) \
+	X(udev_monitor_unref) \
+	X(udev_new) \
+	X(udev_unref)
+
+/* used functions of libnl-3 */
+#define LAZY_NL_SYMBOLS(X) \
+	X(nl_cb_err) \
+	X(nl_cb_put) \
+	X(nl_cb_set) \
+	X(nl_close) \
+	X(nl_connect) \
+	X(nl_recvmsgs_default) \
+	X(nl_send_auto) \
+	X(nl_send_simple) \
+	X(nl_socket_alloc) \
+	X(nl_socket_disable_auto_ack) \
+	X(nl_socket_enable_auto_ack) \
+	X(nl_socket_free) \
+	X(nl_socket_get_cb) \
+	X(nl_socket_modify_cb) \
+	X(nla_get_string) \
+	X(nla_get_u32) \
+	X(nla_get_u8) \
+	X(nla_parse_nested) \
+	X(nla_put_string) \
+	X(nla_put_u8) \
+	X(nla_strlcpy) \
+	X(nlmsg_alloc) \
+	X(nlmsg_data) \
+	X(nlmsg_free) \
+	X(nlmsg_hdr) \
+	X(nlmsg_parse)
+
+/* used functions of libnl-genl-3 */
+#define LAZY_GENL_SYMBOLS(X) \
+	X(genl_connect) \
+	X(genl_ctrl_resolve) \
+	X(genl_send_simple) \
+	X(genlmsg_parse) \
+	X(genlmsg_put)
+
+/* function pointers with the types of the library functions */
+#define LAZY_DECLARE(name) __typeof__(name) *name;
+
+struct lazy_udev {
+	LAZY_UDEV_SYMBOLS(LAZY_DECLARE)
+};
+
+struct lazy_nl {
+	LAZY_NL_SYMBOLS(LAZY_DECLARE)
+	LAZY_GENL_SYMBOLS(LAZY_DECLARE)
+};
+
+extern struct lazy_udev lazy_udev;
+extern struct lazy_nl lazy_nl;
+
+int lazy_load_udev();
+int lazy_load_nl();
+
+#if !defined(PNETCTL_NO_LAZY_LOAD) && !defined(PNETCTL_LAZY_IMPL)
+#define udev_device_get_action lazy_udev.udev_device_get_action
+#define udev_device_get_driver lazy_udev.udev_device_get_driver
+#define udev_device_get_parent lazy_udev.udev_device_get_parent
+#define udev_device_get_subsystem lazy_udev.udev_device_get_subsystem
+#define udev_device_get_sysattr_list_entry \
+	lazy_udev.udev_device_get_sysattr_list_entry
+#define udev_device_get_sysname lazy_udev.udev_device_get_sysname
+#define udev_device_get_syspath lazy_udev.udev_device_get_syspath
+#define udev_device_get_udev lazy_udev.udev_device_get_udev
+#define udev_device_new_from_subsystem_sysname \
+	lazy_udev.udev_device_new_from_subsystem_sysname
+#define udev_device_new_from_syspath lazy_udev.udev_device_new_from_syspath
+#define udev_device_ref lazy_udev.udev_device_ref
+#define udev_device_unref lazy_udev.udev_device_unref
+#define udev_enumerate_add_match_subsystem \
+	lazy_udev.udev_enumerate_add_match_subsystem
+#define udev_enumerate_get_list_entry lazy_udev.udev_enumerate_get_list_entry
+#define udev_enumerate_new lazy_udev.udev_enumerate_new
+#define udev_enumerate_scan_devices lazy_udev.udev_enumerate_scan_devices
+#define udev_enumerate_unref lazy_udev.udev_enumerate_unref
+#define udev_list_entry_get_name lazy_udev.udev_list_entry_get_name
+#define udev_list_entry_get_next lazy_udev.udev_list_entry_get_next
+#define udev_monitor_enable_receiving lazy_udev.udev_monitor_enable_receiving
+#define udev_monitor_filter_add_match_subsystem_devtype \
+	lazy_udev.udev_monitor_filter_add_match_subsystem_devtype
+#define udev_monitor_get_fd lazy_udev.udev_monitor_get_fd
+#define udev_monitor_new_from_netlink lazy_udev.udev_monitor_new_from_netlink
+#define udev_monitor_receive_device lazy_udev.udev_monitor_receive_device
+#define udev_monitor_unref lazy_udev.udev_monitor_unref
+#define udev_new lazy_udev.udev_new
+#define udev_unref lazy_udev.udev_unref
+
+#define nl_cb_err lazy_nl.nl_cb_err
+#define nl_cb_put lazy_nl.nl_cb_put
+#define nl_cb_set lazy_nl.nl_cb_set
+#define nl_close lazy_nl.nl_close
+#define nl_connect lazy_nl.nl_connect
+#define nl_recvmsgs_default lazy_nl.nl_recvmsgs_default
+#define nl_send_auto lazy_nl.nl_send_auto
+#define nl_send_simple lazy_nl.nl_send_simple
+#define nl_socket_alloc lazy_nl.nl_socket_alloc
+#define nl_socket_disable_auto_ack lazy_nl.nl_socket_disable_auto_ack
+#define nl_socket_enable_auto_ack lazy_nl.nl_socket_enable_auto_ack
+#define nl_socket_free lazy_nl.nl_socket_free
+#define nl_socket_get_cb lazy_nl.nl_socket_get_cb
+#define nl_socket_modify_cb lazy_nl.nl_socket_modify_cb
+#define nla_get_string lazy_nl.nla_get_string
+#define nla_get_u32 lazy_nl.nla_get_u32
+#define nla_get_u8 lazy_nl.nla_get_u8
+#define nla_parse_nested lazy_nl.nla_parse_nested
+#define nla_put_string lazy_nl.nla_put_string
+#define nla_put_u8 lazy_nl.nla_put_u8
+#define nla_strlcpy lazy_nl.nla_strlcpy
+#define nlmsg_alloc lazy_nl.nlmsg_alloc
+#define nlmsg_data lazy_nl.nlmsg_data
+#define nlmsg_free lazy_nl.nlmsg_free
+#define nlmsg_hdr lazy_nl.nlmsg_hdr
+#define nlmsg_parse lazy_nl.nlmsg_parse
+
+#define genl_connect lazy_nl.genl_connect
+#define genl_ctrl_resolve lazy_nl.genl_ctrl_resolve
+#define genl_send_simple lazy_nl.genl_send_simple
+#define genlmsg_parse lazy_nl.genlmsg_parse
+#define genlmsg_put lazy_nl.genlmsg_put
+#endif
+
+#endif
@@ -0,0 +1,187 @@
+/*
+ * *********************
+ * *** LOCALITY PART ***
+ * *********************
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
+
+#include "locality.h"
+#include "stats.h"
+#include "sysfs.h"
+#include "verbose.h"
+
+/* names of locality levels */
+const char *locality_names[LOCALITY_MAX] = {
+	[LOCALITY_UNKNOWN] = "n/a",
+	[LOCALITY_REMOTE] = "remote",
+	[LOCALITY_NODE] = "node",
+	[LOCALITY_ROOT] = "root",
+	[LOCALITY_SWITCH] = "switch",
+};
+
+/* read the first line of the attribute of the pci device with bus_id */
+static int locality_read_attr(const char *bus_id, const char *attr,
+			      char *buffer, size_t len) {
+	char path[strlen(sysfs_root) + strlen(bus_id) + strlen(attr) + 32];
+	FILE *file;
+
+	snprintf(path, sizeof(path), "%s/bus/pci/devices/%s/%s", sysfs_root,
+		 bus_id, attr);
+	file = fopen(path, "r");
+	if (!file)
+		return -1;
+	stats_inc(STATS_SYSFS_READS);
+	if (!fgets(buffer, len, file)) {
+		fclose(file);
+		return -1;
+	}
+	fclose(file);
+	buffer[strcspn(buffer, "\n")] = 0;
+	return 0;
+}
+
+/* read numa node, local cpus, and the path of pci root and bridges above the
+ * pci parent of device
+ */
+void locality_read(struct device *device) {
+	char path[strlen(sysfs_root) + 32 +
+		  (device->parent ? strlen(device->parent) : 0)];
+	char devices[PATH_MAX];
+	char cpulist[PATH_MAX];
+	char resolved[PATH_MAX];
+	char numa_node[16];
+	size_t devices_len;
+	char *pci_path;
+	char *end;
+
+	if (device->bus != DEVICE_BUS_PCI || !device->parent ||
+	    device->locality)
+		return;
+
+	/* the pci root is the first directory starting with "pci" below the
+	 * devices directory, sysfs_root itself may contain "/pci"
+	 */
+	snprintf(path, sizeof(path), "%s/devices", sysfs_root);
+	if (!realpath(path, devices))
+		return;
+	devices_len = strlen(devices);
+	snprintf(path, sizeof(path), "%s/bus/pci/devices/%s", sysfs_root,
+		 device->parent);
+	if (!realpath(path, resolved) ||
+	    strncmp(resolved, devices, devices_len) ||
+	    resolved[devices_len] != '/')
+		return;
+	pci_path = strstr(resolved + devices_len, "/pci");
+	end = strrchr(resolved, '/');
+	if (!pci_path || pci_path == end)
+		return;
+	pci_path++;
+	*end = 0;
+
+	if (locality_read_attr(device->parent, "numa_node", numa_node,
+			       sizeof(numa_node)))
+		strcpy(numa_node, "-1");
+	if (locality_read_attr(device->parent, "local_cpulist", cpulist,
+			       sizeof(cpulist)))
+		cpulist[0] = 0;
+
+	device->locality = malloc(strlen(cpulist) + strlen(pci_path) + 2);
+	if (!device->locality)
+		return;
+	strcpy(device->locality, cpulist);
+	device->local_cpulist = device->locality;
+	device->pci_path = device->locality + strlen(cpulist) + 1;
+	strcpy((char *) device->pci_path, pci_path);
+	device->numa_node = atoi(numa_node);
+	log_debug("Read locality of device \"%s\": numa node %d, pci path "
+		  "\"%s\".\n", device->name, device->numa_node,
+		  device->pci_path);
+}
+
+/* read locality of all devices in devices list */
+void locality_read_devices() {
+	struct device *device = get_next_device(&devices_list);
+
+	for (; device; device = get_next_device(device))
+		locality_read(device);
+}
+
+/* get the locality level of devices a and b */
+int locality_level(struct device *a, struct device *b) {
+	size_t root_len;
+
+	if (!a->pci_path || !b->pci_path)
+		return LOCALITY_UNKNOWN;
+	if (!strcmp(a->pci_path, b->pci_path))
+		return LOCALITY_SWITCH;
+	root_len = strcspn(a->pci_path, "/");
+	if (root_len == strcspn(b->pci_path, "/") &&
+	    !strncmp(a->pci_path, b->pci_path, root_len))
+		return LOCALITY_ROOT;
+	/* a node of -1 means the firmware does not report it */
+	if (a->numa_node < 0 || b->numa_node < 0)
+		return LOCALITY_UNKNOWN;
+	if (a->numa_node == b->numa_node)
+		return LOCALITY_NODE;
+	return LOCALITY_REMOTE;
+}
+
+/* get the locality score of the devices with pnetid, that is the level of
+ * the worst net device with its best infiniband or ism partner
+ */
+int locality_score(const char *pnetid) {
+	struct device **partners = NULL;
+	struct device **nets = NULL;
+	struct device **new_group;
+	int score = LOCALITY_MAX;
+	int num_partners = 0;
+	struct device *device;
+	int num_nets = 0;
+	int best;
+
+	/* collect the pci devices with pnetid first, stacked net devices
+	 * have no locality of their own
+	 */
+	device = get_next_device(&devices_list);
+	for (; device; device = get_next_device(device)) {
+		if (strncmp(device->pnetid, pnetid, SMC_MAX_PNETID_LEN) ||
+		    !device->pci_path)
+			continue;
+		if (device->kind == DEVICE_KIND_NET) {
+			new_group = realloc(nets, (num_nets + 1) *
+					    sizeof(*nets));
+			if (!new_group)
+				goto out;
+			nets = new_group;
+			nets[num_nets++] = device;
+		} else if (device->kind == DEVICE_KIND_IB ||
+			   device->kind == DEVICE_KIND_ISM) {
+			new_group = realloc(partners, (num_partners + 1) *
+					    sizeof(*partners));
+			if (!new_group)
+				goto out;
+			partners = new_group;
+			partners[num_partners++] = device;
+		}
+	}
+
+	for (int i = 0; i < num_nets; i++) {
+		best = LOCALITY_UNKNOWN;
+		for (int j = 0; j < num_partners; j++) {
+			int level = locality_level(nets[i], partners[j]);
+
+			if (level > best)
+				best = level;
+		}
+		if (best < score)
+			score = best;
+	}
+out:
+	free(nets);
+	free(partners);
+	return score == LOCALITY_MAX ? LOCALITY_UNKNOWN : score;
+}
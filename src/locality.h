@@ -0,0 +1,27 @@
+#ifndef _PNETCTL_LOCALITY_H
+#define _PNETCTL_LOCALITY_H
+
+#include "devices.h"
+
+/* locality of two devices, higher levels are closer */
+enum locality_levels {
+	LOCALITY_UNKNOWN, /* locality of a device is not known */
+	LOCALITY_REMOTE, /* different numa nodes */
+	LOCALITY_NODE, /* same numa node */
+	LOCALITY_ROOT, /* same pci root */
+	LOCALITY_SWITCH, /* same pci switch or bridge */
+	LOCALITY_MAX,
+};
+
+/* names of locality levels for output */
+extern const char *locality_names[LOCALITY_MAX];
+
+/* read and print locality of devices, disabled by default */
+extern int locality_mode;
+
+void locality_read(struct device *device);
+void locality_read_devices();
+int locality_level(struct device *a, struct device *b);
+int locality_score(const char *pnetid);
+
+#endif
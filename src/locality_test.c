@@ -0,0 +1,127 @@
+/*
+ * test for locality
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "test.h"
+#include "devices.h"
+#include "fixture.h"
+#include "locality.h"
+#include "sysfs.h"
+
+/* add a device with pnetid and locality to the devices list */
+static struct device *add_device(const char *subsystem, const char *name,
+				 const char *pnetid, const char *pci_path,
+				 int numa_node) {
+	struct device *device;
+
+	device = test_add_device(subsystem, name, -1, NULL, pnetid);
+	device->pci_path = pci_path;
+	device->numa_node = numa_node;
+	return device;
+}
+
+// test the function locality_read_devices()
+int test_locality_read_devices() {
+	struct fixture_config config = {
+		.net_devices = 2,
+		.stacks = 1,
+	};
+	/* the pci path must not start in a sysfs root containing "/pci" */
+	char root[] = "/tmp/pci_pnetctl_test_locality.XXXXXX";
+	struct device *device;
+	int rc = -1;
+
+	if (!mkdtemp(root))
+		return -1;
+	if (fixture_create(root, &config))
+		goto out;
+	sysfs_root = root;
+	if (sysfs_scan_devices())
+		goto out;
+	locality_read_devices();
+
+	/* pci devices have a locality, stacked devices do not */
+	device = get_next_device(&devices_list);
+	for (; device; device = get_next_device(device)) {
+		if (!strcmp(device->name, "eth1") &&
+		    (!device->pci_path || device->numa_node != 1 ||
+		     strcmp(device->local_cpulist, "4-7") ||
+		     strcmp(device->pci_path, "pci0000:00"))) {
+			printf("Locality of %s is wrong.\n", device->name);
+			goto out;
+		}
+		if (!strcmp(device->name, "bond0") && device->pci_path) {
+			printf("Locality of %s is wrong.\n", device->name);
+			goto out;
+		}
+	}
+	rc = 0;
+out:
+	free_devices();
+	sysfs_root = SYSFS_ROOT;
+	fixture_remove(root);
+	return rc;
+}
+
+// test the functions locality_level() and locality_score()
+int test_locality_score() {
+	struct device *eth0;
+	struct device *eth1;
+	struct device *eth2;
+	struct device *mlx0;
+	struct device *mlx1;
+	struct device *eth4;
+	struct device *mlx4;
+	int rc = -1;
+
+	eth0 = add_device("net", "eth0", "PNET0", "pci0000:00/0000:00:01.0",
+			  0);
+	mlx0 = add_device("infiniband", "mlx5_0", "PNET0",
+			  "pci0000:00/0000:00:01.0", 0);
+	eth1 = add_device("net", "eth1", "PNET1", "pci0000:00/0000:00:02.0",
+			  0);
+	mlx1 = add_device("infiniband", "mlx5_1", "PNET1", "pci0000:80", 1);
+	eth2 = add_device("net", "eth2", "PNET1", "pci0000:40", 0);
+	add_device("net", "bond0", "PNET1", NULL, 0);
+	add_device("net", "eth3", "PNET2", "pci0000:00", 0);
+	eth4 = add_device("net", "eth4", "PNET3", "pci0000:c0", -1);
+	mlx4 = add_device("infiniband", "mlx5_4", "PNET3", "pci0000:d0", -1);
+
+	if (locality_level(eth0, mlx0) != LOCALITY_SWITCH ||
+	    locality_level(eth0, eth1) != LOCALITY_ROOT ||
+	    locality_level(eth1, eth2) != LOCALITY_NODE ||
+	    locality_level(eth1, mlx1) != LOCALITY_REMOTE)
+		goto out;
+
+	/* unknown numa nodes do not count as the same node */
+	if (locality_level(eth4, mlx4) != LOCALITY_UNKNOWN ||
+	    locality_level(eth4, eth1) != LOCALITY_UNKNOWN ||
+	    locality_score("PNET3") != LOCALITY_UNKNOWN)
+		goto out;
+
+	/* the worst net device counts, stacked devices are ignored */
+	if (locality_score("PNET0") != LOCALITY_SWITCH ||
+	    locality_score("PNET1") != LOCALITY_REMOTE ||
+	    locality_score("PNET2") != LOCALITY_UNKNOWN)
+		goto out;
+	rc = 0;
+out:
+	free_devices();
+	return rc;
+}
+
+struct test tests[] = {
+	{"locality_read_devices", test_locality_read_devices},
+	{"locality_score", test_locality_score},
+	{NULL, NULL},
+};
+
+int main(int argc, char** argv) {
+	return run_test(tests, argc, argv);
+}
@@ -1,6 +1,8 @@
 #include <stdlib.h>
 
 #include "cmd.h"
+#include "stats.h"
+#include "trace.h"
 
 /* main function */
 int main(int argc, char **argv) {
@@ -9,5 +11,9 @@ int main(int argc, char **argv) {
 	/* parse command line arguments and run everything else from there */
 	rc = parse_cmd_line(argc, argv);
 
+	/* print statistics summary if requested */
+	stats_print();
+	trace_close();
+
 	exit(rc);
 }
@@ -0,0 +1,115 @@
+/*
+ * micro-benchmarks of device list operations, run with the test runner,
+ * e.g., "micro_bench -r 1000 -w 10"
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "test.h"
+#include "devices.h"
+#include "filter.h"
+#include "pairing.h"
+#include "probe.h"
+
+#define MICRO_DEVICES 1000 /* number of devices in the devices list */
+#define MICRO_PNETIDS 16 /* number of different pnetids of the devices */
+
+/* names and parents of the devices */
+static char micro_names[MICRO_DEVICES][16];
+static char micro_parents[MICRO_DEVICES][16];
+
+/* filter of the filter_match benchmark */
+static struct filter *micro_filter;
+
+/* add net and infiniband devices with pnetids to the devices list */
+static int micro_add_devices() {
+	struct device *device;
+
+	for (int i = 0; i < MICRO_DEVICES; i++) {
+		device = new_device();
+		if (!device)
+			return -1;
+		snprintf(micro_parents[i], sizeof(micro_parents[i]),
+			 "0000:%02x:00.%d", i / 8 % 256, i % 8);
+		if (i % 2) {
+			snprintf(micro_names[i], sizeof(micro_names[i]),
+				 "mlx5_%d", i / 2);
+			device->subsystem = "infiniband";
+			device->ib_port = 1;
+		} else {
+			snprintf(micro_names[i], sizeof(micro_names[i]),
+				 "eth%d", i / 2);
+			device->subsystem = "net";
+			device->lowest = micro_names[i];
+			device->ib_port = -1;
+		}
+		device->name = micro_names[i];
+		device->parent = micro_parents[i];
+		device->parent_subsystem = "pci";
+		snprintf(device->pnetid, sizeof(device->pnetid), "PNET%d",
+			 i % MICRO_PNETIDS);
+		classify_device(device);
+	}
+	return 0;
+}
+
+// benchmark the function set_pnetid_for_eth() on the last device
+int micro_set_pnetid() {
+	set_pnetid_for_eth(micro_names[MICRO_DEVICES - 2], "PNET0");
+	return 0;
+}
+
+// benchmark the function filter_match() on all devices
+int micro_filter_match() {
+	struct device *device = get_next_device(&devices_list);
+	int count = 0;
+
+	for (; device; device = get_next_device(device))
+		count += filter_match(micro_filter, device);
+	return count ? 0 : -1;
+}
+
+// benchmark the functions pairing_build() and pairing_free()
+int micro_pairing_build() {
+	struct pairing_index index;
+
+	if (pairing_build(&index))
+		return -1;
+	pairing_free(&index);
+	return 0;
+}
+
+// benchmark the function probe_find_prefix() on the loopback device
+int micro_probe_lower() {
+	char lower[16];
+	int fd;
+
+	fd = probe_dir("/sys/class/net/lo");
+	if (fd != -1)
+		probe_find_prefix(fd, "lower_", lower, sizeof(lower));
+	probe_cleanup();
+	return 0;
+}
+
+struct test tests[] = {
+	{"set_pnetid", micro_set_pnetid},
+	{"filter_match", micro_filter_match},
+	{"pairing_build", micro_pairing_build},
+	{"probe_lower", micro_probe_lower},
+	{NULL, NULL},
+};
+
+int main(int argc, char** argv) {
+	int rc = -1;
+
+	micro_filter = filter_compile("pnetid in {PNET0,PNET1} and type=net");
+	if (!micro_filter || micro_add_devices())
+		goto out;
+	rc = run_test(tests, argc, argv);
+out:
+	filter_free(micro_filter);
+	free_devices();
+	return rc;
+}
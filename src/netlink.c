@@ -13,12 +13,23 @@
 #include <netlink/socket.h>
 #include <netlink/attr.h>
 
+#include <stdlib.h>
+#include <errno.h>
+
 #include "devices.h"
+#include "netlink.h"
 #include "verbose.h"
+#include "stats.h"
+#include "trace.h"
+#include "lazy.h"
 
 struct nl_sock *nl_sock;
 int nl_version;
 int nl_family;
+void (*nl_pnetid_handler)(const struct nl_pnetid *entry);
+
+/* if set, netlink errors are stored here instead of being logged */
+static int *nl_result;
 
 /* netlink policy for pnetid attributes */
 static struct nla_policy smc_pnet_policy[SMC_PNETID_MAX + 1] = {
@@ -40,84 +51,199 @@ static struct nla_policy smc_pnet_policy[SMC_PNETID_MAX + 1] = {
 	[SMC_PNETID_IBPORT] = { .type = NLA_U8 }
 };
 
-/* receive and parse netlink message */
-int nl_parse_msg(struct nl_msg *msg, void *arg) {
+/* parse pnetid entry from netlink message, the strings of the entry point
+ * into the message. Returns 1 if there is no pnetid in the message and -1 on
+ * error
+ */
+int nl_parse_pnetid(struct nl_msg *msg, struct nl_pnetid *entry) {
 	struct nlmsghdr *hdr = nlmsg_hdr(msg);
 	struct nlattr *attrs[SMC_PNETID_MAX + 1];
 
-	if (genlmsg_parse(hdr, 0, attrs, SMC_PNETID_MAX, smc_pnet_policy) < 0) {
-		printf("Error parsing netlink attributes\n");
-		return NL_STOP;
-	}
+	memset(entry, 0, sizeof(*entry));
+	entry->ib_port = -1;
+	if (genlmsg_parse(hdr, 0, attrs, SMC_PNETID_MAX, smc_pnet_policy) < 0)
+		return -1;
 
 	if (!attrs[SMC_PNETID_NAME]) {
+		/* pnetid name is not present in message */
+		return 1;
+	}
+	entry->pnetid = nla_get_string(attrs[SMC_PNETID_NAME]);
+	if (attrs[SMC_PNETID_ETHNAME])
+		entry->eth_name = nla_get_string(attrs[SMC_PNETID_ETHNAME]);
+	if (attrs[SMC_PNETID_IBNAME])
+		entry->ib_name = nla_get_string(attrs[SMC_PNETID_IBNAME]);
+	if (attrs[SMC_PNETID_IBPORT])
+		entry->ib_port = nla_get_u8(attrs[SMC_PNETID_IBPORT]);
+	return 0;
+}
+
+/* receive and parse netlink message */
+int nl_parse_msg(struct nl_msg *msg, void *arg) {
+	struct nl_pnetid entry;
+	int rc;
+
+	rc = nl_parse_pnetid(msg, &entry);
+	if (rc < 0) {
+		log_error("Error parsing netlink attributes\n");
+		return NL_STOP;
+	}
+	if (rc > 0) {
 		/* pnetid name is not present in message, abort */
 		return NL_OK;
 	}
-	if (attrs[SMC_PNETID_ETHNAME]) {
+	if (nl_pnetid_handler) {
+		/* pass entry on without looking up devices */
+		nl_pnetid_handler(&entry);
+		return NL_OK;
+	}
+	if (entry.eth_name) {
 		/* eth name is present in message */
-		verbose("Got netlink message with pnetid \"%s\" and eth name "
-			"\"%s\".\n",
-			nla_get_string(attrs[SMC_PNETID_NAME]),
-			nla_get_string(attrs[SMC_PNETID_ETHNAME]));
-		set_pnetid_for_eth(nla_get_string(attrs[SMC_PNETID_ETHNAME]),
-				   nla_get_string(attrs[SMC_PNETID_NAME]));
+		log_debug("Got netlink message with pnetid \"%s\" and eth name "
+			"\"%s\".\n", entry.pnetid, entry.eth_name);
+		set_pnetid_for_eth(entry.eth_name, entry.pnetid);
 	}
-	if (attrs[SMC_PNETID_IBNAME]) {
+	if (entry.ib_name) {
 		/* ib name is present in message */
-		if (!attrs[SMC_PNETID_IBPORT]) {
+		if (entry.ib_port == -1) {
 			/* ib port is not present in message, abort */
-			printf("Error retrieving netlink IB attributes\n");
+			log_error("Error retrieving netlink IB attributes\n");
 			return NL_OK;
 		}
-		verbose("Got netlink message with pnetid \"%s\", ib name "
-			"\"%s\", and ib port \"%d\".\n",
-			nla_get_string(attrs[SMC_PNETID_NAME]),
-			nla_get_string(attrs[SMC_PNETID_IBNAME]),
-			nla_get_u8(attrs[SMC_PNETID_IBPORT]));
-		set_pnetid_for_ib(nla_get_string(attrs[SMC_PNETID_IBNAME]),
-				  nla_get_u8(attrs[SMC_PNETID_IBPORT]),
-				  nla_get_string(attrs[SMC_PNETID_NAME]));
+		log_debug("Got netlink message with pnetid \"%s\", ib name "
+			"\"%s\", and ib port \"%d\".\n", entry.pnetid,
+			entry.ib_name, entry.ib_port);
+		set_pnetid_for_ib(entry.ib_name, entry.ib_port, entry.pnetid);
 	}
 	return NL_OK;
 }
 
+/* count incoming netlink messages */
+int nl_count_msg_in(struct nl_msg *msg, void *arg) {
+	stats_inc(STATS_NL_MSGS_RECEIVED);
+	stats_add(STATS_NL_BYTES_RECEIVED, nlmsg_hdr(msg)->nlmsg_len);
+	trace_instant(nl_recv, NULL, nlmsg_hdr(msg)->nlmsg_len);
+	return NL_OK;
+}
+
+/* count outgoing netlink messages */
+int nl_count_msg_out(struct nl_msg *msg, void *arg) {
+	stats_inc(STATS_NL_MSGS_SENT);
+	stats_add(STATS_NL_BYTES_SENT, nlmsg_hdr(msg)->nlmsg_len);
+	trace_instant(nl_send, NULL, nlmsg_hdr(msg)->nlmsg_len);
+	return NL_OK;
+}
+
 /* receive and parse netlink error messages */
 int nl_parse_error(struct sockaddr_nl *nla, struct nlmsgerr *nlerr, void *arg) {
-	printf("Netlink error: %s\n", strerror(-nlerr->error));
+	trace_instant(nl_error, strerror(-nlerr->error), nlerr->error);
+	if (nl_result) {
+		*nl_result = nlerr->error;
+		return NL_STOP;
+	}
+	log_error("Netlink error: %s\n", strerror(-nlerr->error));
 	return NL_STOP;
 }
 
-/* flush all pnetids */
-void nl_flush_pnetids() {
-	verbose("Sending flush pnetids command over netlink socket.\n");
-	genl_send_simple(nl_sock, nl_family, SMC_PNETID_FLUSH, nl_version, 0);
+/* receive the reply of a request, returns 0 on success or the negative
+ * netlink error code, errors are logged
+ */
+static int nl_recv_result() {
+	int result = 0;
+
+	nl_result = &result;
 	nl_recvmsgs_default(nl_sock);
+	nl_result = NULL;
+	if (result)
+		log_error("Netlink error: %s\n", strerror(-result));
+	return result;
+}
+
+/* flush all pnetids, returns 0 on success or a negative error code */
+int nl_flush_pnetids() {
+	int rc;
+
+	stats_start(STATS_PHASE_NETLINK);
+	trace_begin(netlink, "flush", 0);
+	log_debug("Sending flush pnetids command over netlink socket.\n");
+	rc = genl_send_simple(nl_sock, nl_family, SMC_PNETID_FLUSH, nl_version,
+			      0);
+	if (rc < 0) {
+		log_error("Error sending request: %d\n", rc);
+		rc = -EIO;
+	} else {
+		rc = nl_recv_result();
+	}
+	trace_end(netlink, "flush", rc);
+	stats_stop(STATS_PHASE_NETLINK);
+	return rc;
 }
 
 /* get all pnetids */
 void nl_get_pnetids() {
-	verbose("Sending get pnetids command over netlink socket.\n");
+	stats_start(STATS_PHASE_NETLINK);
+	trace_begin(netlink, "get", 0);
+	log_debug("Sending get pnetids command over netlink socket.\n");
 	genl_send_simple(nl_sock, nl_family, SMC_PNETID_GET, nl_version,
 			 NLM_F_DUMP);
 	/* check reply */
 	nl_recvmsgs_default(nl_sock);
+	trace_end(netlink, "get", 0);
+	stats_stop(STATS_PHASE_NETLINK);
 }
 
-/* set pnetid */
-void nl_set_pnetid(const char *pnet_name, const char *eth_name,
-		   const char *ib_name, char ib_port) {
+/* get only the pnetids with names, all requests are sent before the replies
+ * are received
+ */
+void nl_get_pnetids_by_name(const char **pnet_names, int count) {
 	struct nl_msg* msg;
+	int sent = 0;
 	int rc;
 
-	/* construct netlink message */
+	stats_start(STATS_PHASE_NETLINK);
+	trace_begin(netlink, "get", count);
+
+	/* the kernel answers each request with a multipart message that ends
+	 * with NLMSG_DONE, an additional ack would break sequence checking
+	 */
+	nl_socket_disable_auto_ack(nl_sock);
+	for (int i = 0; i < count; i++) {
+		log_trace("Constructing netlink message to get pnetid "
+			  "\"%s\".\n", pnet_names[i]);
+		msg = nlmsg_alloc();
+		genlmsg_put(msg, NL_AUTO_PID, NL_AUTO_SEQ, nl_family, 0,
+			    NLM_F_REQUEST, SMC_PNETID_GET, nl_version);
+		nla_put_string(msg, SMC_PNETID_NAME, pnet_names[i]);
+
+		log_debug("Sending get pnetid command over netlink socket.\n");
+		rc = nl_send_auto(nl_sock, msg);
+		if (rc < 0)
+			log_error("Error sending request: %d\n", rc);
+		else
+			sent++;
+		nlmsg_free(msg);
+	}
+
+	/* check replies */
+	for (; sent > 0; sent--)
+		nl_recvmsgs_default(nl_sock);
+	nl_socket_enable_auto_ack(nl_sock);
+	trace_end(netlink, "get", count);
+	stats_stop(STATS_PHASE_NETLINK);
+}
+
+/* construct netlink message to add pnetid */
+static struct nl_msg *nl_add_msg(const char *pnet_name, const char *eth_name,
+				 const char *ib_name, int ib_port) {
+	struct nl_msg* msg;
+
 	msg = nlmsg_alloc();
 	genlmsg_put(msg, NL_AUTO_PID, NL_AUTO_SEQ, nl_family, 0, NLM_F_REQUEST,
 		    SMC_PNETID_ADD, nl_version);
 	nla_put_string(msg, SMC_PNETID_NAME, pnet_name);
 	if (eth_name) {
 		nla_put_string(msg, SMC_PNETID_ETHNAME, eth_name);
-		verbose("Constructing netlink message to add pnetid \"%s\" "
+		log_trace("Constructing netlink message to add pnetid \"%s\" "
 			"on net device \"%s\".\n", pnet_name, eth_name);
 	}
 	if (ib_name) {
@@ -125,29 +251,84 @@ void nl_set_pnetid(const char *pnet_name, const char *eth_name,
 		if (ib_port == -1)
 			ib_port = IB_DEFAULT_PORT;
 		nla_put_u8(msg, SMC_PNETID_IBPORT, ib_port);
-		verbose("Constructing netlink message to add pnetid \"%s\" "
+		log_trace("Constructing netlink message to add pnetid \"%s\" "
 			"on ib device \"%s\" and port \"%d\".\n", pnet_name,
 			ib_name, ib_port);
 	}
+	return msg;
+}
+
+/* set pnetid, returns 0 on success or a negative error code */
+int nl_set_pnetid(const char *pnet_name, const char *eth_name,
+		  const char *ib_name, char ib_port) {
+	struct nl_msg* msg;
+	int rc;
+
+	/* construct netlink message */
+	stats_start(STATS_PHASE_NETLINK);
+	trace_begin(netlink, "add", 0);
+	msg = nl_add_msg(pnet_name, eth_name, ib_name, ib_port);
 
 	/* send and free netlink message */
-	verbose("Sending add pnetid command over netlink socket.\n");
+	log_debug("Sending add pnetid command over netlink socket.\n");
 	rc = nl_send_auto(nl_sock, msg);
-	if (rc < 0)
-		printf("Error sending request: %d\n", rc);
 	nlmsg_free(msg);
 
 	/* check reply */
-	nl_recvmsgs_default(nl_sock);
+	if (rc < 0) {
+		log_error("Error sending request: %d\n", rc);
+		rc = -EIO;
+	} else {
+		rc = nl_recv_result();
+	}
+	trace_end(netlink, "add", rc);
+	stats_stop(STATS_PHASE_NETLINK);
+	return rc;
 }
 
-/* delete a pnetid */
-void nl_del_pnetid(const char *pnet_name) {
+/* set the pnetids of count entries, all requests are sent before the
+ * replies are received. The result of each entry is stored in results, 0 on
+ * success or a negative error code
+ */
+void nl_set_pnetids(const struct nl_pnetid *entries, int count,
+		    int *results) {
+	struct nl_msg* msg;
+	int rc;
+
+	stats_start(STATS_PHASE_NETLINK);
+	trace_begin(netlink, "add", count);
+	for (int i = 0; i < count; i++) {
+		msg = nl_add_msg(entries[i].pnetid, entries[i].eth_name,
+				 entries[i].ib_name, entries[i].ib_port);
+		log_debug("Sending add pnetid command over netlink socket.\n");
+		rc = nl_send_auto(nl_sock, msg);
+		if (rc < 0)
+			log_error("Error sending request: %d\n", rc);
+		results[i] = rc < 0 ? rc : 0;
+		nlmsg_free(msg);
+	}
+
+	/* check the reply of each sent request in order */
+	for (int i = 0; i < count; i++) {
+		if (results[i])
+			continue;
+		nl_result = &results[i];
+		nl_recvmsgs_default(nl_sock);
+		nl_result = NULL;
+	}
+	trace_end(netlink, "add", count);
+	stats_stop(STATS_PHASE_NETLINK);
+}
+
+/* delete a pnetid, returns 0 on success or a negative error code */
+int nl_del_pnetid(const char *pnet_name) {
 	struct nl_msg* msg;
 	int rc;
 
 	/* construct netlink message */
-	verbose("Constructing netlink message to delete pnetid \"%s\".\n",
+	stats_start(STATS_PHASE_NETLINK);
+	trace_begin(netlink, "del", 0);
+	log_trace("Constructing netlink message to delete pnetid \"%s\".\n",
 		pnet_name);
 	msg = nlmsg_alloc();
 	genlmsg_put(msg, NL_AUTO_PID, NL_AUTO_SEQ, nl_family, 0, NLM_F_REQUEST,
@@ -155,25 +336,38 @@ void nl_del_pnetid(const char *pnet_name) {
 	nla_put_string(msg, SMC_PNETID_NAME, pnet_name);
 
 	/* send and free netlink message */
-	verbose("Sending delete pnetid command over netlink socket.\n");
+	log_debug("Sending delete pnetid command over netlink socket.\n");
 	rc = nl_send_auto(nl_sock, msg);
-	if (rc < 0)
-		printf("Error sending request: %d\n", rc);
 	nlmsg_free(msg);
 
 	/* check reply */
-	nl_recvmsgs_default(nl_sock);
+	if (rc < 0) {
+		log_error("Error sending request: %d\n", rc);
+		rc = -EIO;
+	} else {
+		rc = nl_recv_result();
+	}
+	trace_end(netlink, "del", rc);
+	stats_stop(STATS_PHASE_NETLINK);
+	return rc;
 }
 
 /* init netlink part */
 void nl_init() {
 	struct nl_cb *cb;
 
-	verbose("Initializing netlink socket.\n");
+	/* nothing works without netlink */
+	if (lazy_load_nl())
+		exit(EXIT_FAILURE);
+
+	log_debug("Initializing netlink socket.\n");
 	nl_sock = nl_socket_alloc();
 	cb = nl_socket_get_cb(nl_sock);
 	nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, nl_parse_msg, NULL);
 	nl_cb_err(cb, NL_CB_CUSTOM, nl_parse_error, NULL);
+	nl_cb_set(cb, NL_CB_MSG_IN, NL_CB_CUSTOM, nl_count_msg_in, NULL);
+	nl_cb_set(cb, NL_CB_MSG_OUT, NL_CB_CUSTOM, nl_count_msg_out, NULL);
+	nl_cb_put(cb);
 	genl_connect(nl_sock);
 	nl_family = genl_ctrl_resolve(nl_sock, SMCR_GENL_FAMILY_NAME);
 	nl_version = SMCR_GENL_FAMILY_VERSION;
@@ -181,7 +375,7 @@ void nl_init() {
 
 /* cleanup netlink part */
 void nl_cleanup() {
-	verbose("Cleaning up netlink socket.\n");
+	log_debug("Cleaning up netlink socket.\n");
 	nl_close(nl_sock);
 	nl_socket_free(nl_sock);
 }
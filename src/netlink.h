@@ -1,12 +1,31 @@
 #ifndef _PNETCTL_NETLINK_H
 #define _PNETCTL_NETLINK_H
 
+#include <netlink/msg.h>
+
+/* pnetid entry of a netlink message */
+struct nl_pnetid {
+	const char *pnetid;
+	const char *eth_name;
+	const char *ib_name;
+	int ib_port;
+};
+
+/* if set, called for each pnetid entry received via netlink instead of
+ * setting the pnetids of the devices
+ */
+extern void (*nl_pnetid_handler)(const struct nl_pnetid *entry);
+
 void nl_init();
 void nl_cleanup();
-void nl_flush_pnetids();
-void nl_del_pnetid(const char *pnet_name);
-void nl_set_pnetid(const char *pnet_name, const char *eth_name,
-		   const char *ib_name, char ib_port);
+int nl_flush_pnetids();
+int nl_del_pnetid(const char *pnet_name);
+int nl_set_pnetid(const char *pnet_name, const char *eth_name,
+		  const char *ib_name, char ib_port);
+void nl_set_pnetids(const struct nl_pnetid *entries, int count,
+		    int *results);
 void nl_get_pnetids();
+void nl_get_pnetids_by_name(const char **pnet_names, int count);
+int nl_parse_pnetid(struct nl_msg *msg, struct nl_pnetid *entry);
 
 #endif
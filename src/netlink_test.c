@@ -65,6 +65,19 @@ int test_nl_get_pnetids() {
 	return 0;
 }
 
+// test the function nl_get_pnetids_by_name()
+int test_nl_get_pnetids_by_name() {
+	const char *pnet_names[] = {"PNETCTL", "DOES_NOT_EXIST"};
+
+	nl_init();
+	nl_get_pnetids_by_name(pnet_names, 2);
+	nl_set_pnetid("PNETCTL", "lo", NULL, 0);
+	nl_get_pnetids_by_name(pnet_names, 2);
+	nl_del_pnetid("PNETCTL");
+	nl_cleanup();
+	return 0;
+}
+
 struct test tests[] = {
 	{"nl_init", test_nl_init},
 	{"nl_cleanup", test_nl_cleanup},
@@ -72,13 +85,10 @@ struct test tests[] = {
 	{"nl_del_pnetid", test_nl_del_pnetid},
 	{"nl_set_pnetid", test_nl_set_pnetid},
 	{"nl_get_pnetids", test_nl_get_pnetids},
+	{"nl_get_pnetids_by_name", test_nl_get_pnetids_by_name},
 	{NULL, NULL},
 };
 
 int main(int argc, char** argv) {
-	const char *name = NULL;
-	if (argc > 1) {
-		name = argv[1];
-	}
-	return run_test(tests, name);
+	return run_test(tests, argc, argv);
 }
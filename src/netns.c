@@ -0,0 +1,489 @@
+/*
+ * ******************
+ * *** NETNS PART ***
+ * ******************
+ */
+
+#define _GNU_SOURCE
+
+#include <linux/smc.h>
+#include <linux/rtnetlink.h>
+
+#include <netlink/genl/genl.h>
+#include <netlink/genl/ctrl.h>
+#include <netlink/netlink.h>
+#include <netlink/socket.h>
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <dirent.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "netns.h"
+#include "netlink.h"
+#include "devices.h"
+#include "pairing.h"
+#include "print.h"
+#include "sysfs.h"
+#include "udev.h"
+#include "verbose.h"
+#include "lazy.h"
+
+/* namespaces handled by the worker threads */
+struct netns_work {
+	struct netns *namespaces;
+	int count;
+	atomic_int next;
+};
+
+/* grow array of n elements of size to hold one more element */
+static void *netns_grow(void *array, int n, int *max, size_t size) {
+	void *new_array;
+
+	if (n < *max)
+		return array;
+	new_array = realloc(array, (*max ? *max * 2 : 64) * size);
+	if (new_array)
+		*max = *max ? *max * 2 : 64;
+	return new_array;
+}
+
+/* kinds of stacked net devices whose IFLA_LINK is the lower device, for
+ * others like veth it is e.g. the peer
+ */
+static const char *netns_stacked_kinds[] = {
+	"vlan",
+	"macvlan",
+	"ipvlan",
+	NULL,
+};
+
+/* check if the IFLA_LINKINFO attribute is of a stacked net device */
+static int netns_is_stacked(struct nlattr *linkinfo) {
+	struct nlattr *attrs[IFLA_INFO_MAX + 1];
+	const char *kind;
+
+	if (!linkinfo ||
+	    nla_parse_nested(attrs, IFLA_INFO_MAX, linkinfo, NULL) < 0 ||
+	    !attrs[IFLA_INFO_KIND])
+		return 0;
+	kind = nla_get_string(attrs[IFLA_INFO_KIND]);
+	for (int i = 0; netns_stacked_kinds[i]; i++)
+		if (!strcmp(kind, netns_stacked_kinds[i]))
+			return 1;
+	return 0;
+}
+
+/* add net device from RTM_NEWLINK message to namespace */
+static int netns_parse_link(struct nl_msg *msg, void *arg) {
+	struct nlmsghdr *hdr = nlmsg_hdr(msg);
+	struct nlattr *attrs[IFLA_MAX + 1];
+	struct netns *ns = arg;
+	struct netns_link *link;
+	struct ifinfomsg *ifi;
+	void *links;
+
+	if (hdr->nlmsg_type != RTM_NEWLINK)
+		return NL_OK;
+	if (nlmsg_parse(hdr, sizeof(*ifi), attrs, IFLA_MAX, NULL) < 0 ||
+	    !attrs[IFLA_IFNAME])
+		return NL_OK;
+
+	links = netns_grow(ns->links, ns->num_links, &ns->max_links,
+			   sizeof(*ns->links));
+	if (!links)
+		return NL_STOP;
+	ns->links = links;
+	link = &ns->links[ns->num_links++];
+	memset(link, 0, sizeof(*link));
+
+	ifi = nlmsg_data(hdr);
+	link->index = ifi->ifi_index;
+	nla_strlcpy(link->name, attrs[IFLA_IFNAME], sizeof(link->name));
+	/* lower devices in other namespaces cannot be resolved */
+	if (attrs[IFLA_LINK] && !attrs[IFLA_LINK_NETNSID] &&
+	    netns_is_stacked(attrs[IFLA_LINKINFO]))
+		link->link = nla_get_u32(attrs[IFLA_LINK]);
+	if (attrs[IFLA_MASTER])
+		link->master = nla_get_u32(attrs[IFLA_MASTER]);
+	if (attrs[IFLA_PARENT_DEV_NAME])
+		nla_strlcpy(link->parent, attrs[IFLA_PARENT_DEV_NAME],
+			    sizeof(link->parent));
+	if (attrs[IFLA_PARENT_DEV_BUS_NAME])
+		nla_strlcpy(link->parent_subsystem,
+			    attrs[IFLA_PARENT_DEV_BUS_NAME],
+			    sizeof(link->parent_subsystem));
+	return NL_OK;
+}
+
+/* get all net devices of the current namespace via rtnetlink */
+static int netns_get_links(struct netns *ns) {
+	struct ifinfomsg ifi = { .ifi_family = AF_UNSPEC };
+	struct nl_sock *sock;
+	int rc = -1;
+
+	sock = nl_socket_alloc();
+	if (!sock)
+		return -1;
+	if (nl_connect(sock, NETLINK_ROUTE))
+		goto out;
+	nl_socket_modify_cb(sock, NL_CB_VALID, NL_CB_CUSTOM, netns_parse_link,
+			    ns);
+	if (nl_send_simple(sock, RTM_GETLINK, NLM_F_DUMP, &ifi,
+			   sizeof(ifi)) < 0)
+		goto out;
+	if (nl_recvmsgs_default(sock) < 0)
+		goto out;
+	rc = 0;
+out:
+	nl_socket_free(sock);
+	return rc;
+}
+
+/* add pnetid entry from netlink message to namespace */
+static int netns_parse_pnetid(struct nl_msg *msg, void *arg) {
+	struct netns_pnetid *pnetid;
+	struct nl_pnetid entry;
+	struct netns *ns = arg;
+	void *pnetids;
+
+	if (nl_parse_pnetid(msg, &entry))
+		return NL_OK;
+
+	pnetids = netns_grow(ns->pnetids, ns->num_pnetids, &ns->max_pnetids,
+			     sizeof(*ns->pnetids));
+	if (!pnetids)
+		return NL_STOP;
+	ns->pnetids = pnetids;
+	pnetid = &ns->pnetids[ns->num_pnetids++];
+	memset(pnetid, 0, sizeof(*pnetid));
+
+	strncpy(pnetid->pnetid, entry.pnetid, SMC_MAX_PNETID_LEN);
+	if (entry.eth_name)
+		strncpy(pnetid->eth_name, entry.eth_name,
+			sizeof(pnetid->eth_name) - 1);
+	if (entry.ib_name)
+		strncpy(pnetid->ib_name, entry.ib_name,
+			sizeof(pnetid->ib_name) - 1);
+	pnetid->ib_port = entry.ib_port;
+	return NL_OK;
+}
+
+/* get or flush the pnetids of the current namespace via smc netlink */
+static int netns_smc(struct netns *ns) {
+	struct nl_sock *sock;
+	int family;
+	int cmd;
+	int rc = -1;
+
+	sock = nl_socket_alloc();
+	if (!sock)
+		return -1;
+	if (genl_connect(sock))
+		goto out;
+	family = genl_ctrl_resolve(sock, SMCR_GENL_FAMILY_NAME);
+	if (family < 0) {
+		log_info("SMC is not available in namespace \"%s\".\n",
+			 ns->name);
+		rc = 0;
+		goto out;
+	}
+
+	nl_socket_modify_cb(sock, NL_CB_VALID, NL_CB_CUSTOM,
+			    netns_parse_pnetid, ns);
+	cmd = ns->flush ? SMC_PNETID_FLUSH : SMC_PNETID_GET;
+	if (genl_send_simple(sock, family, cmd, SMCR_GENL_FAMILY_VERSION,
+			     ns->flush ? 0 : NLM_F_DUMP) < 0)
+		goto out;
+	if (nl_recvmsgs_default(sock) < 0)
+		goto out;
+	rc = 0;
+out:
+	nl_socket_free(sock);
+	return rc;
+}
+
+/* enter the namespace in the calling thread and get its net devices and
+ * pnetids or flush its pnetids
+ */
+int netns_scan(struct netns *ns) {
+	int fd;
+
+	if (lazy_load_nl())
+		return -1;
+	fd = open(ns->path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1 || setns(fd, CLONE_NEWNET)) {
+		log_error("Cannot enter namespace \"%s\".\n", ns->name);
+		if (fd != -1)
+			close(fd);
+		return -1;
+	}
+	close(fd);
+
+	if (!ns->flush && netns_get_links(ns)) {
+		log_error("Cannot get net devices in namespace \"%s\".\n",
+			  ns->name);
+		return -1;
+	}
+	if (netns_smc(ns)) {
+		log_error("Cannot get pnetids in namespace \"%s\".\n",
+			  ns->name);
+		return -1;
+	}
+	log_debug("Found %d net devices and %d pnetids in namespace "
+		  "\"%s\".\n", ns->num_links, ns->num_pnetids, ns->name);
+	return 0;
+}
+
+/* free the results of a namespace */
+void netns_free(struct netns *ns) {
+	free(ns->name);
+	free(ns->path);
+	free(ns->links);
+	free(ns->pnetids);
+	memset(ns, 0, sizeof(*ns));
+}
+
+/* worker thread, handles namespaces until all are done */
+static void *netns_worker(void *arg) {
+	struct netns_work *work = arg;
+	int i;
+
+	while ((i = atomic_fetch_add(&work->next, 1)) < work->count)
+		work->namespaces[i].rc = netns_scan(&work->namespaces[i]);
+	return NULL;
+}
+
+/* get the current and all named namespaces */
+static int netns_get_namespaces(struct netns **namespaces, int flush) {
+	struct dirent **entries;
+	char path[PATH_MAX];
+	struct netns *ns;
+	int count = 1;
+	int n;
+
+	n = scandir(NETNS_RUN_DIR, &entries, NULL, alphasort);
+	if (n == -1)
+		n = 0;
+	*namespaces = calloc(n + 1, sizeof(**namespaces));
+	if (!*namespaces)
+		return -1;
+
+	(*namespaces)[0].name = strdup(NETNS_CURRENT);
+	(*namespaces)[0].path = strdup(NETNS_CURRENT_PATH);
+	for (int i = 0; i < n; i++) {
+		if (entries[i]->d_name[0] != '.') {
+			snprintf(path, sizeof(path), "%s/%s", NETNS_RUN_DIR,
+				 entries[i]->d_name);
+			ns = &(*namespaces)[count++];
+			ns->name = strdup(entries[i]->d_name);
+			ns->path = strdup(path);
+		}
+		free(entries[i]);
+	}
+	if (n)
+		free(entries);
+	for (int i = 0; i < count; i++)
+		(*namespaces)[i].flush = flush;
+	return count;
+}
+
+/* find net device with index in namespace */
+static struct netns_link *netns_find_link(struct netns *ns, int index) {
+	for (int i = 0; i < ns->num_links; i++)
+		if (ns->links[i].index == index)
+			return &ns->links[i];
+	return NULL;
+}
+
+/* find the first lower device of a net device */
+static struct netns_link *netns_find_lower(struct netns *ns,
+					   struct netns_link *link) {
+	struct netns_link *lower = NULL;
+
+	if (link->link && link->link != link->index)
+		return netns_find_link(ns, link->link);
+	for (int i = 0; i < ns->num_links; i++)
+		if (ns->links[i].master == link->index &&
+		    (!lower || strcmp(ns->links[i].name, lower->name) < 0))
+			lower = &ns->links[i];
+	return lower;
+}
+
+/* fill device record of a net device in namespace */
+static void netns_link_to_record(struct netns *ns, struct netns_link *link,
+				 struct device_record *record) {
+	struct netns_link *visited[NETNS_MAX_LOWER_DEPTH + 1];
+	struct netns_link *lowest = link;
+	struct netns_link *lower;
+	char path[PATH_MAX];
+	int depth = 0;
+
+	memset(record, 0, sizeof(*record));
+	snprintf(record->subsystem, sizeof(record->subsystem), "%s",
+		 device_kind_names[DEVICE_KIND_NET]);
+	snprintf(record->name, sizeof(record->name), "%s", link->name);
+	snprintf(record->parent, sizeof(record->parent), "%s", link->parent);
+	snprintf(record->parent_subsystem, sizeof(record->parent_subsystem),
+		 "%s", link->parent_subsystem);
+	record->ib_port = -1;
+
+	/* stop at the lowest device or if a device is visited again */
+	visited[depth++] = link;
+	while (depth <= NETNS_MAX_LOWER_DEPTH) {
+		lower = netns_find_lower(ns, lowest);
+		for (int i = 0; lower && i < depth; i++)
+			if (visited[i] == lower)
+				lower = NULL;
+		if (!lower)
+			break;
+		lowest = visited[depth++] = lower;
+	}
+	snprintf(record->lowest, sizeof(record->lowest), "%s", lowest->name);
+
+	/* the pci and ccwgroup parent devices are not in a namespace */
+	switch (device_bus(link->parent_subsystem)) {
+	case DEVICE_BUS_PCI:
+		snprintf(path, sizeof(path),
+			 "%s/bus/pci/devices/%s/util_string", sysfs_root,
+			 link->parent);
+		read_util_string(path, record->pnetid);
+		break;
+	case DEVICE_BUS_CCWGROUP:
+		snprintf(path, sizeof(path), "%s/bus/ccwgroup/devices/%s",
+			 sysfs_root, link->parent);
+		read_ccw_util_string(path, record->pnetid);
+		break;
+	}
+}
+
+/* print the devices of a namespace, the infiniband and ism devices are
+ * shared by all namespaces
+ */
+static int netns_print(struct netns *ns, struct device_record *shared,
+		       int num_shared) {
+	struct device_record *records;
+	struct netns_pnetid *pnetid;
+
+	records = calloc(num_shared + ns->num_links + 1, sizeof(*records));
+	if (!records)
+		return -1;
+	memcpy(records, shared, num_shared * sizeof(*records));
+	for (int i = 0; i < ns->num_links; i++)
+		netns_link_to_record(ns, &ns->links[i],
+				     &records[num_shared + i]);
+	add_device_records(records, num_shared + ns->num_links);
+
+	for (int i = 0; i < ns->num_pnetids; i++) {
+		pnetid = &ns->pnetids[i];
+		if (pnetid->eth_name[0])
+			set_pnetid_for_eth(pnetid->eth_name, pnetid->pnetid);
+		if (pnetid->ib_name[0] && pnetid->ib_port != -1)
+			set_pnetid_for_ib(pnetid->ib_name, pnetid->ib_port,
+					  pnetid->pnetid);
+	}
+
+	print_netns(ns->name);
+	/* the net device of the pairs may only exist in some namespaces */
+	if (pairs_mode)
+		pairing_print_devices(pairs_device);
+	else
+		print_device_table();
+	free_devices();
+	free(records);
+	return 0;
+}
+
+/* get the infiniband and ism devices, they do not belong to a namespace */
+static int netns_get_shared(struct device_record **shared) {
+	struct device *device;
+	int count = 0;
+
+	*shared = NULL;
+	if (udev_scan_devices())
+		return -1;
+	device = get_next_device(&devices_list);
+	for (; device; device = get_next_device(device))
+		count++;
+	*shared = calloc(count + 1, sizeof(**shared));
+	if (!*shared) {
+		free_devices();
+		return -1;
+	}
+	count = 0;
+	device = get_next_device(&devices_list);
+	for (; device; device = get_next_device(device))
+		if (device->kind != DEVICE_KIND_NET)
+			device_to_record(device, &(*shared)[count++]);
+	free_devices();
+	return count;
+}
+
+/* get devices and pnetids or flush pnetids in all namespaces */
+int netns_run_all(int flush) {
+	pthread_t threads[NETNS_MAX_THREADS];
+	struct device_record *shared = NULL;
+	struct netns_work work = {};
+	int num_threads;
+	int num_shared = 0;
+	int rc = EXIT_SUCCESS;
+
+	/* load netlink before the worker threads use it */
+	if (lazy_load_nl())
+		return EXIT_FAILURE;
+
+	work.count = netns_get_namespaces(&work.namespaces, flush);
+	if (work.count < 0)
+		return EXIT_FAILURE;
+	log_info("Found %d network namespaces.\n", work.count);
+
+	if (!flush) {
+		num_shared = netns_get_shared(&shared);
+		if (num_shared < 0) {
+			rc = EXIT_FAILURE;
+			goto out;
+		}
+	}
+
+	/* handle namespaces in worker threads */
+	num_threads = work.count < NETNS_MAX_THREADS ? work.count :
+		NETNS_MAX_THREADS;
+	for (int i = 0; i < num_threads; i++) {
+		if (pthread_create(&threads[i], NULL, netns_worker, &work)) {
+			num_threads = i;
+			break;
+		}
+	}
+	/* handle remaining namespaces if threads could not be created */
+	if (!num_threads)
+		netns_worker(&work);
+	for (int i = 0; i < num_threads; i++)
+		pthread_join(threads[i], NULL);
+
+	/* print results grouped by namespace */
+	for (int i = 0; i < work.count; i++) {
+		if (work.namespaces[i].rc) {
+			rc = EXIT_FAILURE;
+			continue;
+		}
+		if (flush) {
+			log_info("Flushed pnetids in namespace \"%s\".\n",
+				 work.namespaces[i].name);
+			continue;
+		}
+		if (netns_print(&work.namespaces[i], shared, num_shared))
+			rc = EXIT_FAILURE;
+	}
+out:
+	for (int i = 0; i < work.count; i++)
+		netns_free(&work.namespaces[i]);
+	free(work.namespaces);
+	free(shared);
+	return rc;
+}
@@ -0,0 +1,52 @@
+#ifndef _PNETCTL_NETNS_H
+#define _PNETCTL_NETNS_H
+
+#include <net/if.h>
+
+#include "devices.h"
+
+#define NETNS_RUN_DIR "/run/netns" /* directory of named namespaces */
+#define NETNS_CURRENT "current" /* name of the current namespace */
+#define NETNS_CURRENT_PATH "/proc/self/ns/net" /* namespace of the process */
+#define NETNS_MAX_THREADS 16 /* maximum number of worker threads */
+#define NETNS_MAX_LOWER_DEPTH 16 /* maximum depth of stacked net devices */
+
+/* net device in a namespace */
+struct netns_link {
+	int index;
+	int link; /* lower device of e.g. vlans */
+	int master; /* upper device of e.g. bond slaves */
+	char name[IFNAMSIZ];
+	char parent[DEVICE_NAME_LEN];
+	char parent_subsystem[DEVICE_SUBSYSTEM_LEN];
+};
+
+/* pnetid entry in a namespace */
+struct netns_pnetid {
+	char pnetid[SMC_MAX_PNETID_LEN + 1];
+	char eth_name[IFNAMSIZ];
+	char ib_name[DEVICE_NAME_LEN];
+	int ib_port;
+};
+
+/* network namespace and the results of its worker */
+struct netns {
+	char *name;
+	char *path;
+	int flush;
+	int rc;
+
+	struct netns_link *links;
+	int num_links;
+	int max_links;
+
+	struct netns_pnetid *pnetids;
+	int num_pnetids;
+	int max_pnetids;
+};
+
+int netns_scan(struct netns *ns);
+void netns_free(struct netns *ns);
+int netns_run_all(int flush);
+
+#endif
@@ -0,0 +1,199 @@
+/*
+ * end-to-end benchmark with many interfaces in a private network namespace
+ */
+
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mount.h>
+#include <sys/ptrace.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "common.h"
+#include "netlink.h"
+#include "stats.h"
+
+#define BENCH_SKIP 77 /* exit code of skipped meson tests */
+#define BENCH_PNETIDS 16 /* number of different pnetids */
+#define BENCH_VLAN_ID 10 /* vlan id of vlan interfaces */
+
+/* smc generic netlink family, negative if smc is not available */
+extern int nl_family;
+
+/* measurement of a single pnetctl run */
+struct bench_result {
+	uint64_t wall_ns;
+	long maxrss_kb;
+	long syscalls;
+	int rc;
+};
+
+/* move into a new network namespace with its own sysfs */
+static int bench_enter_netns() {
+	if (unshare(CLONE_NEWNET | CLONE_NEWNS)) {
+		perror("unshare");
+		return -1;
+	}
+	if (mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL)) {
+		perror("mount /");
+		return -1;
+	}
+	if (mount("sysfs", "/sys", "sysfs", 0, NULL)) {
+		perror("mount /sys");
+		return -1;
+	}
+	return 0;
+}
+
+/* create dummy interfaces with a vlan each and veth pairs, four
+ * interfaces per unit, with "ip -batch"
+ */
+static int bench_create_interfaces(int units) {
+	FILE *ip;
+
+	ip = popen("ip -batch -", "w");
+	if (!ip)
+		return -1;
+	for (int i = 0; i < units; i++) {
+		fprintf(ip, "link add dummy%d type dummy\n", i);
+		fprintf(ip, "link add link dummy%d name dummy%d.%d type vlan "
+			"id %d\n", i, i, BENCH_VLAN_ID, BENCH_VLAN_ID);
+		fprintf(ip, "link add veth%da type veth peer name veth%db\n",
+			i, i);
+	}
+	return pclose(ip) ? -1 : 0;
+}
+
+/* assign pnetids to all dummy and veth interfaces in bulk */
+static void bench_assign_pnetids(int units) {
+	char pnetid[SMC_MAX_PNETID_LEN + 1];
+	char name[32];
+
+	nl_init();
+	if (nl_family < 0) {
+		printf("SMC is not available, not assigning pnetids.\n");
+		nl_cleanup();
+		return;
+	}
+	for (int i = 0; i < units; i++) {
+		snprintf(pnetid, sizeof(pnetid), "SCALE%d", i % BENCH_PNETIDS);
+		snprintf(name, sizeof(name), "dummy%d", i);
+		nl_set_pnetid(pnetid, name, NULL, -1);
+		snprintf(name, sizeof(name), "veth%da", i);
+		nl_set_pnetid(pnetid, name, NULL, -1);
+	}
+	nl_cleanup();
+}
+
+/* run the pnetctl executable argv[0] with argv in a child process, so
+ * exec, the dynamic loader, and the libraries are measured like for a user,
+ * count its syscalls with ptrace if traced is set
+ */
+static int bench_run(char **argv, int traced, struct bench_result *result) {
+	struct rusage usage = {};
+	uint64_t start_ns;
+	int status;
+	int sig;
+	pid_t pid;
+
+	memset(result, 0, sizeof(*result));
+	start_ns = stats_now();
+	pid = fork();
+	if (pid == -1)
+		return -1;
+	if (pid == 0) {
+		int null_fd = open("/dev/null", O_WRONLY);
+
+		dup2(null_fd, STDOUT_FILENO);
+		dup2(null_fd, STDERR_FILENO);
+		if (traced) {
+			ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+			raise(SIGSTOP);
+		}
+		execv(argv[0], argv);
+		_exit(127);
+	}
+
+	if (traced) {
+		/* stop at each syscall entry and exit */
+		waitpid(pid, &status, 0);
+		ptrace(PTRACE_SETOPTIONS, pid, NULL, PTRACE_O_TRACESYSGOOD |
+		       PTRACE_O_TRACEEXEC | PTRACE_O_EXITKILL);
+		for (sig = 0;; sig = 0) {
+			if (ptrace(PTRACE_SYSCALL, pid, NULL, sig))
+				break;
+			if (waitpid(pid, &status, __WALL) == -1 ||
+			    !WIFSTOPPED(status))
+				break;
+			if (WSTOPSIG(status) == (SIGTRAP | 0x80))
+				result->syscalls++;
+			else if (status >> 8 != (SIGTRAP |
+						 PTRACE_EVENT_EXEC << 8))
+				sig = WSTOPSIG(status);
+		}
+		/* exit_group() only has an entry stop */
+		result->syscalls = (result->syscalls + 1) / 2;
+	}
+
+	if (wait4(pid, &status, 0, &usage) == -1 && !traced)
+		return -1;
+	result->wall_ns = stats_now() - start_ns;
+	result->maxrss_kb = usage.ru_maxrss;
+	result->rc = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+	if (result->rc == 127) {
+		printf("Cannot run \"%s\".\n", argv[0]);
+		return -1;
+	}
+	return 0;
+}
+
+/* measure a pnetctl run and print the result as a json line */
+static int bench_measure(const char *name, int interfaces, char **argv) {
+	struct bench_result traced;
+	struct bench_result run;
+
+	if (bench_run(argv, 0, &run) || bench_run(argv, 1, &traced))
+		return -1;
+	printf("{\"benchmark\":\"%s\",\"interfaces\":%d,\"wall_ms\":%.3f,"
+	       "\"maxrss_kb\":%ld,\"syscalls\":%ld,\"rc\":%d}\n", name,
+	       interfaces, run.wall_ns / 1e6, run.maxrss_kb, traced.syscalls,
+	       run.rc);
+	fflush(stdout);
+	return run.rc;
+}
+
+int main(int argc, char **argv) {
+	char *list_argv[] = {NULL, "--no-daemon", "-s", NULL};
+	char *get_argv[] = {NULL, "--no-daemon", "-g", "SCALE0", NULL};
+	int interfaces;
+	int units;
+
+	if (argc < 3) {
+		printf("Usage: %s <interfaces> <pnetctl>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	list_argv[0] = argv[2];
+	get_argv[0] = argv[2];
+	units = atoi(argv[1]) / 4 > 0 ? atoi(argv[1]) / 4 : 1;
+	interfaces = units * 4;
+
+	/* needs root and dummy, veth, and 8021q support in the kernel */
+	if (bench_enter_netns() || bench_create_interfaces(units)) {
+		printf("Cannot create %d interfaces in a network namespace, "
+		       "skipping.\n", interfaces);
+		return BENCH_SKIP;
+	}
+	bench_assign_pnetids(units);
+
+	if (bench_measure("list", interfaces, list_argv) ||
+	    bench_measure("get", interfaces, get_argv))
+		return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
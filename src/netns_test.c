@@ -0,0 +1,44 @@
+/*
+ * test for netns
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "test.h"
+#include "netns.h"
+
+// test the function netns_scan()
+int test_netns_scan() {
+	struct netns ns = {};
+	int rc = -1;
+
+	ns.name = strdup(NETNS_CURRENT);
+	ns.path = strdup(NETNS_CURRENT_PATH);
+	if (netns_scan(&ns))
+		goto out;
+
+	/* every namespace has a loopback device */
+	for (int i = 0; i < ns.num_links; i++)
+		if (!strcmp(ns.links[i].name, "lo"))
+			rc = 0;
+out:
+	netns_free(&ns);
+	return rc;
+}
+
+// test the function netns_run_all()
+int test_netns_run_all() {
+	return netns_run_all(0);
+}
+
+struct test tests[] = {
+	{"netns_scan", test_netns_scan},
+	{"netns_run_all", test_netns_run_all},
+	{NULL, NULL},
+};
+
+int main(int argc, char** argv) {
+	return run_test(tests, argc, argv);
+}
@@ -0,0 +1,706 @@
+/*
+ * benchmark for netlink pnetid operations
+ */
+
+#include <linux/smc.h>
+#include <net/if.h>
+
+#include <netlink/genl/genl.h>
+#include <netlink/netlink.h>
+#include <netlink/attr.h>
+
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdio.h>
+
+#include "bench.h"
+#include "common.h"
+#include "netlink.h"
+#include "stats.h"
+
+#define BENCH_OPS 10000 /* default number of operations per socket mode */
+#define BENCH_MIX "add:1,del:1" /* default mix of operations */
+#define BENCH_TABLE 1000 /* default table size before flush in emulation */
+#define BENCH_PNETID "PNETBENCH" /* pnetid prefix of added entries */
+#define BENCH_DEVICE "lo" /* default net device of added entries */
+#define BENCH_MAX_DEVICES 64 /* maximum number of net devices */
+
+/* smc generic netlink family, negative if smc is not available */
+extern int nl_family;
+
+/* socket of netlink.c */
+extern struct nl_sock *nl_sock;
+
+/* benchmarked operations */
+enum bench_ops {
+	BENCH_OP_ADD,
+	BENCH_OP_DEL,
+	BENCH_OP_GET,
+	BENCH_OP_LOOKUP,
+	BENCH_OP_FLUSH,
+	BENCH_OP_MAX,
+};
+
+static const char *bench_op_names[BENCH_OP_MAX] = {
+	[BENCH_OP_ADD] = "add",
+	[BENCH_OP_DEL] = "del",
+	[BENCH_OP_GET] = "get",
+	[BENCH_OP_LOOKUP] = "lookup",
+	[BENCH_OP_FLUSH] = "flush",
+};
+
+/* socket modes */
+enum bench_modes {
+	BENCH_MODE_ONESHOT,
+	BENCH_MODE_REUSED,
+	BENCH_MODE_MAX,
+};
+
+static const char *bench_mode_names[BENCH_MODE_MAX] = {
+	[BENCH_MODE_ONESHOT] = "one-shot",
+	[BENCH_MODE_REUSED] = "reused",
+};
+
+/* backend running the operations against smc or an emulation */
+struct bench_backend {
+	const char *name;
+	void (*init)();
+	void (*cleanup)();
+	void (*add)(const char *pnetid, const char *device);
+	void (*del)(const char *pnetid);
+	void (*get)();
+	void (*lookup)(const char *pnetid);
+	void (*flush)();
+};
+
+/* benchmark configuration */
+static int bench_ops = BENCH_OPS;
+static int bench_table = BENCH_TABLE;
+static const char *bench_devices[BENCH_MAX_DEVICES];
+static int bench_num_devices;
+static int bench_mix[BENCH_OP_MAX];
+static FILE *bench_json;
+
+/* entries added by the benchmark, entry i has the pnetid BENCH_PNETID<i> on
+ * net device i % bench_num_devices. The entries from bench_tail to
+ * bench_head are in the table, so each add and del succeeds
+ */
+static int bench_head;
+static int bench_tail;
+
+/* add pnetid to net device via netlink */
+static void netlink_add(const char *pnetid, const char *device) {
+	nl_set_pnetid(pnetid, device, NULL, -1);
+}
+
+/* delete pnetid via netlink */
+static void netlink_del(const char *pnetid) {
+	nl_del_pnetid(pnetid);
+}
+
+/* flush all pnetids via netlink */
+static void netlink_flush() {
+	nl_flush_pnetids();
+}
+
+/* get entries of pnetid via netlink */
+static void netlink_lookup(const char *pnetid) {
+	nl_get_pnetids_by_name(&pnetid, 1);
+}
+
+static struct bench_backend smc_backend = {
+	.name = "smc",
+	.init = nl_init,
+	.cleanup = nl_cleanup,
+	.add = netlink_add,
+	.del = netlink_del,
+	.get = nl_get_pnetids,
+	.lookup = netlink_lookup,
+	.flush = netlink_flush,
+};
+
+/* emulation of the smc pnetid table: the requests of netlink.c are answered
+ * by an in-process responder instead of the kernel, so everything but the
+ * kernel is measured
+ */
+
+/* fake family id of the emulated smc family */
+#define EMU_FAMILY 0x100
+
+/* entry of the emulated pnetid table */
+struct emu_entry {
+	char pnetid[SMC_MAX_PNETID_LEN + 1];
+	char device[IFNAMSIZ];
+};
+
+/* reply datagram of the emulated kernel, libnl frees the data after it
+ * received the datagram
+ */
+struct emu_reply {
+	char *data;
+	size_t len;
+	size_t size;
+};
+
+static struct emu_entry *emu_table;
+static int emu_count;
+static int emu_size;
+
+/* queue of reply datagrams, the datagrams from emu_next_reply to
+ * emu_num_replies are not received yet
+ */
+static struct emu_reply *emu_replies;
+static int emu_num_replies;
+static int emu_next_reply;
+static int emu_size_replies;
+
+static struct nla_policy emu_policy[SMC_PNETID_MAX + 1] = {
+	[SMC_PNETID_NAME] = {
+		.type = NLA_NUL_STRING,
+		.maxlen = SMC_MAX_PNETID_LEN + 1
+	},
+	[SMC_PNETID_ETHNAME] = { .type = NLA_NUL_STRING, .maxlen = IFNAMSIZ },
+};
+
+/* queue a new reply datagram with room for a page like nl_recv() */
+static struct emu_reply *emu_reply_new() {
+	struct emu_reply *reply;
+
+	if (emu_num_replies == emu_size_replies) {
+		emu_size_replies = emu_size_replies ? emu_size_replies * 2 : 8;
+		emu_replies = realloc(emu_replies, emu_size_replies *
+				      sizeof(*emu_replies));
+	}
+	reply = &emu_replies[emu_num_replies++];
+	reply->size = getpagesize();
+	reply->data = malloc(reply->size);
+	reply->len = 0;
+	return reply;
+}
+
+/* reserve len zeroed bytes at the end of reply */
+static void *emu_reply_reserve(struct emu_reply *reply, size_t len) {
+	void *ptr;
+
+	len = NLMSG_ALIGN(len);
+	if (reply->len + len > reply->size) {
+		reply->size = (reply->len + len) * 2;
+		reply->data = realloc(reply->data, reply->size);
+	}
+	ptr = reply->data + reply->len;
+	memset(ptr, 0, len);
+	reply->len += len;
+	return ptr;
+}
+
+/* start a message of type in reply to request req, returns the offset of
+ * the message in reply for emu_reply_end()
+ */
+static size_t emu_reply_start(struct emu_reply *reply,
+			      const struct nlmsghdr *req, int type,
+			      int flags) {
+	size_t offset = reply->len;
+	struct nlmsghdr *hdr;
+
+	hdr = emu_reply_reserve(reply, NLMSG_HDRLEN);
+	hdr->nlmsg_type = type;
+	hdr->nlmsg_flags = flags;
+	hdr->nlmsg_seq = req->nlmsg_seq;
+	hdr->nlmsg_pid = req->nlmsg_pid;
+	return offset;
+}
+
+/* set the length of the message at offset in reply */
+static void emu_reply_end(struct emu_reply *reply, size_t offset) {
+	struct nlmsghdr *hdr = (struct nlmsghdr *) (reply->data + offset);
+
+	hdr->nlmsg_len = reply->len - offset;
+}
+
+/* add a string attribute to the current message of reply */
+static void emu_reply_string(struct emu_reply *reply, int type,
+			     const char *value) {
+	struct nlattr *attr;
+	size_t len = strlen(value) + 1;
+
+	attr = emu_reply_reserve(reply, NLA_HDRLEN + len);
+	attr->nla_len = NLA_HDRLEN + len;
+	attr->nla_type = type;
+	memcpy((char *) attr + NLA_HDRLEN, value, len);
+}
+
+/* add an ack or error message for request req to reply */
+static void emu_reply_error(struct emu_reply *reply,
+			    const struct nlmsghdr *req, int error) {
+	struct nlmsgerr *err;
+	size_t offset;
+
+	offset = emu_reply_start(reply, req, NLMSG_ERROR, 0);
+	err = emu_reply_reserve(reply, sizeof(*err));
+	err->error = error;
+	err->msg = *req;
+	emu_reply_end(reply, offset);
+}
+
+/* add the entries with pnetid or all entries if pnetid is NULL to reply
+ * like a dump of the kernel
+ */
+static void emu_reply_entries(struct emu_reply *reply,
+			      const struct nlmsghdr *req, const char *pnetid) {
+	struct genlmsghdr *genl;
+	size_t offset;
+
+	for (int i = 0; i < emu_count; i++) {
+		if (pnetid && strcmp(emu_table[i].pnetid, pnetid))
+			continue;
+		offset = emu_reply_start(reply, req, EMU_FAMILY, NLM_F_MULTI);
+		genl = emu_reply_reserve(reply, GENL_HDRLEN);
+		genl->cmd = SMC_PNETID_GET;
+		genl->version = SMCR_GENL_FAMILY_VERSION;
+		emu_reply_string(reply, SMC_PNETID_NAME, emu_table[i].pnetid);
+		emu_reply_string(reply, SMC_PNETID_ETHNAME,
+				 emu_table[i].device);
+		emu_reply_end(reply, offset);
+	}
+	offset = emu_reply_start(reply, req, NLMSG_DONE, NLM_F_MULTI);
+	emu_reply_reserve(reply, sizeof(int));
+	emu_reply_end(reply, offset);
+}
+
+/* add pnetid to device in the emulated table */
+static int emu_table_add(const char *pnetid, const char *device) {
+	struct emu_entry *entry;
+
+	if (!pnetid || !device)
+		return -EINVAL;
+	if (emu_count == emu_size) {
+		emu_size = emu_size ? emu_size * 2 : 64;
+		emu_table = realloc(emu_table, emu_size * sizeof(*emu_table));
+	}
+	entry = &emu_table[emu_count++];
+	snprintf(entry->pnetid, sizeof(entry->pnetid), "%s", pnetid);
+	snprintf(entry->device, sizeof(entry->device), "%s", device);
+	return 0;
+}
+
+/* delete the entries with pnetid from the emulated table */
+static int emu_table_del(const char *pnetid) {
+	int count = 0;
+
+	if (!pnetid)
+		return -EINVAL;
+	for (int i = 0; i < emu_count; i++)
+		if (strcmp(emu_table[i].pnetid, pnetid))
+			emu_table[count++] = emu_table[i];
+	if (count == emu_count)
+		return -ENOENT;
+	emu_count = count;
+	return 0;
+}
+
+/* answer a request sent by netlink.c like the kernel */
+static int emu_send(struct nl_sock *sock, struct nl_msg *msg) {
+	struct nlmsghdr *req = nlmsg_hdr(msg);
+	struct genlmsghdr *genl = nlmsg_data(req);
+	struct nlattr *attrs[SMC_PNETID_MAX + 1];
+	const char *device = NULL;
+	const char *pnetid = NULL;
+	int rc = 0;
+
+	if (req->nlmsg_type != EMU_FAMILY) {
+		emu_reply_error(emu_reply_new(), req, -ENOENT);
+		return req->nlmsg_len;
+	}
+	if (genlmsg_parse(req, 0, attrs, SMC_PNETID_MAX, emu_policy) < 0) {
+		emu_reply_error(emu_reply_new(), req, -EINVAL);
+		return req->nlmsg_len;
+	}
+	if (attrs[SMC_PNETID_NAME])
+		pnetid = nla_get_string(attrs[SMC_PNETID_NAME]);
+	if (attrs[SMC_PNETID_ETHNAME])
+		device = nla_get_string(attrs[SMC_PNETID_ETHNAME]);
+
+	switch (genl->cmd) {
+	case SMC_PNETID_GET:
+		/* answered like a dump, without an additional ack */
+		emu_reply_entries(emu_reply_new(), req, pnetid);
+		return req->nlmsg_len;
+	case SMC_PNETID_ADD:
+		rc = emu_table_add(pnetid, device);
+		break;
+	case SMC_PNETID_DEL:
+		rc = emu_table_del(pnetid);
+		break;
+	case SMC_PNETID_FLUSH:
+		emu_count = 0;
+		break;
+	default:
+		rc = -EOPNOTSUPP;
+	}
+	if (rc || req->nlmsg_flags & NLM_F_ACK)
+		emu_reply_error(emu_reply_new(), req, rc);
+	return req->nlmsg_len;
+}
+
+/* pass the next reply datagram of the emulated kernel to libnl */
+static int emu_recv(struct nl_sock *sock, struct sockaddr_nl *addr,
+		    unsigned char **buf, struct ucred **creds) {
+	struct emu_reply *reply;
+
+	if (emu_next_reply == emu_num_replies)
+		return -NLE_AGAIN;
+	reply = &emu_replies[emu_next_reply++];
+	if (emu_next_reply == emu_num_replies)
+		emu_next_reply = emu_num_replies = 0;
+	memset(addr, 0, sizeof(*addr));
+	addr->nl_family = AF_NETLINK;
+	*buf = (unsigned char *) reply->data;
+	return reply->len;
+}
+
+/* init netlink.c like with smc and answer its requests in-process, so
+ * one-shot sockets cost the same as with smc
+ */
+static void emu_init() {
+	struct nl_cb *cb;
+
+	nl_init();
+	nl_family = EMU_FAMILY;
+	cb = nl_socket_get_cb(nl_sock);
+	nl_cb_overwrite_send(cb, emu_send);
+	nl_cb_overwrite_recv(cb, emu_recv);
+	nl_cb_put(cb);
+}
+
+static void emu_cleanup() {
+	/* drop replies that were not received */
+	for (int i = emu_next_reply; i < emu_num_replies; i++)
+		free(emu_replies[i].data);
+	emu_next_reply = emu_num_replies = 0;
+	nl_cleanup();
+}
+
+static struct bench_backend emu_backend = {
+	.name = "emulation",
+	.init = emu_init,
+	.cleanup = emu_cleanup,
+	.add = netlink_add,
+	.del = netlink_del,
+	.get = nl_get_pnetids,
+	.lookup = netlink_lookup,
+	.flush = netlink_flush,
+};
+
+/* compare latencies for qsort */
+static int bench_compare(const void *a, const void *b) {
+	uint64_t x = *(const uint64_t *) a;
+	uint64_t y = *(const uint64_t *) b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* get the pnetid of the added entry i, the number wraps around after seven
+ * digits to fit in the pnetid
+ */
+static void bench_pnetid(int i, char *pnetid) {
+	snprintf(pnetid, SMC_MAX_PNETID_LEN + 1, "%s%u", BENCH_PNETID,
+		 (unsigned int) i % 10000000);
+}
+
+/* add the next entry to the table */
+static void bench_add(struct bench_backend *backend) {
+	char pnetid[SMC_MAX_PNETID_LEN + 1];
+
+	bench_pnetid(bench_head, pnetid);
+	backend->add(pnetid, bench_devices[bench_head % bench_num_devices]);
+	bench_head++;
+}
+
+/* delete the oldest added entry from the table */
+static void bench_del(struct bench_backend *backend) {
+	char pnetid[SMC_MAX_PNETID_LEN + 1];
+
+	bench_pnetid(bench_tail, pnetid);
+	backend->del(pnetid);
+	bench_tail++;
+}
+
+/* fill the table before a flush, smc devices with an added entry already
+ * have a pnetid
+ */
+static void bench_fill(struct bench_backend *backend) {
+	char pnetid[SMC_MAX_PNETID_LEN + 1];
+	char device[IFNAMSIZ];
+
+	if (backend == &emu_backend) {
+		for (int i = 0; i < bench_table; i++) {
+			snprintf(pnetid, sizeof(pnetid), "PNET%d", i);
+			snprintf(device, sizeof(device), "emu%d", i);
+			backend->add(pnetid, device);
+		}
+		return;
+	}
+	for (int i = bench_head; i < bench_tail + bench_num_devices; i++) {
+		snprintf(pnetid, sizeof(pnetid), "PNET%d", i);
+		backend->add(pnetid, bench_devices[i % bench_num_devices]);
+	}
+}
+
+/* prepare the table for a single operation, not included in the latency:
+ * fill the table before a flush, free a device before an add, and add an
+ * entry before a del or lookup
+ */
+static void bench_prepare(struct bench_backend *backend, int op) {
+	switch (op) {
+	case BENCH_OP_ADD:
+		if (bench_head - bench_tail == bench_num_devices)
+			bench_del(backend);
+		break;
+	case BENCH_OP_DEL:
+	case BENCH_OP_LOOKUP:
+		if (bench_head == bench_tail)
+			bench_add(backend);
+		break;
+	case BENCH_OP_FLUSH:
+		bench_fill(backend);
+		break;
+	}
+}
+
+/* check if op needs a preparation of the table */
+static int bench_needs_prepare(int op) {
+	switch (op) {
+	case BENCH_OP_ADD:
+		return bench_head - bench_tail == bench_num_devices;
+	case BENCH_OP_DEL:
+	case BENCH_OP_LOOKUP:
+		return bench_head == bench_tail;
+	case BENCH_OP_FLUSH:
+		return 1;
+	}
+	return 0;
+}
+
+/* run a single operation */
+static void bench_op(struct bench_backend *backend, int op) {
+	char pnetid[SMC_MAX_PNETID_LEN + 1];
+
+	switch (op) {
+	case BENCH_OP_ADD:
+		bench_add(backend);
+		break;
+	case BENCH_OP_DEL:
+		bench_del(backend);
+		break;
+	case BENCH_OP_GET:
+		backend->get();
+		break;
+	case BENCH_OP_LOOKUP:
+		bench_pnetid(bench_tail, pnetid);
+		backend->lookup(pnetid);
+		break;
+	case BENCH_OP_FLUSH:
+		backend->flush();
+		bench_tail = bench_head;
+		break;
+	}
+}
+
+/* run the operations mix in socket mode and print the results */
+static int bench_run(struct bench_backend *backend, int mode) {
+	uint64_t *latencies[BENCH_OP_MAX];
+	int counts[BENCH_OP_MAX] = {};
+	int pattern[BENCH_OP_MAX * 100];
+	int64_t start_allocations;
+	int pattern_len = 0;
+	uint64_t total_ns = 0;
+	int64_t allocations;
+
+	/* repeat each operation by its weight */
+	for (int op = 0; op < BENCH_OP_MAX; op++)
+		for (int i = 0; i < bench_mix[op]; i++)
+			pattern[pattern_len++] = op;
+	for (int op = 0; op < BENCH_OP_MAX; op++) {
+		latencies[op] = calloc(bench_ops, sizeof(uint64_t));
+		if (!latencies[op])
+			return EXIT_FAILURE;
+	}
+
+	start_allocations = bench_allocations();
+	if (mode == BENCH_MODE_REUSED)
+		backend->init();
+	for (int i = 0; i < bench_ops; i++) {
+		int op = pattern[i % pattern_len];
+		uint64_t start_ns;
+		uint64_t ns;
+
+		if (bench_needs_prepare(op)) {
+			if (mode == BENCH_MODE_ONESHOT)
+				backend->init();
+			bench_prepare(backend, op);
+			if (mode == BENCH_MODE_ONESHOT)
+				backend->cleanup();
+		}
+
+		start_ns = stats_now();
+		if (mode == BENCH_MODE_ONESHOT)
+			backend->init();
+		bench_op(backend, op);
+		if (mode == BENCH_MODE_ONESHOT)
+			backend->cleanup();
+		ns = stats_now() - start_ns;
+
+		latencies[op][counts[op]++] = ns;
+		total_ns += ns;
+	}
+	allocations = bench_allocations() - start_allocations;
+
+	/* remove the remaining added entries */
+	if (mode == BENCH_MODE_ONESHOT)
+		backend->init();
+	while (bench_tail < bench_head)
+		bench_del(backend);
+	backend->cleanup();
+
+	printf("%s, %s socket: %d ops, %.0f ops/sec\n", backend->name,
+	       bench_mode_names[mode], bench_ops,
+	       total_ns ? bench_ops / (total_ns / 1e9) : 0);
+	for (int op = 0; op < BENCH_OP_MAX; op++) {
+		uint64_t *l = latencies[op];
+		int n = counts[op];
+
+		if (n) {
+			qsort(l, n, sizeof(uint64_t), bench_compare);
+			printf("  %-6s %7d ops, p50 %9.1f us, p90 %9.1f us, "
+			       "p99 %9.1f us, max %9.1f us\n",
+			       bench_op_names[op], n,
+			       l[(n - 1) * 50 / 100] / 1e3,
+			       l[(n - 1) * 90 / 100] / 1e3,
+			       l[(n - 1) * 99 / 100] / 1e3, l[n - 1] / 1e3);
+		}
+		free(l);
+	}
+	if (bench_json)
+		fprintf(bench_json, "{\"benchmark\":\"netlink %s %s\","
+			"\"ops\":%d,\"ops_per_sec\":%.0f,"
+			"\"allocations_per_op\":%.1f,\"maxrss_kb\":%ld}\n",
+			backend->name, bench_mode_names[mode], bench_ops,
+			total_ns ? bench_ops / (total_ns / 1e9) : 0,
+			start_allocations < 0 ? -1 :
+			(double) allocations / bench_ops, bench_maxrss_kb());
+	return EXIT_SUCCESS;
+}
+
+/* parse operations mix like "add:4,del:4,get:1,flush:1" */
+static int bench_parse_mix(char *mix) {
+	int total = 0;
+	char *token;
+
+	memset(bench_mix, 0, sizeof(bench_mix));
+	for (token = strtok(mix, ","); token; token = strtok(NULL, ",")) {
+		char *weight = strchr(token, ':');
+		int op;
+
+		if (weight)
+			*weight++ = 0;
+		for (op = 0; op < BENCH_OP_MAX; op++)
+			if (!strcmp(token, bench_op_names[op]))
+				break;
+		if (op == BENCH_OP_MAX)
+			return -1;
+		bench_mix[op] = weight ? atoi(weight) : 1;
+		if (bench_mix[op] < 0 || bench_mix[op] > 100)
+			return -1;
+		total += bench_mix[op];
+	}
+	return total ? 0 : -1;
+}
+
+/* print usage */
+static void bench_usage(const char *name) {
+	printf("Usage: %s [options]\n"
+	       "-o <ops>		Number of operations per socket mode\n"
+	       "			(default: %d)\n"
+	       "-m <mix>		Weighted mix of add, del, get,\n"
+	       "			lookup, and flush (default: %s)\n"
+	       "-n <name>		Add pnetids to net device, repeat for\n"
+	       "			more devices (default: %s)\n"
+	       "-t <entries>		Emulated table size before flush\n"
+	       "			(default: %d)\n"
+	       "-e			Use emulation even with SMC\n"
+	       "-j <file>		Append results as json lines to file\n"
+	       "-h			Print this help\n",
+	       name, BENCH_OPS, BENCH_MIX, BENCH_DEVICE, BENCH_TABLE);
+}
+
+int main(int argc, char **argv) {
+	struct bench_backend *backend = &smc_backend;
+	char mix[] = BENCH_MIX;
+	int emulation = 0;
+	int c;
+
+	bench_parse_mix(mix);
+	while ((c = getopt(argc, argv, "ehj:o:m:n:t:")) != -1) {
+		switch (c) {
+		case 'e':
+			emulation = 1;
+			break;
+		case 'j':
+			bench_json = bench_json_open(optarg);
+			if (!bench_json) {
+				printf("Cannot open \"%s\".\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'o':
+			bench_ops = atoi(optarg);
+			break;
+		case 'm':
+			if (bench_parse_mix(optarg)) {
+				bench_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'n':
+			if (bench_num_devices < BENCH_MAX_DEVICES)
+				bench_devices[bench_num_devices++] = optarg;
+			break;
+		case 't':
+			bench_table = atoi(optarg);
+			break;
+		case 'h':
+			bench_usage(argv[0]);
+			return EXIT_SUCCESS;
+		default:
+			bench_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (!bench_num_devices)
+		bench_devices[bench_num_devices++] = BENCH_DEVICE;
+	if (bench_ops <= 0) {
+		bench_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	/* fall back to emulation if smc is not available */
+	if (!emulation) {
+		nl_init();
+		if (nl_family < 0) {
+			printf("SMC is not available, using emulation.\n");
+			emulation = 1;
+		}
+		nl_cleanup();
+	}
+	if (emulation)
+		backend = &emu_backend;
+
+	for (int mode = 0; mode < BENCH_MODE_MAX; mode++)
+		if (bench_run(backend, mode))
+			return EXIT_FAILURE;
+	if (bench_json && bench_json != stdout)
+		fclose(bench_json);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,290 @@
+/*
+ * ********************
+ * *** PAIRING PART ***
+ * ********************
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "locality.h"
+#include "pairing.h"
+#include "verbose.h"
+
+/* device with the pnetid it is paired by */
+struct pairing_member {
+	const char *pnetid;
+	struct device *device;
+};
+
+/* compare members by pnetid, type, name, and port */
+static int pairing_cmp_pnetid(const void *a, const void *b) {
+	const struct pairing_member *m = a;
+	const struct pairing_member *n = b;
+	const struct device *x = m->device;
+	const struct device *y = n->device;
+	int rc;
+
+	rc = strncmp(m->pnetid, n->pnetid, SMC_MAX_PNETID_LEN);
+	if (rc)
+		return rc;
+	rc = x->kind - y->kind;
+	if (rc)
+		return rc;
+	rc = strcmp(x->name, y->name);
+	if (rc)
+		return rc;
+	return x->ib_port - y->ib_port;
+}
+
+/* compare devices by name */
+static int pairing_cmp_name(const void *a, const void *b) {
+	const struct device *x = *(struct device * const *) a;
+	const struct device *y = *(struct device * const *) b;
+
+	return strcmp(x->name, y->name);
+}
+
+/* compare a pnetid key with an index entry */
+static int pairing_cmp_entry(const void *key, const void *entry) {
+	const struct pairing_entry *e = entry;
+
+	return strncmp(key, e->pnetid, SMC_MAX_PNETID_LEN);
+}
+
+/* compare a name key with a net device */
+static int pairing_cmp_key_name(const void *key, const void *device) {
+	const struct device *d = *(struct device * const *) device;
+
+	return strcmp(key, d->name);
+}
+
+/* get the pnetid a device is paired by, for stacked net devices like vlans
+ * and bonds this is the pnetid of the lowest net device as in the kernel
+ */
+static const char *pairing_pnetid(struct pairing_index *index,
+				  struct device *device) {
+	struct device *lowest;
+
+	if (device->kind != DEVICE_KIND_NET || !device->lowest ||
+	    !strcmp(device->lowest, device->name))
+		return device->pnetid;
+	lowest = pairing_find_net(index, device->lowest);
+	if (!lowest || !lowest->pnetid[0])
+		return device->pnetid;
+	return lowest->pnetid;
+}
+
+/* build the pairing index of the devices list, the devices must not be
+ * changed or freed before pairing_free() is called
+ */
+int pairing_build(struct pairing_index *index) {
+	struct pairing_member *members = NULL;
+	struct pairing_entry *entry = NULL;
+	struct device *device;
+	int num_members = 0;
+	int num_pnetids = 0;
+	int num_net = 0;
+
+	memset(index, 0, sizeof(*index));
+	device = get_next_device(&devices_list);
+	for (; device; device = get_next_device(device)) {
+		if (device->kind == DEVICE_KIND_NET)
+			num_net++;
+		else if (device->pnetid[0])
+			num_pnetids++;
+	}
+	members = calloc(num_pnetids + num_net + 1, sizeof(*members));
+	index->devices = calloc(num_pnetids + num_net + 1,
+				sizeof(*index->devices));
+	index->entries = calloc(num_pnetids + num_net + 1,
+				sizeof(*index->entries));
+	index->net = calloc(num_net + 1, sizeof(*index->net));
+	if (!members || !index->devices || !index->entries || !index->net) {
+		free(members);
+		pairing_free(index);
+		return -1;
+	}
+
+	/* collect net devices to find the lowest net devices */
+	device = get_next_device(&devices_list);
+	for (; device; device = get_next_device(device))
+		if (device->kind == DEVICE_KIND_NET)
+			index->net[index->num_net++] = device;
+	qsort(index->net, index->num_net, sizeof(*index->net),
+	      pairing_cmp_name);
+
+	/* collect devices with pnetid */
+	device = get_next_device(&devices_list);
+	for (; device; device = get_next_device(device)) {
+		members[num_members].pnetid = pairing_pnetid(index, device);
+		members[num_members].device = device;
+		if (members[num_members].pnetid[0])
+			num_members++;
+	}
+	qsort(members, num_members, sizeof(*members), pairing_cmp_pnetid);
+
+	/* devices with the same pnetid are adjacent and sorted by type */
+	for (int i = 0; i < num_members; i++) {
+		device = members[i].device;
+		index->devices[i] = device;
+		if (!entry || strncmp(entry->pnetid, members[i].pnetid,
+				      SMC_MAX_PNETID_LEN)) {
+			entry = &index->entries[index->num_entries++];
+			entry->pnetid = members[i].pnetid;
+		}
+		switch (device->kind) {
+		case DEVICE_KIND_NET:
+			if (!entry->num_net)
+				entry->net = &index->devices[i];
+			entry->num_net++;
+			break;
+		case DEVICE_KIND_IB:
+			if (!entry->num_ib)
+				entry->ib = &index->devices[i];
+			entry->num_ib++;
+			break;
+		case DEVICE_KIND_ISM:
+			if (!entry->num_ism)
+				entry->ism = &index->devices[i];
+			entry->num_ism++;
+			break;
+		}
+	}
+	free(members);
+	log_debug("Built pairing index with %d pnetids and %d net devices.\n",
+		  index->num_entries, index->num_net);
+	return 0;
+}
+
+/* find the index entry of pnetid */
+struct pairing_entry *pairing_find_pnetid(struct pairing_index *index,
+					  const char *pnetid) {
+	return bsearch(pnetid, index->entries, index->num_entries,
+		       sizeof(*index->entries), pairing_cmp_entry);
+}
+
+/* find the net device with name */
+struct device *pairing_find_net(struct pairing_index *index,
+				const char *name) {
+	struct device **device;
+
+	device = bsearch(name, index->net, index->num_net, sizeof(*index->net),
+			 pairing_cmp_key_name);
+	return device ? *device : NULL;
+}
+
+/* print the header of the pairs on screen */
+static void pairing_print_header() {
+	printf("==========================================================");
+	printf("==========\n");
+	printf("%-15.15s %-16s %5.5s %15.15s %6.6s", "Net device:",
+	       "Pnetid:", "Type:", "Partner:", "Port:");
+	if (locality_mode)
+		printf(" %s", "Locality:");
+	printf("\n");
+	printf("==========================================================");
+	printf("==========\n");
+}
+
+/* print a pair of the net device (NULL if there is none) and partner on
+ * screen
+ */
+static void pairing_print_pair(struct device *device, const char *pnetid,
+			       struct device *partner) {
+	printf("%-15.15s %-16s", device ? device->name : "n/a", pnetid);
+	printf(" %5.5s %15.15s", device_kind_labels[partner->kind],
+	       partner->name);
+	if (partner->kind == DEVICE_KIND_IB)
+		printf(" %6d", partner->ib_port);
+	else if (locality_mode)
+		printf(" %6.6s", "");
+	if (locality_mode)
+		printf(" %s", locality_names[device ?
+		       locality_level(device, partner) : LOCALITY_UNKNOWN]);
+	printf("\n");
+}
+
+/* print the pairs of net device on screen */
+static void pairing_print_net(struct pairing_index *index,
+			      struct device *device) {
+	const char *pnetid = pairing_pnetid(index, device);
+	struct pairing_entry *entry = NULL;
+
+	if (pnetid[0])
+		entry = pairing_find_pnetid(index, pnetid);
+	if (!entry) {
+		printf("%-15.15s %-16s %5.5s %15.15s\n", device->name, "n/a",
+		       "n/a", "no pnetid");
+		return;
+	}
+	if (!entry->num_ib && !entry->num_ism) {
+		printf("%-15.15s %-16s %5.5s %15.15s\n", device->name,
+		       entry->pnetid, "n/a", "no partner");
+		return;
+	}
+	for (int i = 0; i < entry->num_ib; i++)
+		pairing_print_pair(device, entry->pnetid, entry->ib[i]);
+	for (int i = 0; i < entry->num_ism; i++)
+		pairing_print_pair(device, entry->pnetid, entry->ism[i]);
+}
+
+/* print the usable pairs of the net device with name or of all net devices
+ * if name is NULL on screen, devices without partner are reported as well
+ */
+int pairing_print(struct pairing_index *index, const char *name) {
+	struct pairing_entry *entry;
+	struct device *device;
+
+	if (name) {
+		device = pairing_find_net(index, name);
+		if (!device) {
+			log_error("Net device \"%s\" not found.\n", name);
+			return -1;
+		}
+		pairing_print_header();
+		pairing_print_net(index, device);
+		return 0;
+	}
+
+	pairing_print_header();
+	for (int i = 0; i < index->num_net; i++)
+		pairing_print_net(index, index->net[i]);
+
+	/* ib and ism devices without net device */
+	for (int i = 0; i < index->num_entries; i++) {
+		entry = &index->entries[i];
+		if (entry->num_net)
+			continue;
+		for (int j = 0; j < entry->num_ib; j++)
+			pairing_print_pair(NULL, entry->pnetid, entry->ib[j]);
+		for (int j = 0; j < entry->num_ism; j++)
+			pairing_print_pair(NULL, entry->pnetid, entry->ism[j]);
+	}
+	return 0;
+}
+
+/* build the pairing index of the devices list and print the pairs of the
+ * net device with name or of all net devices if name is NULL on screen
+ */
+int pairing_print_devices(const char *name) {
+	struct pairing_index index;
+	int rc;
+
+	if (pairing_build(&index)) {
+		log_error("Cannot build pairing index.\n");
+		return -1;
+	}
+	rc = pairing_print(&index, name);
+	pairing_free(&index);
+	return rc;
+}
+
+/* free the pairing index */
+void pairing_free(struct pairing_index *index) {
+	free(index->devices);
+	free(index->entries);
+	free(index->net);
+	memset(index, 0, sizeof(*index));
+}
@@ -0,0 +1,44 @@
+#ifndef _PNETCTL_PAIRING_H
+#define _PNETCTL_PAIRING_H
+
+#include "devices.h"
+
+/* print pairs instead of the device table, disabled by default */
+extern int pairs_mode;
+
+/* only print pairs of this net device, if set */
+extern const char *pairs_device;
+
+/* devices with the same pnetid that can be used together for SMC-R (net
+ * and ib devices) and SMC-D (net and ism devices), stacked net devices are
+ * paired by the pnetid of their lowest net device
+ */
+struct pairing_entry {
+	const char *pnetid;
+	struct device **net;
+	int num_net;
+	struct device **ib;
+	int num_ib;
+	struct device **ism;
+	int num_ism;
+};
+
+/* index of the devices list by pnetid and net device name */
+struct pairing_index {
+	struct device **devices; /* devices with pnetid sorted by pnetid */
+	struct pairing_entry *entries; /* sorted by pnetid */
+	int num_entries;
+	struct device **net; /* all net devices sorted by name */
+	int num_net;
+};
+
+int pairing_build(struct pairing_index *index);
+struct pairing_entry *pairing_find_pnetid(struct pairing_index *index,
+					  const char *pnetid);
+struct device *pairing_find_net(struct pairing_index *index,
+				const char *name);
+int pairing_print(struct pairing_index *index, const char *name);
+int pairing_print_devices(const char *name);
+void pairing_free(struct pairing_index *index);
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * test for pairing
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include "test.h"
+#include "pairing.h"
+
+/* add net, ib, and ism devices with different pnetids */
+static void add_devices() {
+	test_add_device("net", "eth0", -1, NULL, "PNET1");
+	test_add_device("net", "eth1", -1, NULL, "PNET2");
+	test_add_device("net", "eth2", -1, NULL, "");
+	test_add_device("net", "eth3", -1, NULL, "PNET1");
+	test_add_device("infiniband", "mlx5_0", 1, NULL, "PNET1");
+	test_add_device("infiniband", "mlx5_0", 2, NULL, "PNET3");
+	test_add_device("ism", "0000:00:00.5", -1, NULL, "PNET1");
+	test_add_device("ism", "0000:00:00.6", -1, NULL, "PNET2");
+}
+
+// test the function pairing_build()
+int test_pairing_build() {
+	struct pairing_index index;
+	int rc = -1;
+
+	add_devices();
+	if (pairing_build(&index))
+		goto out;
+	if (index.num_entries != 3 || index.num_net != 4 ||
+	    strcmp(index.net[0]->name, "eth0") ||
+	    strcmp(index.net[3]->name, "eth3"))
+		goto free;
+	rc = 0;
+free:
+	pairing_free(&index);
+out:
+	free_devices();
+	return rc;
+}
+
+// test the function pairing_find_pnetid()
+int test_pairing_find_pnetid() {
+	struct pairing_index index;
+	struct pairing_entry *entry;
+	int rc = -1;
+
+	add_devices();
+	if (pairing_build(&index))
+		goto out;
+
+	/* net devices with ib and ism partners */
+	entry = pairing_find_pnetid(&index, "PNET1");
+	if (!entry || entry->num_net != 2 || entry->num_ib != 1 ||
+	    entry->num_ism != 1 || strcmp(entry->net[1]->name, "eth3") ||
+	    entry->ib[0]->ib_port != 1 ||
+	    strcmp(entry->ism[0]->name, "0000:00:00.5"))
+		goto free;
+
+	/* net device with ism partner only */
+	entry = pairing_find_pnetid(&index, "PNET2");
+	if (!entry || entry->num_net != 1 || entry->num_ib != 0 ||
+	    entry->num_ism != 1)
+		goto free;
+
+	/* ib device without net device */
+	entry = pairing_find_pnetid(&index, "PNET3");
+	if (!entry || entry->num_net != 0 || entry->num_ib != 1 ||
+	    entry->ib[0]->ib_port != 2)
+		goto free;
+
+	if (pairing_find_pnetid(&index, "PNET4"))
+		goto free;
+	rc = 0;
+free:
+	pairing_free(&index);
+out:
+	free_devices();
+	return rc;
+}
+
+// test the function pairing_build() with stacked net devices
+int test_pairing_build_stacked() {
+	struct pairing_index index;
+	struct pairing_entry *entry;
+	int rc = -1;
+
+	/* vlan and bond get the pnetid of their lowest net devices */
+	test_add_device("net", "eth0", -1, NULL, "PNET1");
+	test_add_device("net", "eth1", -1, NULL, "");
+	test_add_device("net", "eth0.10", -1, NULL, "")->lowest = "eth0";
+	test_add_device("net", "bond0", -1, NULL, "")->lowest = "eth1";
+	test_add_device("infiniband", "mlx5_0", 1, NULL, "PNET1");
+	if (pairing_build(&index))
+		goto out;
+
+	entry = pairing_find_pnetid(&index, "PNET1");
+	if (!entry || entry->num_net != 2 || entry->num_ib != 1 ||
+	    strcmp(entry->net[0]->name, "eth0") ||
+	    strcmp(entry->net[1]->name, "eth0.10"))
+		goto free;
+	if (index.num_entries != 1 || pairing_print(&index, "eth0.10") ||
+	    pairing_print(&index, "bond0"))
+		goto free;
+	rc = 0;
+free:
+	pairing_free(&index);
+out:
+	free_devices();
+	return rc;
+}
+
+// test the function pairing_find_net()
+int test_pairing_find_net() {
+	struct pairing_index index;
+	struct device *device;
+	int rc = -1;
+
+	add_devices();
+	if (pairing_build(&index))
+		goto out;
+	device = pairing_find_net(&index, "eth2");
+	if (!device || device->pnetid[0])
+		goto free;
+	if (pairing_find_net(&index, "mlx5_0") ||
+	    pairing_find_net(&index, "eth4"))
+		goto free;
+	rc = 0;
+free:
+	pairing_free(&index);
+out:
+	free_devices();
+	return rc;
+}
+
+// test the function pairing_print()
+int test_pairing_print() {
+	struct pairing_index index;
+	int rc = -1;
+
+	add_devices();
+	if (pairing_build(&index))
+		goto out;
+	if (pairing_print(&index, NULL) || pairing_print(&index, "eth1") ||
+	    !pairing_print(&index, "eth4"))
+		goto free;
+	rc = 0;
+free:
+	pairing_free(&index);
+out:
+	free_devices();
+	return rc;
+}
+
+// test the function pairing_print() with an empty devices list
+int test_pairing_print_empty() {
+	struct pairing_index index;
+
+	if (pairing_build(&index))
+		return -1;
+	if (pairing_print(&index, NULL)) {
+		pairing_free(&index);
+		return -1;
+	}
+	pairing_free(&index);
+	return 0;
+}
+
+struct test tests[] = {
+	{"pairing_build", test_pairing_build},
+	{"pairing_build_stacked", test_pairing_build_stacked},
+	{"pairing_find_pnetid", test_pairing_find_pnetid},
+	{"pairing_find_net", test_pairing_find_net},
+	{"pairing_print", test_pairing_print},
+	{"pairing_print_empty", test_pairing_print_empty},
+	{NULL, NULL},
+};
+
+int main(int argc, char** argv) {
+	return run_test(tests, argc, argv);
+}
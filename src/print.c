@@ -2,6 +2,9 @@
 #include <string.h>
 
 #include "devices.h"
+#include "locality.h"
+#include "netlink.h"
+#include "print.h"
 
 /* print a horizontal line on screen */
 void print_line() {
@@ -18,30 +21,43 @@ void print_bold_line() {
 /* print the header on screen */
 void print_header() {
 	print_bold_line();
-	printf("%-16s %5.5s %15.15s %6.6s %5.5s %16.16s\n", "Pnetid:", "Type:",
+	printf("%-16s %5.5s %15.15s %6.6s %5.5s %16.16s", "Pnetid:", "Type:",
 	       "Name:", "Port:", "Bus:", "Bus-ID:");
+	if (locality_mode)
+		printf(" %5.5s %-12.12s %s", "Node:", "CPUs:", "PCI path:");
+	printf("\n");
 	print_bold_line();
 }
 
+/* print the network namespace of the following device table on screen */
+void print_netns(const char *name) {
+	printf("Network namespace: %s\n", name);
+}
+
 /* print the pnetid on screen */
 void print_pnetid(char *pnetid) {
-	printf("%s\n", pnetid);
+	int score;
+
+	if (locality_mode && strcmp(pnetid, "n/a")) {
+		score = locality_score(pnetid);
+		printf("%-16s locality: %d/%d (%s)\n", pnetid, score,
+		       LOCALITY_MAX - 1, locality_names[score]);
+	} else {
+		printf("%s\n", pnetid);
+	}
 	print_line();
 }
 
 /* print device on screen */
 void print_device(struct device *device) {
 	printf("%-16s", "");
-	if (!strncmp(device->subsystem, "infiniband", 10)) {
-		printf(" %5.5s", "ib");
-		printf(" %15.15s", device->name);
+	printf(" %5.5s", device_kind_labels[device->kind]);
+	printf(" %15.15s", device->name);
+	if (device->kind == DEVICE_KIND_IB)
 		printf(" %6d", device->ib_port);
-	} else {
-		printf(" %5.5s", device->subsystem);
-		printf(" %15.15s", device->name);
+	else
 		printf(" %6.6s", "");
-	}
-	if (device->parent_subsystem)
+	if (device->bus != DEVICE_BUS_NONE)
 		printf("   %3.3s", device->parent_subsystem);
 	else
 		printf(" %5.5s", "n/a");
@@ -49,9 +65,22 @@ void print_device(struct device *device) {
 		printf(" %16.16s", device->parent);
 	else
 		printf(" %16.16s", "n/a");
+	if (locality_mode && device->pci_path)
+		printf(" %5d %-12.12s %s", device->numa_node,
+		       device->local_cpulist, device->pci_path);
+	else if (locality_mode)
+		printf(" %5.5s %-12.12s %s", "n/a", "n/a", "n/a");
 	printf("\n");
 }
 
+/* check if pnetid matches one of the pnetid filters */
+static int print_filter_match(const char *pnetid) {
+	for (int i = 0; i < num_pnetid_filters; i++)
+		if (!strncmp(pnetid, pnetid_filters[i], SMC_MAX_PNETID_LEN))
+			return 1;
+	return 0;
+}
+
 /* print all devices on screen */
 void print_device_table() {
 	int pnetid_found = 1;
@@ -73,10 +102,11 @@ void print_device_table() {
 				continue;
 			}
 
-			/* if pnetid filter is active, only show this pnetid */
-			if (pnetid_filter) {
-				if (!strncmp(next->pnetid, pnetid_filter,
-					     SMC_MAX_PNETID_LEN)) {
+			/* if a single pnetid filter is active, only show this
+			 * pnetid
+			 */
+			if (num_pnetid_filters == 1) {
+				if (print_filter_match(next->pnetid)) {
 					print_device(next);
 					next->output = 1;
 				}
@@ -95,6 +125,13 @@ void print_device_table() {
 				continue;
 			}
 
+			/* skip pnetids not matching multiple pnetid filters */
+			if (num_pnetid_filters &&
+			    !print_filter_match(next->pnetid)) {
+				next = get_next_device(next);
+				continue;
+			}
+
 			/* found new pnetid in list */
 			pnetid_found = 1;
 			pnetid = next->pnetid;
@@ -103,12 +140,12 @@ void print_device_table() {
 			next->output = 1;
 			next = get_next_device(next);
 		}
-		if (pnetid_found && !pnetid_filter)
+		if (pnetid_found && num_pnetid_filters != 1)
 			print_line();
 	}
 
 	/* print remaining devices */
-	if (pnetid_filter)
+	if (num_pnetid_filters)
 		return;
 	print_pnetid("n/a");
 	next = get_next_device(&devices_list);
@@ -119,3 +156,45 @@ void print_device_table() {
 	}
 }
 
+
+/* print the header of the pnetid table on screen */
+void print_pnet_header() {
+	print_bold_line();
+	printf("%-16s %16.16s %16.16s %6.6s\n", "Pnetid:", "Net device:",
+	       "IB/ISM device:", "Port:");
+	print_bold_line();
+}
+
+/* print an entry of the pnetid table on screen */
+void print_pnet_entry(const struct nl_pnetid *entry) {
+	printf("%-16s", entry->pnetid);
+	printf(" %16.16s", entry->eth_name ? entry->eth_name : "n/a");
+	printf(" %16.16s", entry->ib_name ? entry->ib_name : "n/a");
+	if (entry->ib_port != -1)
+		printf(" %6d", entry->ib_port);
+	else
+		printf(" %6.6s", "n/a");
+	printf("\n");
+}
+
+/* print the result of adding pnetid to each device on screen */
+void print_add_results(const char *pnetid, struct device **devices,
+		       int *results, int count) {
+	struct device *device;
+
+	print_bold_line();
+	printf("%-16s %5.5s %15.15s %6.6s  %s\n", "Pnetid:", "Type:", "Name:",
+	       "Port:", "Result:");
+	print_bold_line();
+	for (int i = 0; i < count; i++) {
+		device = devices[i];
+		printf("%-16s", pnetid);
+		printf(" %5.5s", device_kind_labels[device->kind]);
+		printf(" %15.15s", device->name);
+		if (device->kind == DEVICE_KIND_IB)
+			printf(" %6d", device->ib_port);
+		else
+			printf(" %6.6s", "");
+		printf("  %s\n", results[i] ? strerror(-results[i]) : "ok");
+	}
+}
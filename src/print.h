@@ -1,6 +1,14 @@
 #ifndef _PNETCTL_PRINT_H
 #define _PNETCTL_PRINT_H
 
+struct nl_pnetid;
+struct device;
+
+void print_netns(const char *name);
 void print_device_table();
+void print_pnet_header();
+void print_pnet_entry(const struct nl_pnetid *entry);
+void print_add_results(const char *pnetid, struct device **devices,
+		       int *results, int count);
 
 #endif
@@ -14,22 +14,24 @@
 // test the function print_device_table()
 int test_print_device_table() {
 	// empty device table, no filter
-	pnetid_filter = NULL;
+	num_pnetid_filters = 0;
 	print_device_table();
 
 	// empty device table, (not matching) filter
-	pnetid_filter = "DOES_NOT_MATCH";
+	pnetid_filters[0] = "DOES_NOT_MATCH";
+	num_pnetid_filters = 1;
 	print_device_table();
 
 	// fill device table
 	udev_scan_devices();
 
 	// filled device table, no filter
-	pnetid_filter = NULL;
+	num_pnetid_filters = 0;
 	print_device_table();
 
 	// filled device table, (not matching) filter
-	pnetid_filter = "DOES_NOT_MATCH";
+	pnetid_filters[0] = "DOES_NOT_MATCH";
+	num_pnetid_filters = 1;
 	print_device_table();
 
 	// add a pnetid and get pnetids
@@ -38,11 +40,17 @@ int test_print_device_table() {
 	nl_get_pnetids();
 
 	// filled device table, no filter
-	pnetid_filter = NULL;
+	num_pnetid_filters = 0;
 	print_device_table();
 
 	// filled device table, filter
-	pnetid_filter = "PNETCTL";
+	pnetid_filters[0] = "PNETCTL";
+	num_pnetid_filters = 1;
+	print_device_table();
+
+	// filled device table, multiple filters
+	pnetid_filters[1] = "DOES_NOT_MATCH";
+	num_pnetid_filters = 2;
 	print_device_table();
 
 	// cleanup
@@ -52,15 +60,23 @@ int test_print_device_table() {
 	return 0;
 }
 
+// test the functions print_pnet_header() and print_pnet_entry()
+int test_print_pnet_table() {
+	struct nl_pnetid eth = {"PNETCTL", "lo", NULL, -1};
+	struct nl_pnetid ib = {"PNETCTL", NULL, "mlx5_1", 1};
+
+	print_pnet_header();
+	print_pnet_entry(&eth);
+	print_pnet_entry(&ib);
+	return 0;
+}
+
 struct test tests[] = {
 	{"print_device_table", test_print_device_table},
+	{"print_pnet_table", test_print_pnet_table},
 	{NULL, NULL},
 };
 
 int main(int argc, char** argv) {
-	const char *name = NULL;
-	if (argc > 1) {
-		name = argv[1];
-	}
-	return run_test(tests, name);
+	return run_test(tests, argc, argv);
 }
@@ -0,0 +1,117 @@
+/*
+ * ******************
+ * *** PROBE PART ***
+ * ******************
+ */
+
+#define _GNU_SOURCE
+
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+
+#include "probe.h"
+#include "stats.h"
+#include "verbose.h"
+
+#define PROBE_DENTS_SIZE 8192 /* buffer size for reading directory entries */
+
+/* directory entry as returned by getdents64 */
+struct probe_dirent {
+	uint64_t d_ino;
+	int64_t d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+};
+
+/* cached directory fds of sysfs device directories, probes of attributes
+ * are relative to these fds so the path is only resolved once
+ */
+static struct probe_entry {
+	char path[PATH_MAX];
+	int fd;
+} probe_cache[PROBE_CACHE_SIZE];
+static int probe_next;
+
+/* get a directory fd of path from the cache or open it, the fd belongs to
+ * the cache and is closed by probe_cleanup(). Paths of deep pci topologies
+ * are cached as well, only paths that cannot be opened are too long.
+ */
+int probe_dir(const char *path) {
+	struct probe_entry *entry;
+	int fd;
+
+	if (strlen(path) >= PATH_MAX)
+		return -1;
+	for (int i = 0; i < PROBE_CACHE_SIZE; i++)
+		if (probe_cache[i].path[0] &&
+		    !strcmp(probe_cache[i].path, path))
+			return probe_cache[i].fd;
+
+	fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd == -1)
+		return -1;
+
+	/* replace the oldest entry */
+	entry = &probe_cache[probe_next];
+	probe_next = (probe_next + 1) % PROBE_CACHE_SIZE;
+	if (entry->path[0])
+		close(entry->fd);
+	strcpy(entry->path, path);
+	entry->fd = fd;
+	log_trace("Opened probe directory \"%s\".\n", path);
+	return fd;
+}
+
+/* find the entry of directory dir_fd starting with prefix and copy the rest
+ * of the smallest such entry name to name, reads the directory with one
+ * getdents call for typical sysfs directories
+ */
+int probe_find_prefix(int dir_fd, const char *prefix, char *name,
+		      size_t len) {
+	size_t prefix_len = strlen(prefix);
+	char buffer[PROBE_DENTS_SIZE];
+	struct probe_dirent *dirent;
+	int found = 0;
+	long count;
+
+	/* cached fds may have been read before */
+	if (lseek(dir_fd, 0, SEEK_SET) == -1)
+		return -1;
+	stats_inc(STATS_SYSFS_READS);
+	while ((count = syscall(SYS_getdents64, dir_fd, buffer,
+				sizeof(buffer))) > 0) {
+		for (long pos = 0; pos < count; pos += dirent->d_reclen) {
+			dirent = (struct probe_dirent *) (buffer + pos);
+			if (strncmp(dirent->d_name, prefix, prefix_len))
+				continue;
+			if (strlen(dirent->d_name + prefix_len) >= len)
+				continue;
+			if (found && strcmp(dirent->d_name + prefix_len,
+					    name) >= 0)
+				continue;
+			strcpy(name, dirent->d_name + prefix_len);
+			found = 1;
+		}
+	}
+	if (count == -1)
+		return -1;
+	return found ? 0 : -1;
+}
+
+/* close the cached directory fds, sysfs directories of removed devices may
+ * be reused by new devices, so the cache must not outlive a scan
+ */
+void probe_cleanup() {
+	for (int i = 0; i < PROBE_CACHE_SIZE; i++) {
+		if (!probe_cache[i].path[0])
+			continue;
+		close(probe_cache[i].fd);
+		probe_cache[i].path[0] = 0;
+	}
+	probe_next = 0;
+}
@@ -0,0 +1,12 @@
+#ifndef _PNETCTL_PROBE_H
+#define _PNETCTL_PROBE_H
+
+#include <stddef.h>
+
+#define PROBE_CACHE_SIZE 4 /* number of cached directory fds */
+
+int probe_dir(const char *path);
+int probe_find_prefix(int dir_fd, const char *prefix, char *name, size_t len);
+void probe_cleanup();
+
+#endif
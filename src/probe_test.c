@@ -0,0 +1,130 @@
+/*
+ * test for probe
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "test.h"
+#include "fixture.h"
+#include "probe.h"
+
+/* create a directory with the entries in names */
+static int create_dir(const char *root, const char **names, int count) {
+	char path[PATH_MAX];
+	int fd;
+
+	for (int i = 0; i < count; i++) {
+		snprintf(path, sizeof(path), "%s/%s", root, names[i]);
+		fd = open(path, O_WRONLY | O_CREAT, 0644);
+		if (fd == -1)
+			return -1;
+		close(fd);
+	}
+	return 0;
+}
+
+// test the function probe_dir()
+int test_probe_dir() {
+	char root[] = "/tmp/pnetctl_test_probe.XXXXXX";
+	char path[PATH_MAX];
+	int rc = -1;
+	int fd;
+
+	if (!mkdtemp(root))
+		return -1;
+
+	/* the fd of a path is cached */
+	fd = probe_dir(root);
+	if (fd == -1 || probe_dir(root) != fd)
+		goto out;
+
+	/* the oldest entry is replaced and its fd is closed */
+	for (int i = 0; i < PROBE_CACHE_SIZE; i++) {
+		snprintf(path, sizeof(path), "%s/dir%d", root, i);
+		if (mkdir(path, 0755) || probe_dir(path) == -1)
+			goto out;
+	}
+	if (fcntl(fd, F_GETFD) != -1)
+		goto out;
+
+	if (probe_dir("/tmp/pnetctl_test_probe_missing") != -1)
+		goto out;
+
+	/* paths of deep pci topologies are longer than 256 bytes */
+	snprintf(path, sizeof(path), "%s", root);
+	for (int i = 0; i < 4; i++) {
+		snprintf(path + strlen(path), sizeof(path) - strlen(path),
+			 "/pci0000:00-0000:00:01.0-0000:01:00.0-0000:02:00.0-"
+			 "0000:03:00.0-0000:04:00.0-%d", i);
+		if (mkdir(path, 0755))
+			goto out;
+	}
+	if (strlen(path) < 256 || probe_dir(path) == -1)
+		goto out;
+	rc = 0;
+out:
+	probe_cleanup();
+	fixture_remove(root);
+	return rc;
+}
+
+// test the function probe_find_prefix()
+int test_probe_find_prefix() {
+	const char *names[] = {
+		"address",
+		"lower_eth1",
+		"lower_eth0",
+		"lower_bond0.100",
+		"upper_br0",
+	};
+	char root[] = "/tmp/pnetctl_test_probe.XXXXXX";
+	char name[16];
+	int rc = -1;
+	int fd;
+
+	if (!mkdtemp(root))
+		return -1;
+	if (create_dir(root, names, sizeof(names) / sizeof(names[0])))
+		goto out;
+	fd = probe_dir(root);
+	if (fd == -1)
+		goto out;
+
+	/* the smallest name is found, also on the cached fd */
+	for (int i = 0; i < 2; i++) {
+		if (probe_find_prefix(fd, "lower_", name, sizeof(name)) ||
+		    strcmp(name, "bond0.100"))
+			goto out;
+	}
+
+	/* names that do not fit are skipped */
+	if (probe_find_prefix(fd, "lower_", name, 5) || strcmp(name, "eth0"))
+		goto out;
+	if (!probe_find_prefix(fd, "lower_", name, 4))
+		goto out;
+	if (!probe_find_prefix(fd, "util_string", name, sizeof(name)))
+		goto out;
+	rc = 0;
+out:
+	probe_cleanup();
+	fixture_remove(root);
+	return rc;
+}
+
+struct test tests[] = {
+	{"probe_dir", test_probe_dir},
+	{"probe_find_prefix", test_probe_find_prefix},
+	{NULL, NULL},
+};
+
+int main(int argc, char** argv) {
+	return run_test(tests, argc, argv);
+}
@@ -0,0 +1,145 @@
+/*
+ * *******************
+ * *** SELECT PART ***
+ * *******************
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <fnmatch.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include "select.h"
+#include "stats.h"
+#include "sysfs.h"
+#include "verbose.h"
+
+/* check if name is a glob pattern instead of a device name */
+int select_is_pattern(const char *name) {
+	return strpbrk(name, "*?[") != NULL;
+}
+
+/* initialize selector of type for devices of kind with pattern */
+int select_init(struct selector *selector, int type, int kind,
+		const char *pattern) {
+	char regex[strlen(pattern) + 5];
+
+	memset(selector, 0, sizeof(*selector));
+	selector->type = type;
+	selector->kind = kind;
+	selector->pattern = pattern;
+	if (type != SELECT_TYPE_REGEX)
+		return 0;
+
+	/* the whole device name must match like with glob patterns */
+	snprintf(regex, sizeof(regex), "^(%s)$", pattern);
+	if (regcomp(&selector->regex, regex, REG_EXTENDED | REG_NOSUB)) {
+		log_error("Invalid regular expression \"%s\".\n", pattern);
+		return -1;
+	}
+	return 0;
+}
+
+/* free selector */
+void select_free(struct selector *selector) {
+	if (selector->type == SELECT_TYPE_REGEX)
+		regfree(&selector->regex);
+}
+
+/* check if the pci parent of device is a virtual function of the physical
+ * function with bus-id
+ */
+static int select_is_vf_of(struct device *device, const char *bus_id) {
+	char path[strlen(sysfs_root) + strlen(device->parent) + 32];
+	char link[PATH_MAX];
+	const char *physfn;
+	ssize_t len;
+
+	snprintf(path, sizeof(path), "%s/bus/pci/devices/%s/physfn",
+		 sysfs_root, device->parent);
+	len = readlink(path, link, sizeof(link) - 1);
+	if (len < 0)
+		return 0;
+	stats_inc(STATS_SYSFS_READS);
+	link[len] = 0;
+	physfn = strrchr(link, '/');
+	physfn = physfn ? physfn + 1 : link;
+	return !strcmp(physfn, bus_id);
+}
+
+/* check if device matches selector */
+int select_match(struct selector *selector, struct device *device) {
+	switch (selector->kind) {
+	case DEVICE_KIND_NET:
+		if (device->kind != DEVICE_KIND_NET)
+			return 0;
+		break;
+	case DEVICE_KIND_IB:
+		/* ism devices are specified like ib devices */
+		if (device->kind != DEVICE_KIND_IB &&
+		    device->kind != DEVICE_KIND_ISM)
+			return 0;
+		break;
+	}
+
+	switch (selector->type) {
+	case SELECT_TYPE_GLOB:
+		return !fnmatch(selector->pattern, device->name, 0);
+	case SELECT_TYPE_REGEX:
+		return !regexec(&selector->regex, device->name, 0, NULL, 0);
+	case SELECT_TYPE_BUS_ID:
+		return device->parent &&
+			!strncmp(device->parent, selector->pattern,
+				 strlen(selector->pattern));
+	case SELECT_TYPE_PARENT:
+		if (!device->parent)
+			return 0;
+		if (!strcmp(device->parent, selector->pattern))
+			return 1;
+		return device->bus == DEVICE_BUS_PCI &&
+			select_is_vf_of(device, selector->pattern);
+	}
+	return 0;
+}
+
+/* find all devices in the devices list matching any of the selectors in one
+ * pass, infiniband devices only with ib_port unless it is -1. Returns the
+ * number of devices
+ */
+int select_devices(struct selector *selectors, int num_selectors,
+		   int ib_port, struct device ***devices) {
+	struct device **new_devices;
+	struct device *device;
+	int count = 0;
+	int size = 0;
+	int i;
+
+	*devices = NULL;
+	device = get_next_device(&devices_list);
+	for (; device; device = get_next_device(device)) {
+		if (ib_port != -1 && device->kind == DEVICE_KIND_IB &&
+		    device->ib_port != ib_port)
+			continue;
+		for (i = 0; i < num_selectors; i++)
+			if (select_match(&selectors[i], device))
+				break;
+		if (i == num_selectors)
+			continue;
+		if (count == size) {
+			size = size ? size * 2 : 16;
+			new_devices = realloc(*devices,
+					      size * sizeof(**devices));
+			if (!new_devices) {
+				free(*devices);
+				*devices = NULL;
+				return -1;
+			}
+			*devices = new_devices;
+		}
+		(*devices)[count++] = device;
+	}
+	log_info("Selected %d devices.\n", count);
+	return count;
+}
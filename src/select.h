@@ -0,0 +1,34 @@
+#ifndef _PNETCTL_SELECT_H
+#define _PNETCTL_SELECT_H
+
+#include <regex.h>
+
+#include "devices.h"
+
+#define MAX_SELECTORS 16 /* maximum number of device selectors */
+
+/* types of device selectors */
+enum select_types {
+	SELECT_TYPE_GLOB, /* glob pattern of device names */
+	SELECT_TYPE_REGEX, /* extended regular expression of device names */
+	SELECT_TYPE_BUS_ID, /* bus-id prefix of the parent device */
+	SELECT_TYPE_PARENT, /* parent device or its physical function */
+};
+
+/* device selector */
+struct selector {
+	int type;
+	int kind; /* net, ib for ib and ism, or unknown for all devices */
+	const char *pattern;
+	regex_t regex;
+};
+
+int select_is_pattern(const char *name);
+int select_init(struct selector *selector, int type, int kind,
+		const char *pattern);
+void select_free(struct selector *selector);
+int select_match(struct selector *selector, struct device *device);
+int select_devices(struct selector *selectors, int num_selectors,
+		   int ib_port, struct device ***devices);
+
+#endif
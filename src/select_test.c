@@ -0,0 +1,142 @@
+/*
+ * test for select
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "test.h"
+#include "devices.h"
+#include "select.h"
+#include "sysfs.h"
+
+/* add a physical function with two virtual functions and other devices */
+static void add_devices() {
+	test_add_device("net", "enP1p59s0f0", -1, "0000:3b:00.0", "");
+	test_add_device("net", "enP1p59s0f0v0", -1, "0000:3b:00.2", "");
+	test_add_device("net", "enP1p59s0f0v1", -1, "0000:3b:00.3", "");
+	test_add_device("infiniband", "mlx5_0", 1, "0000:3b:00.0", "");
+	test_add_device("infiniband", "mlx5_0", 2, "0000:3b:00.0", "");
+	test_add_device("infiniband", "mlx5_2", 1, "0000:3b:00.2", "");
+	test_add_device("net", "eth0", -1, "0000:5e:00.0", "");
+	test_add_device("net", "vlan0", -1, NULL, "");
+}
+
+/* select devices with selectors and compare their number with expected */
+static int check_selected(struct selector *selectors, int num_selectors,
+			  int ib_port, int expected) {
+	struct device **devices;
+	int count;
+
+	count = select_devices(selectors, num_selectors, ib_port, &devices);
+	free(devices);
+	if (count != expected) {
+		printf("Selected %d devices instead of %d.\n", count,
+		       expected);
+		return -1;
+	}
+	return 0;
+}
+
+// test the function select_devices() with name patterns
+int test_select_devices() {
+	struct selector selectors[2];
+	int rc = -1;
+
+	add_devices();
+
+	/* glob patterns only match devices of their kind */
+	select_init(&selectors[0], SELECT_TYPE_GLOB, DEVICE_KIND_NET, "enP*");
+	select_init(&selectors[1], SELECT_TYPE_GLOB, DEVICE_KIND_IB, "enP*");
+	if (!select_is_pattern("enP*") || select_is_pattern("eth0") ||
+	    check_selected(selectors, 1, -1, 3) ||
+	    check_selected(&selectors[1], 1, -1, 0))
+		goto out;
+
+	/* infiniband devices with all or only the given port */
+	select_init(&selectors[1], SELECT_TYPE_GLOB, DEVICE_KIND_IB, "mlx5_*");
+	if (check_selected(selectors, 2, -1, 6) ||
+	    check_selected(selectors, 2, 2, 4))
+		goto out;
+
+	/* regular expressions must match the whole name */
+	if (select_init(&selectors[0], SELECT_TYPE_REGEX, DEVICE_KIND_NET,
+			"enP1p59s0f0v[0-9]+|eth0"))
+		goto out;
+	if (check_selected(selectors, 1, -1, 3))
+		goto out;
+	select_free(&selectors[0]);
+	if (!select_init(&selectors[0], SELECT_TYPE_REGEX, DEVICE_KIND_NET,
+			 "("))
+		goto out;
+
+	/* bus-id prefixes match all kinds of devices */
+	select_init(&selectors[0], SELECT_TYPE_BUS_ID, DEVICE_KIND_UNKNOWN,
+		    "0000:3b:00");
+	if (check_selected(selectors, 1, -1, 6))
+		goto out;
+	rc = 0;
+out:
+	free_devices();
+	return rc;
+}
+
+// test the function select_devices() with a parent device
+int test_select_devices_parent() {
+	char root[] = "/tmp/pnetctl_test_select.XXXXXX";
+	char path[sizeof(root) + 64];
+	struct selector selector;
+	int rc = -1;
+
+	if (!mkdtemp(root))
+		return -1;
+	snprintf(path, sizeof(path), "%s/bus", root);
+	mkdir(path, 0755);
+	snprintf(path, sizeof(path), "%s/bus/pci", root);
+	mkdir(path, 0755);
+	snprintf(path, sizeof(path), "%s/bus/pci/devices", root);
+	mkdir(path, 0755);
+	snprintf(path, sizeof(path), "%s/bus/pci/devices/0000:3b:00.2", root);
+	mkdir(path, 0755);
+	snprintf(path, sizeof(path),
+		 "%s/bus/pci/devices/0000:3b:00.2/physfn", root);
+	if (symlink("../0000:3b:00.0", path))
+		goto out;
+	sysfs_root = root;
+
+	/* the physical function and devices on its virtual function */
+	add_devices();
+	select_init(&selector, SELECT_TYPE_PARENT, DEVICE_KIND_UNKNOWN,
+		    "0000:3b:00.0");
+	if (!check_selected(&selector, 1, -1, 5))
+		rc = 0;
+	free_devices();
+out:
+	sysfs_root = SYSFS_ROOT;
+	unlink(path);
+	snprintf(path, sizeof(path), "%s/bus/pci/devices/0000:3b:00.2", root);
+	rmdir(path);
+	snprintf(path, sizeof(path), "%s/bus/pci/devices", root);
+	rmdir(path);
+	snprintf(path, sizeof(path), "%s/bus/pci", root);
+	rmdir(path);
+	snprintf(path, sizeof(path), "%s/bus", root);
+	rmdir(path);
+	rmdir(root);
+	return rc;
+}
+
+struct test tests[] = {
+	{"select_devices", test_select_devices},
+	{"select_devices_parent", test_select_devices_parent},
+	{NULL, NULL},
+};
+
+int main(int argc, char** argv) {
+	return run_test(tests, argc, argv);
+}
@@ -0,0 +1,313 @@
+/*
+ * *********************
+ * *** SHMTABLE PART ***
+ * *********************
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "shmtable.h"
+#include "verbose.h"
+
+/* table of the writer */
+static char *writer_path;
+static struct shmtable_header *writer_header;
+static size_t writer_size;
+
+/* get device records of a mapped table */
+static struct device_record *shmtable_records(struct shmtable_header *header) {
+	return (struct device_record *) ((char *) header +
+					 header->header_size);
+}
+
+/* create a new table file with capacity records at path with suffix
+ * ".tmp", the table starts in an update (odd seq) until its records are
+ * written and it is moved to path with shmtable_install()
+ */
+static struct shmtable_header *shmtable_new_file(const char *path,
+						 uint32_t capacity,
+						 size_t *size) {
+	struct shmtable_header *header;
+	char tmp_path[strlen(path) + 5];
+	int fd;
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd == -1)
+		return NULL;
+
+	*size = sizeof(*header) + capacity * sizeof(struct device_record);
+	if (ftruncate(fd, *size)) {
+		close(fd);
+		unlink(tmp_path);
+		return NULL;
+	}
+	header = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (header == MAP_FAILED) {
+		unlink(tmp_path);
+		return NULL;
+	}
+
+	header->magic = SHMTABLE_MAGIC;
+	header->version = SHMTABLE_VERSION;
+	header->header_size = sizeof(*header);
+	header->record_size = sizeof(struct device_record);
+	header->capacity = capacity;
+	atomic_store_explicit(&header->seq, 1, memory_order_relaxed);
+	log_debug("Created table \"%s\" with %u records.\n", tmp_path,
+		  capacity);
+	return header;
+}
+
+/* move the new table file of path with suffix ".tmp" to path */
+static int shmtable_install(const char *path) {
+	char tmp_path[strlen(path) + 5];
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	if (rename(tmp_path, path)) {
+		unlink(tmp_path);
+		return -1;
+	}
+	return 0;
+}
+
+/* start writing an update of the table */
+static void shmtable_write_begin(struct shmtable_header *header) {
+	uint32_t seq = atomic_load_explicit(&header->seq, memory_order_relaxed);
+
+	atomic_store_explicit(&header->seq, seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+}
+
+/* finish writing an update of the table */
+static void shmtable_write_end(struct shmtable_header *header) {
+	uint32_t seq = atomic_load_explicit(&header->seq, memory_order_relaxed);
+
+	atomic_store_explicit(&header->seq, seq + 1, memory_order_release);
+}
+
+/* create table at path for publishing the devices list, readers wait
+ * until the first devices are published instead of reading an empty table
+ */
+int shmtable_create(const char *path) {
+	shmtable_destroy();
+	writer_header = shmtable_new_file(path, SHMTABLE_MIN_CAPACITY,
+					  &writer_size);
+	if (!writer_header)
+		return -1;
+	if (shmtable_install(path)) {
+		munmap(writer_header, writer_size);
+		writer_header = NULL;
+		return -1;
+	}
+	writer_path = strdup(path);
+	return 0;
+}
+
+/* write count devices of the devices list to the records of the table */
+static void shmtable_fill(struct shmtable_header *header, uint32_t count) {
+	struct device_record *records;
+	struct device *next;
+
+	records = shmtable_records(header);
+	next = get_next_device(&devices_list);
+	for (uint32_t i = 0; i < count; i++) {
+		device_to_record(next, &records[i]);
+		next = get_next_device(next);
+	}
+	header->count = count;
+	header->generation++;
+}
+
+/* publish the devices list in the table */
+int shmtable_publish() {
+	struct shmtable_header *header;
+	struct device *next;
+	uint32_t count = 0;
+	size_t size;
+
+	if (!writer_header)
+		return -1;
+
+	next = get_next_device(&devices_list);
+	while (next) {
+		count++;
+		next = get_next_device(next);
+	}
+
+	/* move to a bigger table file if the devices do not fit, the new
+	 * file is complete before readers can map it
+	 */
+	if (count > writer_header->capacity) {
+		header = shmtable_new_file(writer_path, count * 2, &size);
+		if (!header)
+			return -1;
+		header->generation = writer_header->generation;
+		shmtable_fill(header, count);
+		shmtable_write_end(header);
+		if (shmtable_install(writer_path)) {
+			munmap(header, size);
+			return -1;
+		}
+		shmtable_write_begin(writer_header);
+		writer_header->replaced = 1;
+		shmtable_write_end(writer_header);
+		munmap(writer_header, writer_size);
+		writer_header = header;
+		writer_size = size;
+		goto out;
+	}
+
+	/* a table without generation is still in its first update */
+	if (writer_header->generation)
+		shmtable_write_begin(writer_header);
+	shmtable_fill(writer_header, count);
+	shmtable_write_end(writer_header);
+out:
+	log_debug("Published %u devices in table \"%s\".\n", count,
+		  writer_path);
+	return 0;
+}
+
+/* stop publishing, tell readers and remove the table */
+void shmtable_destroy() {
+	if (!writer_header)
+		return;
+	unlink(writer_path);
+	if (writer_header->generation)
+		shmtable_write_begin(writer_header);
+	writer_header->replaced = 1;
+	shmtable_write_end(writer_header);
+	munmap(writer_header, writer_size);
+	free(writer_path);
+	writer_header = NULL;
+	writer_path = NULL;
+}
+
+/* map table header and records read-only */
+static struct shmtable_header *shmtable_map_file(const char *path,
+						 size_t *size) {
+	struct shmtable_header *header;
+	struct stat st;
+	int fd;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return NULL;
+	if (fstat(fd, &st) || st.st_size < sizeof(*header)) {
+		close(fd);
+		return NULL;
+	}
+	*size = st.st_size;
+	header = mmap(NULL, *size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (header == MAP_FAILED)
+		return NULL;
+
+	/* check the layout */
+	if (header->magic != SHMTABLE_MAGIC ||
+	    header->version != SHMTABLE_VERSION ||
+	    header->header_size != sizeof(*header) ||
+	    header->record_size != sizeof(struct device_record) ||
+	    *size < header->header_size +
+	    (size_t) header->capacity * header->record_size) {
+		log_error("Invalid table \"%s\".\n", path);
+		munmap(header, *size);
+		return NULL;
+	}
+	return header;
+}
+
+/* map the table at path for reading */
+struct shmtable *shmtable_map(const char *path) {
+	struct shmtable *table;
+
+	table = calloc(1, sizeof(*table));
+	if (!table)
+		return NULL;
+	table->header = shmtable_map_file(path, &table->size);
+	if (!table->header) {
+		free(table);
+		return NULL;
+	}
+	table->path = strdup(path);
+	return table;
+}
+
+/* map the table again after the writer replaced it */
+static int shmtable_remap(struct shmtable *table) {
+	struct shmtable_header *header;
+	size_t size;
+
+	header = shmtable_map_file(table->path, &size);
+	if (!header)
+		return -1;
+	munmap(table->header, table->size);
+	table->header = header;
+	table->size = size;
+	return 0;
+}
+
+/* take a consistent snapshot of the devices in the table, returns the
+ * number of device records or -1 on error
+ */
+int shmtable_snapshot(struct shmtable *table, struct device_record **records) {
+	struct device_record *buffer = NULL;
+	struct shmtable_header *header;
+	uint32_t buffer_len = 0;
+	uint32_t count;
+	uint32_t seq;
+
+	*records = NULL;
+	for (int i = 0; i < SHMTABLE_MAX_RETRIES; i++) {
+		header = table->header;
+		seq = atomic_load_explicit(&header->seq, memory_order_acquire);
+		if (seq & 1) {
+			/* let a preempted writer finish its update */
+			sched_yield();
+			continue;
+		}
+		if (header->replaced) {
+			if (shmtable_remap(table))
+				break;
+			continue;
+		}
+		count = header->count;
+		if (count > header->capacity)
+			continue;
+		if (count > buffer_len) {
+			free(buffer);
+			buffer = malloc(count * sizeof(*buffer));
+			if (!buffer)
+				return -1;
+			buffer_len = count;
+		}
+		memcpy(buffer, shmtable_records(header),
+		       count * sizeof(*buffer));
+		atomic_thread_fence(memory_order_acquire);
+		if (atomic_load_explicit(&header->seq,
+					 memory_order_relaxed) == seq) {
+			*records = buffer;
+			return count;
+		}
+	}
+	free(buffer);
+	return -1;
+}
+
+/* unmap the table */
+void shmtable_unmap(struct shmtable *table) {
+	if (!table)
+		return;
+	munmap(table->header, table->size);
+	free(table->path);
+	free(table);
+}
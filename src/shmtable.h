@@ -0,0 +1,48 @@
+#ifndef _PNETCTL_SHMTABLE_H
+#define _PNETCTL_SHMTABLE_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "devices.h"
+
+#define SHMTABLE_PATH "/run/pnetctl.table" /* default table path */
+#define SHMTABLE_MAGIC 0x54454e50 /* "PNET" */
+#define SHMTABLE_VERSION 1 /* layout version */
+#define SHMTABLE_MIN_CAPACITY 1024 /* minimum number of records */
+#define SHMTABLE_MAX_RETRIES 1000000 /* reader retries before giving up */
+
+/* header at the start of the mapped table file, followed by capacity device
+ * records. seq is odd while the writer updates the table. replaced is set
+ * when the writer moved to a new file, readers have to map the path again.
+ */
+struct shmtable_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t header_size;
+	uint32_t record_size;
+	uint32_t capacity;
+	uint32_t count;
+	_Atomic uint32_t seq;
+	uint32_t replaced;
+	uint64_t generation;
+};
+
+/* reader of a mapped table */
+struct shmtable {
+	char *path;
+	struct shmtable_header *header;
+	size_t size;
+};
+
+/* writer */
+int shmtable_create(const char *path);
+int shmtable_publish();
+void shmtable_destroy();
+
+/* reader */
+struct shmtable *shmtable_map(const char *path);
+int shmtable_snapshot(struct shmtable *table, struct device_record **records);
+void shmtable_unmap(struct shmtable *table);
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * test for shmtable
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#include "test.h"
+#include "shmtable.h"
+#include "devices.h"
+
+#define TEST_TABLE "/tmp/pnetctl_test.table"
+
+// fill devices list with count devices and pnetid
+static void fill_devices(int count, const char *pnetid) {
+	struct device *device;
+
+	for (int i = 0; i < count; i++) {
+		device = new_device();
+		device->name = "eth";
+		device->subsystem = "net";
+		classify_device(device);
+		strcpy(device->pnetid, pnetid);
+	}
+}
+
+// set pnetid of all devices in devices list
+static void set_pnetids(const char *pnetid) {
+	struct device *next = get_next_device(&devices_list);
+
+	while (next) {
+		strcpy(next->pnetid, pnetid);
+		next = get_next_device(next);
+	}
+}
+
+// test the functions shmtable_create(), shmtable_publish(), and
+// shmtable_destroy()
+int test_shmtable_publish() {
+	struct device_record *records;
+	struct shmtable *new_table;
+	struct shmtable *table;
+	int count;
+
+	if (shmtable_publish() != -1) {
+		return -1;
+	}
+	if (shmtable_create(TEST_TABLE)) {
+		return -1;
+	}
+	table = shmtable_map(TEST_TABLE);
+	if (!table) {
+		return -1;
+	}
+
+	// table is not readable before the first devices are published
+	if (shmtable_snapshot(table, &records) != -1 || records) {
+		return -1;
+	}
+
+	// published devices
+	fill_devices(10, "PNETCTL");
+	shmtable_publish();
+	count = shmtable_snapshot(table, &records);
+	if (count != 10 || strcmp(records[9].pnetid, "PNETCTL")) {
+		return -1;
+	}
+	free(records);
+
+	// table is replaced if devices do not fit, a new reader of the new
+	// file sees all devices
+	fill_devices(SHMTABLE_MIN_CAPACITY, "PNETCTL");
+	shmtable_publish();
+	count = shmtable_snapshot(table, &records);
+	free(records);
+	if (count != SHMTABLE_MIN_CAPACITY + 10) {
+		return -1;
+	}
+	new_table = shmtable_map(TEST_TABLE);
+	count = new_table ? shmtable_snapshot(new_table, &records) : -1;
+	free(records);
+	shmtable_unmap(new_table);
+	if (count != SHMTABLE_MIN_CAPACITY + 10) {
+		return -1;
+	}
+	free_devices();
+
+	// readers fail after the table is destroyed
+	shmtable_destroy();
+	if (shmtable_snapshot(table, &records) != -1) {
+		return -1;
+	}
+	shmtable_unmap(table);
+	if (!access(TEST_TABLE, F_OK)) {
+		return -1;
+	}
+	return 0;
+}
+
+// test the function shmtable_snapshot() with a concurrent writer
+int test_shmtable_snapshot() {
+	struct device_record *records;
+	struct shmtable *table;
+	int count;
+	pid_t pid;
+
+	fill_devices(100, "AAAA");
+	if (shmtable_create(TEST_TABLE) || shmtable_publish()) {
+		return -1;
+	}
+
+	// writer alternates pnetids of all devices
+	pid = fork();
+	if (pid == 0) {
+		for (int i = 0; ; i++) {
+			set_pnetids(i % 2 ? "AAAA" : "BBBB");
+			shmtable_publish();
+			usleep(10);
+		}
+	}
+
+	// every snapshot must contain the same pnetid for all devices
+	table = shmtable_map(TEST_TABLE);
+	for (int i = 0; table && i < 10000; i++) {
+		count = shmtable_snapshot(table, &records);
+		if (count != 100) {
+			break;
+		}
+		for (int j = 1; j < count; j++) {
+			if (strcmp(records[0].pnetid, records[j].pnetid)) {
+				count = -1;
+				break;
+			}
+		}
+		free(records);
+		if (count != 100) {
+			break;
+		}
+	}
+	kill(pid, SIGKILL);
+	waitpid(pid, NULL, 0);
+	shmtable_unmap(table);
+	shmtable_destroy();
+	free_devices();
+	if (!table || count != 100) {
+		return -1;
+	}
+	return 0;
+}
+
+struct test tests[] = {
+	{"shmtable_publish", test_shmtable_publish},
+	{"shmtable_snapshot", test_shmtable_snapshot},
+	{NULL, NULL},
+};
+
+int main(int argc, char** argv) {
+	return run_test(tests, argc, argv);
+}
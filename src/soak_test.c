@@ -0,0 +1,148 @@
+/*
+ * soak test for repeated device scans
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <unistd.h>
+
+#include "test.h"
+#include "bench.h"
+#include "devices.h"
+#include "fixture.h"
+#include "lazy.h"
+#include "netlink.h"
+#include "print.h"
+#include "sysfs.h"
+#include "udev.h"
+
+#define SOAK_ITERATIONS 2000 /* scan, dump, print, and free iterations */
+#define SOAK_WARMUP 50 /* iterations before the baseline is taken */
+#define SOAK_MAX_RSS_GROWTH_KB 1024 /* allowed rss growth for fragmentation */
+
+/* smc generic netlink family, negative if smc is not available */
+extern int nl_family;
+
+/* run iterations of scan, netlink dump, print, and free and check that the
+ * live allocations and the rss do not grow after the warm-up
+ */
+static int soak(int (*scan)()) {
+	int null_fd = open("/dev/null", O_WRONLY);
+	int stdout_fd = dup(STDOUT_FILENO);
+	int64_t live_start = 0;
+	long rss_start = 0;
+	int64_t live;
+	int rc = 0;
+	long rss;
+
+	fflush(stdout);
+	dup2(null_fd, STDOUT_FILENO);
+	for (int i = 0; i < SOAK_WARMUP + SOAK_ITERATIONS && !rc; i++) {
+		if (i == SOAK_WARMUP) {
+			live_start = bench_live_allocations();
+			rss_start = bench_rss_kb();
+		}
+		rc = scan();
+		nl_init();
+		if (nl_family >= 0)
+			nl_get_pnetids();
+		nl_cleanup();
+		print_device_table();
+		free_devices();
+	}
+	fflush(stdout);
+	dup2(stdout_fd, STDOUT_FILENO);
+	close(stdout_fd);
+	close(null_fd);
+	if (rc) {
+		printf("Scan failed.\n");
+		return rc;
+	}
+
+	live = bench_live_allocations();
+	rss = bench_rss_kb();
+	printf("%d iterations, live allocations %lld -> %lld, rss %ld kB -> "
+	       "%ld kB.\n", SOAK_ITERATIONS, (long long) live_start,
+	       (long long) live, rss_start, rss);
+	if (live > live_start) {
+		printf("Leaked %lld allocations.\n",
+		       (long long) (live - live_start));
+		return -1;
+	}
+	if (rss - rss_start > SOAK_MAX_RSS_GROWTH_KB) {
+		printf("RSS grew by %ld kB.\n", rss - rss_start);
+		return -1;
+	}
+	return 0;
+}
+
+// test the function bench_live_allocations() with all allocators
+int test_soak_allocations() {
+	void *volatile ptrs[6] = {};
+	int64_t live_start;
+	void *ptr = NULL;
+
+	live_start = bench_live_allocations();
+	ptrs[0] = malloc(16);
+	ptrs[1] = calloc(1, 16);
+	ptrs[2] = aligned_alloc(64, 64);
+	if (!posix_memalign(&ptr, 64, 16))
+		ptrs[3] = ptr;
+	ptrs[4] = memalign(64, 16);
+	ptrs[5] = valloc(16);
+	for (int i = 0; i < 6; i++) {
+		if (!ptrs[i])
+			return -1;
+	}
+	if (bench_live_allocations() != live_start + 6)
+		return -1;
+	for (int i = 0; i < 6; i++)
+		free(ptrs[i]);
+	if (bench_live_allocations() != live_start)
+		return -1;
+	return 0;
+}
+
+// test repeated scans of a synthetic sysfs tree with sysfs_scan_devices()
+int test_soak_sysfs() {
+	struct fixture_config config;
+	char root[] = "/tmp/pnetctl_test_soak.XXXXXX";
+	int rc = -1;
+
+	fixture_config_for_size(&config, 100);
+	if (!mkdtemp(root))
+		return -1;
+	if (fixture_create(root, &config))
+		goto out;
+	sysfs_root = root;
+	rc = soak(sysfs_scan_devices);
+out:
+	sysfs_root = SYSFS_ROOT;
+	fixture_remove(root);
+	return rc;
+}
+
+// test repeated scans of the devices of this system with udev_scan_devices()
+int test_soak_udev() {
+	if (lazy_load_udev()) {
+		printf("Cannot load libudev, skipping.\n");
+		return 0;
+	}
+	return soak(udev_scan_devices);
+}
+
+struct test tests[] = {
+	{"soak_allocations", test_soak_allocations},
+	{"soak_sysfs", test_soak_sysfs},
+	{"soak_udev", test_soak_udev},
+	{NULL, NULL},
+};
+
+int main(int argc, char** argv) {
+	return run_test(tests, argc, argv);
+}
@@ -0,0 +1,114 @@
+/*
+ * benchmark for the startup of pnetctl commands
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "stats.h"
+
+#define BENCH_RUNS 100 /* default number of timed runs */
+#define BENCH_STARTUP "total startup time in dynamic loader:"
+#define BENCH_RELOCATIONS "final number of relocations:"
+
+/* measurement of a single run */
+struct bench_result {
+	uint64_t wall_ns;
+	uint64_t startup_cycles;
+	uint64_t relocations;
+};
+
+/* get the number after key in the dynamic loader statistics */
+static uint64_t bench_parse(const char *stats, const char *key) {
+	const char *value = strstr(stats, key);
+
+	return value ? strtoull(value + strlen(key), NULL, 10) : 0;
+}
+
+/* run pnetctl with argv once and get the dynamic loader statistics, the
+ * startup time is the time in the dynamic loader until main() is called
+ */
+static int bench_run(char **argv, struct bench_result *result) {
+	char stats[16384];
+	uint64_t start_ns;
+	size_t len = 0;
+	ssize_t count;
+	int pipe_fd[2];
+	int status;
+	pid_t pid;
+
+	if (pipe(pipe_fd))
+		return -1;
+	start_ns = stats_now();
+	pid = fork();
+	if (pid == -1)
+		return -1;
+	if (pid == 0) {
+		int null_fd = open("/dev/null", O_WRONLY);
+
+		dup2(null_fd, STDOUT_FILENO);
+		dup2(pipe_fd[1], STDERR_FILENO);
+		close(pipe_fd[0]);
+		setenv("LD_DEBUG", "statistics", 1);
+		execv(argv[0], argv);
+		_exit(127);
+	}
+	close(pipe_fd[1]);
+	while ((count = read(pipe_fd[0], stats + len,
+			     sizeof(stats) - len - 1)) > 0)
+		len += count;
+	close(pipe_fd[0]);
+	stats[len] = 0;
+	if (waitpid(pid, &status, 0) == -1)
+		return -1;
+	result->wall_ns = stats_now() - start_ns;
+	result->startup_cycles = bench_parse(stats, BENCH_STARTUP);
+	result->relocations = bench_parse(stats, BENCH_RELOCATIONS);
+	if (!WIFEXITED(status) || WEXITSTATUS(status) == 127)
+		return -1;
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	uint64_t min_cycles = UINT64_MAX;
+	uint64_t min_ns = UINT64_MAX;
+	uint64_t total_cycles = 0;
+	struct bench_result result;
+	uint64_t total_ns = 0;
+	char command[256] = "";
+	int runs;
+
+	if (argc < 4) {
+		printf("Usage: %s <runs> <pnetctl> <args...>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	runs = atoi(argv[1]) > 0 ? atoi(argv[1]) : BENCH_RUNS;
+	for (int i = 3; i < argc; i++)
+		snprintf(command + strlen(command),
+			 sizeof(command) - strlen(command), "%s%s",
+			 i > 3 ? " " : "", argv[i]);
+
+	for (int i = 0; i < runs; i++) {
+		if (bench_run(&argv[2], &result)) {
+			printf("Cannot run \"%s %s\".\n", argv[2], command);
+			return EXIT_FAILURE;
+		}
+		total_cycles += result.startup_cycles;
+		total_ns += result.wall_ns;
+		if (result.startup_cycles < min_cycles)
+			min_cycles = result.startup_cycles;
+		if (result.wall_ns < min_ns)
+			min_ns = result.wall_ns;
+	}
+	printf("startup \"%s\": %d runs, loader min %llu avg %llu cycles, "
+	       "%llu relocations, run min %.3f avg %.3f ms\n", command, runs,
+	       (unsigned long long) min_cycles,
+	       (unsigned long long) (total_cycles / runs),
+	       (unsigned long long) result.relocations, min_ns / 1e6,
+	       total_ns / 1e6 / runs);
+	return EXIT_SUCCESS;
+}
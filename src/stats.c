@@ -0,0 +1,107 @@
+/*
+ * ******************
+ * *** STATS PART ***
+ * ******************
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <inttypes.h>
+
+#include "stats.h"
+
+/* accumulated phase times and counters */
+struct stats stats = {};
+
+/* names of phases in output */
+static const char *phase_names[STATS_PHASE_MAX] = {
+	[STATS_PHASE_SCAN] = "scan",
+	[STATS_PHASE_UTIL_STRING] = "util_string",
+	[STATS_PHASE_LOWER] = "lower",
+	[STATS_PHASE_NETLINK] = "netlink",
+	[STATS_PHASE_PRINT] = "print",
+};
+
+/* names of counters in output */
+static const char *counter_names[STATS_COUNTER_MAX] = {
+	[STATS_DEVICES_SEEN] = "devices_seen",
+	[STATS_DEVICES_ADDED] = "devices_added",
+	[STATS_SYSFS_READS] = "sysfs_reads",
+	[STATS_UDEV_OBJECTS] = "udev_objects",
+	[STATS_NL_MSGS_SENT] = "nl_msgs_sent",
+	[STATS_NL_MSGS_RECEIVED] = "nl_msgs_received",
+	[STATS_NL_BYTES_SENT] = "nl_bytes_sent",
+	[STATS_NL_BYTES_RECEIVED] = "nl_bytes_received",
+};
+
+/* get monotonic timestamp in nanoseconds */
+uint64_t stats_now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* reset all statistics and start timing the run */
+void stats_reset() {
+	memset(&stats, 0, sizeof(stats));
+	stats.start_ns = stats_now();
+}
+
+/* start timing a phase */
+void stats_start(enum stats_phases phase) {
+	if (!stats_mode)
+		return;
+	stats.phase_start_ns[phase] = stats_now();
+}
+
+/* stop timing a phase and add its time */
+void stats_stop(enum stats_phases phase) {
+	if (!stats_mode || !stats.phase_start_ns[phase])
+		return;
+	stats.phase_ns[phase] += stats_now() - stats.phase_start_ns[phase];
+	stats.phase_start_ns[phase] = 0;
+	stats.phase_calls[phase]++;
+}
+
+/* print statistics as text */
+static void stats_print_text(uint64_t total_ns) {
+	fprintf(stderr, "%-20s %10s %14s\n", "Phase:", "Calls:", "Time (us):");
+	for (int i = 0; i < STATS_PHASE_MAX; i++)
+		fprintf(stderr, "%-20s %10" PRIu64 " %14.3f\n", phase_names[i],
+			stats.phase_calls[i], stats.phase_ns[i] / 1000.0);
+	fprintf(stderr, "%-20s %10s %14.3f\n", "total", "", total_ns / 1000.0);
+	fprintf(stderr, "%-20s %25s\n", "Counter:", "Value:");
+	for (int i = 0; i < STATS_COUNTER_MAX; i++)
+		fprintf(stderr, "%-20s %25" PRIu64 "\n", counter_names[i],
+			stats.counters[i]);
+}
+
+/* print statistics as json */
+static void stats_print_json(uint64_t total_ns) {
+	fprintf(stderr, "{\"total_ns\":%" PRIu64 ",\"phases\":{", total_ns);
+	for (int i = 0; i < STATS_PHASE_MAX; i++)
+		fprintf(stderr, "%s\"%s\":{\"calls\":%" PRIu64
+			",\"ns\":%" PRIu64 "}", i ? "," : "", phase_names[i],
+			stats.phase_calls[i], stats.phase_ns[i]);
+	fprintf(stderr, "},\"counters\":{");
+	for (int i = 0; i < STATS_COUNTER_MAX; i++)
+		fprintf(stderr, "%s\"%s\":%" PRIu64, i ? "," : "",
+			counter_names[i], stats.counters[i]);
+	fprintf(stderr, "}}\n");
+}
+
+/* print statistics summary to stderr if stats mode is enabled */
+void stats_print() {
+	uint64_t total_ns;
+
+	if (!stats_mode)
+		return;
+
+	total_ns = stats_now() - stats.start_ns;
+	if (stats_mode == STATS_MODE_JSON)
+		stats_print_json(total_ns);
+	else
+		stats_print_text(total_ns);
+}
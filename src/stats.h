@@ -0,0 +1,62 @@
+#ifndef _PNETCTL_STATS_H
+#define _PNETCTL_STATS_H
+
+#include <stdint.h>
+
+/* statistics output modes */
+enum stats_modes {
+	STATS_MODE_OFF,
+	STATS_MODE_TEXT,
+	STATS_MODE_JSON,
+};
+
+/* timed phases of a run, the device scan includes util string and lower
+ * device resolution
+ */
+enum stats_phases {
+	STATS_PHASE_SCAN,
+	STATS_PHASE_UTIL_STRING,
+	STATS_PHASE_LOWER,
+	STATS_PHASE_NETLINK,
+	STATS_PHASE_PRINT,
+	STATS_PHASE_MAX,
+};
+
+/* event counters */
+enum stats_counters {
+	STATS_DEVICES_SEEN,
+	STATS_DEVICES_ADDED,
+	STATS_SYSFS_READS,
+	STATS_UDEV_OBJECTS,
+	STATS_NL_MSGS_SENT,
+	STATS_NL_MSGS_RECEIVED,
+	STATS_NL_BYTES_SENT,
+	STATS_NL_BYTES_RECEIVED,
+	STATS_COUNTER_MAX,
+};
+
+/* statistics mode, disabled by default */
+extern int stats_mode;
+
+/* accumulated phase times and counters */
+struct stats {
+	uint64_t start_ns;
+	uint64_t phase_start_ns[STATS_PHASE_MAX];
+	uint64_t phase_ns[STATS_PHASE_MAX];
+	uint64_t phase_calls[STATS_PHASE_MAX];
+	uint64_t counters[STATS_COUNTER_MAX];
+};
+
+extern struct stats stats;
+
+uint64_t stats_now();
+void stats_reset();
+void stats_start(enum stats_phases phase);
+void stats_stop(enum stats_phases phase);
+void stats_print();
+
+/* counters are cheap enough to be updated unconditionally */
+#define stats_add(counter, n) (stats.counters[(counter)] += (n))
+#define stats_inc(counter) stats_add(counter, 1)
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * test for stats
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include "test.h"
+#include "stats.h"
+
+// test the counter macros
+int test_stats_counters() {
+	stats_mode = STATS_MODE_OFF;
+	stats_reset();
+	stats_inc(STATS_DEVICES_SEEN);
+	stats_inc(STATS_DEVICES_SEEN);
+	stats_add(STATS_NL_BYTES_SENT, 20);
+	if (stats.counters[STATS_DEVICES_SEEN] != 2 ||
+	    stats.counters[STATS_NL_BYTES_SENT] != 20) {
+		return -1;
+	}
+
+	stats_reset();
+	if (stats.counters[STATS_DEVICES_SEEN]) {
+		return -1;
+	}
+	return 0;
+}
+
+// test the functions stats_start() and stats_stop()
+int test_stats_phases() {
+	// phases are not timed if stats mode is off
+	stats_mode = STATS_MODE_OFF;
+	stats_reset();
+	stats_start(STATS_PHASE_PRINT);
+	stats_stop(STATS_PHASE_PRINT);
+	if (stats.phase_calls[STATS_PHASE_PRINT]) {
+		return -1;
+	}
+
+	stats_mode = STATS_MODE_TEXT;
+	stats_reset();
+	stats_start(STATS_PHASE_PRINT);
+	stats_stop(STATS_PHASE_PRINT);
+	stats_start(STATS_PHASE_PRINT);
+	stats_stop(STATS_PHASE_PRINT);
+	if (stats.phase_calls[STATS_PHASE_PRINT] != 2) {
+		return -1;
+	}
+
+	// stop without start is ignored
+	stats_stop(STATS_PHASE_NETLINK);
+	if (stats.phase_calls[STATS_PHASE_NETLINK]) {
+		return -1;
+	}
+
+	stats_mode = STATS_MODE_OFF;
+	return 0;
+}
+
+// test the function stats_print()
+int test_stats_print() {
+	stats_mode = STATS_MODE_OFF;
+	stats_reset();
+	stats_print();
+
+	stats_mode = STATS_MODE_TEXT;
+	stats_reset();
+	stats_inc(STATS_DEVICES_SEEN);
+	stats_print();
+
+	stats_mode = STATS_MODE_JSON;
+	stats_reset();
+	stats_inc(STATS_DEVICES_SEEN);
+	stats_print();
+
+	stats_mode = STATS_MODE_OFF;
+	return 0;
+}
+
+struct test tests[] = {
+	{"stats_counters", test_stats_counters},
+	{"stats_phases", test_stats_phases},
+	{"stats_print", test_stats_print},
+	{NULL, NULL},
+};
+
+int main(int argc, char** argv) {
+	return run_test(tests, argc, argv);
+}
@@ -0,0 +1,434 @@
+/*
+ * ******************
+ * *** SYSFS PART ***
+ * ******************
+ */
+
+#include <unistd.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <dirent.h>
+#include <iconv.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "devices.h"
+#include "filter.h"
+#include "probe.h"
+#include "sysfs.h"
+#include "verbose.h"
+#include "stats.h"
+#include "trace.h"
+
+#define MAX_LOWER_DEPTH 16 /* maximum depth of stacked net devices */
+
+/* CCW device constants */
+#define CCW_CHPID_LEN 128 /* maximum chpid length */
+#define CCW_UTIL_PREFIX "/devices/css0/chp0." /* util string path prefix */
+
+/* sysfs return codes */
+enum sysfs_rc {
+	SYSFS_OK,
+	SYSFS_SCAN_FAILED,
+	SYSFS_HANDLE_FAILED,
+};
+
+/* root directory of sysfs */
+const char *sysfs_root = SYSFS_ROOT;
+
+/* read pnetid from util_string file relative to directory dir_fd into
+ * buffer
+ */
+int read_util_string_at(int dir_fd, const char *file, char *buffer) {
+	char read_buffer[SMC_MAX_PNETID_LEN];
+	char *read_ptr = read_buffer;
+	size_t read_count;
+	size_t conv_count;
+	iconv_t cd;
+	int fd;
+	int rc;
+
+	/* open and read file to temporary buffer*/
+	log_trace("Reading util string from file \"%s\".\n", file);
+	fd = openat(dir_fd, file, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return -1;
+	stats_inc(STATS_SYSFS_READS);
+	read_count = read(fd, read_buffer, SMC_MAX_PNETID_LEN);
+	close(fd);
+	if (read_count == -1)
+		return -1;
+
+	/* initialize ebcdic to ascii converter */
+	cd = iconv_open("ASCII", "CP500");
+	if (cd == (iconv_t) -1)
+		return -1;
+
+	/* convert pnetid from ebcdic to ascii; write to output buffer */
+	conv_count = SMC_MAX_PNETID_LEN;
+	rc = iconv(cd, &read_ptr, &read_count, &buffer, &conv_count);
+	iconv_close(cd);
+	if (rc == -1)
+		return -1;
+
+	log_debug("Read util string \"%s\" from file \"%s\".\n", buffer, file);
+	return 0;
+}
+
+/* read pnetid from util_string into buffer */
+int read_util_string(const char *file, char *buffer) {
+	return read_util_string_at(AT_FDCWD, file, buffer);
+}
+
+/* read pnetid from util_string of the chpid of a ccwgroup device */
+int read_ccw_util_string(const char *parent_path, char *buffer) {
+	int util_path_len = strlen(sysfs_root) + strlen(CCW_UTIL_PREFIX) +
+		CCW_CHPID_LEN + strlen("/util_string") + 1;
+	int chpid_path_len = strlen(parent_path) + strlen("/chpid") + 1;
+	char util_string_path[util_path_len];
+	char chpid[CCW_CHPID_LEN + 1] = {0};
+	char chpid_path[chpid_path_len];
+	int count;
+	int fd;
+
+	/* try to read chpid */
+	snprintf(chpid_path, sizeof(chpid_path), "%s/chpid", parent_path);
+	log_trace("Reading chpid from file \"%s\".\n", chpid_path);
+	fd = open(chpid_path, O_RDONLY);
+	if (fd == -1)
+		return -1;
+	stats_inc(STATS_SYSFS_READS);
+	count = read(fd, chpid, CCW_CHPID_LEN);
+	close(fd);
+	if (count <= 0)
+		return count;
+	chpid[strcspn(chpid, "\r\n")] = 0;
+	log_debug("Read chpid \"%s\" from file \"%s\".\n", chpid, chpid_path);
+
+	/* try to read util string */
+	snprintf(util_string_path, sizeof(util_string_path),
+		 "%s%s%s/util_string", sysfs_root, CCW_UTIL_PREFIX, chpid);
+	return read_util_string(util_string_path, buffer);
+}
+
+/* read the target of a symlink and return its last path component */
+static int sysfs_link_name(const char *path, char *buffer, size_t len) {
+	char target[PATH_MAX];
+	const char *name;
+	ssize_t count;
+
+	count = readlink(path, target, sizeof(target) - 1);
+	if (count == -1)
+		return -1;
+	target[count] = 0;
+	name = strrchr(target, '/');
+	name = name ? name + 1 : target;
+	if (strlen(name) >= len)
+		return -1;
+	strcpy(buffer, name);
+	return 0;
+}
+
+/* find the first "lower" device of a net device */
+static int sysfs_find_lower(const char *name, char *lower, size_t len) {
+	char path[PATH_MAX];
+	int dir_fd;
+
+	snprintf(path, sizeof(path), "%s/class/net/%s", sysfs_root, name);
+	dir_fd = probe_dir(path);
+	if (dir_fd == -1)
+		return -1;
+	return probe_find_prefix(dir_fd, "lower_", lower, len);
+}
+
+/* find lowest "lower" device of a net device */
+static void sysfs_find_lowest(const char *name, char *lowest, size_t len) {
+	char lower[NAME_MAX + 1];
+
+	stats_start(STATS_PHASE_LOWER);
+	trace_begin(lower, name, 0);
+	snprintf(lowest, len, "%s", name);
+	for (int i = 0; i < MAX_LOWER_DEPTH; i++) {
+		if (sysfs_find_lower(lowest, lower, sizeof(lower)))
+			break;
+		snprintf(lowest, len, "%s", lower);
+	}
+	trace_end(lower, lowest, 0);
+	stats_stop(STATS_PHASE_LOWER);
+}
+
+/* add a device to the devices list, its strings are copied */
+static struct device *sysfs_new_device(const char *subsystem,
+				       const char *name, const char *parent,
+				       const char *parent_subsystem,
+				       const char *lowest, int ib_port) {
+	const char *strings[] = {name, parent, parent_subsystem, lowest};
+	const char **fields[4];
+	struct device *device;
+	size_t len = 0;
+	char *names;
+	char *next;
+
+	for (int i = 0; i < 4; i++)
+		if (strings[i])
+			len += strlen(strings[i]) + 1;
+
+	names = malloc(len);
+	if (!names)
+		return NULL;
+	device = new_device();
+	if (!device) {
+		free(names);
+		return NULL;
+	}
+	device->names = names;
+
+	fields[0] = &device->name;
+	fields[1] = &device->parent;
+	fields[2] = &device->parent_subsystem;
+	fields[3] = &device->lowest;
+	next = device->names;
+	for (int i = 0; i < 4; i++) {
+		if (!strings[i])
+			continue;
+		strcpy(next, strings[i]);
+		*fields[i] = next;
+		next += strlen(strings[i]) + 1;
+	}
+	device->subsystem = subsystem;
+	device->ib_port = ib_port;
+	classify_device(device);
+	stats_inc(STATS_DEVICES_ADDED);
+	log_debug("Added device \"%s\" to device table.\n", device->name);
+
+	return device;
+}
+
+/* try to find a util_string for the device in its parent directory */
+static void sysfs_find_util_string(struct device *device,
+				   const char *parent_path) {
+	char path[PATH_MAX];
+
+	if (device->bus == DEVICE_BUS_NONE)
+		return;
+
+	stats_start(STATS_PHASE_UTIL_STRING);
+	trace_begin(util_string, device->name, 0);
+
+	switch (device->bus) {
+	case DEVICE_BUS_PCI:
+		snprintf(path, sizeof(path), "%s/util_string", parent_path);
+		read_util_string(path, device->pnetid);
+		break;
+	case DEVICE_BUS_CCWGROUP:
+		read_ccw_util_string(parent_path, device->pnetid);
+		break;
+	}
+
+	memcpy(device->util_pnetid, device->pnetid, sizeof(device->pnetid));
+	trace_end(util_string, device->name, !!device->pnetid[0]);
+	stats_stop(STATS_PHASE_UTIL_STRING);
+}
+
+/* get parent name, subsystem and path of a device in a class directory */
+static int sysfs_find_parent(const char *class, const char *name,
+			     char *parent, char *parent_subsystem,
+			     char *parent_path) {
+	char path[PATH_MAX];
+
+	snprintf(parent_path, PATH_MAX, "%s/class/%s/%s/device", sysfs_root,
+		 class, name);
+	if (sysfs_link_name(parent_path, parent, NAME_MAX + 1))
+		return -1;
+	snprintf(path, sizeof(path), "%s/subsystem", parent_path);
+	if (sysfs_link_name(path, parent_subsystem, NAME_MAX + 1))
+		parent_subsystem[0] = 0;
+	return 0;
+}
+
+/* handle a net device */
+static int sysfs_handle_net(const char *name) {
+	char parent_subsystem[NAME_MAX + 1];
+	char parent_path[PATH_MAX];
+	char parent[NAME_MAX + 1];
+	char lowest[NAME_MAX + 1];
+	struct device *device;
+	int has_parent;
+
+	has_parent = !sysfs_find_parent("net", name, parent, parent_subsystem,
+					 parent_path);
+	if (!filter_may_discover(DEVICE_KIND_NET, name,
+				 has_parent ? parent : NULL,
+				 has_parent && parent_subsystem[0] ?
+				 parent_subsystem : NULL))
+		return SYSFS_OK;
+	sysfs_find_lowest(name, lowest, sizeof(lowest));
+	device = sysfs_new_device("net", name, has_parent ? parent : NULL,
+				  has_parent && parent_subsystem[0] ?
+				  parent_subsystem : NULL, lowest, -1);
+	if (!device)
+		return SYSFS_HANDLE_FAILED;
+	if (has_parent)
+		sysfs_find_util_string(device, parent_path);
+	return SYSFS_OK;
+}
+
+/* sort infiniband ports by their number */
+static int sysfs_port_compare(const struct dirent **a,
+			      const struct dirent **b) {
+	return atoi((*a)->d_name) - atoi((*b)->d_name);
+}
+
+/* add a device for ib_port or each port of an infiniband device if ib_port
+ * is -1
+ */
+static int sysfs_add_ib_ports(const char *name, int ib_port) {
+	char parent_subsystem[NAME_MAX + 1];
+	char parent_path[PATH_MAX];
+	char parent[NAME_MAX + 1];
+	struct dirent **ports;
+	struct device *device;
+	char path[PATH_MAX];
+	int has_parent;
+	int rc = 0;
+	int n;
+
+	has_parent = !sysfs_find_parent("infiniband", name, parent,
+					 parent_subsystem, parent_path);
+	if (!filter_may_discover(DEVICE_KIND_IB, name,
+				 has_parent ? parent : NULL,
+				 has_parent && parent_subsystem[0] ?
+				 parent_subsystem : NULL))
+		return SYSFS_OK;
+	snprintf(path, sizeof(path), "%s/class/infiniband/%s/ports",
+		 sysfs_root, name);
+	n = scandir(path, &ports, NULL, sysfs_port_compare);
+	if (n == -1)
+		return SYSFS_OK;
+	stats_inc(STATS_SYSFS_READS);
+	for (int i = 0; i < n; i++) {
+		if (ports[i]->d_name[0] != '.' && !rc &&
+		    (ib_port == -1 || atoi(ports[i]->d_name) == ib_port)) {
+			device = sysfs_new_device("infiniband", name,
+						  has_parent ? parent : NULL,
+						  has_parent &&
+						  parent_subsystem[0] ?
+						  parent_subsystem : NULL,
+						  NULL,
+						  atoi(ports[i]->d_name));
+			if (!device)
+				rc = SYSFS_HANDLE_FAILED;
+			else if (has_parent)
+				sysfs_find_util_string(device, parent_path);
+		}
+		free(ports[i]);
+	}
+	free(ports);
+	return rc;
+}
+
+/* handle an infiniband device, adds a device for each port */
+static int sysfs_handle_ib(const char *name) {
+	return sysfs_add_ib_ports(name, -1);
+}
+
+/* handle a pci device, only ism devices are added */
+static int sysfs_handle_pci(const char *name) {
+	char driver[NAME_MAX + 1];
+	struct device *device;
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/bus/pci/devices/%s/driver",
+		 sysfs_root, name);
+	if (sysfs_link_name(path, driver, sizeof(driver)) ||
+	    strncmp(driver, "ism", 3) ||
+	    !filter_may_discover(DEVICE_KIND_ISM, name, name, "pci"))
+		return SYSFS_OK;
+
+	device = sysfs_new_device("pci", name, name, "pci", NULL, -1);
+	if (!device)
+		return SYSFS_HANDLE_FAILED;
+	device->kind = DEVICE_KIND_ISM;
+	snprintf(path, sizeof(path), "%s/bus/pci/devices/%s", sysfs_root,
+		 name);
+	sysfs_find_util_string(device, path);
+	return SYSFS_OK;
+}
+
+/* call handler on each entry of a sysfs directory in sorted order */
+static int sysfs_scan_dir(const char *dir, int (*handler)(const char *)) {
+	struct dirent **entries;
+	char path[PATH_MAX];
+	int rc = SYSFS_OK;
+	int n;
+
+	snprintf(path, sizeof(path), "%s/%s", sysfs_root, dir);
+	n = scandir(path, &entries, NULL, alphasort);
+	if (n == -1)
+		return SYSFS_OK;
+	for (int i = 0; i < n; i++) {
+		if (entries[i]->d_name[0] != '.' && !rc) {
+			stats_inc(STATS_DEVICES_SEEN);
+			trace_begin(device, entries[i]->d_name, 0);
+			rc = handler(entries[i]->d_name);
+			trace_end(device, entries[i]->d_name, rc);
+		}
+		free(entries[i]);
+	}
+	free(entries);
+	return rc;
+}
+
+/* check if the device with name exists in a sysfs directory */
+static int sysfs_has_device(const char *dir, const char *name) {
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/%s/%s", sysfs_root, dir, name);
+	return !access(path, F_OK);
+}
+
+/* find a single net device with name or an infiniband or ism device with
+ * name and ib_port (-1 for all ports) without scanning all devices
+ */
+int sysfs_scan_device(int kind, const char *name, int ib_port) {
+	int rc = SYSFS_OK;
+
+	/* names must not leave the sysfs directories */
+	if (!name[0] || strchr(name, '/') || name[0] == '.')
+		return SYSFS_SCAN_FAILED;
+
+	log_info("Looking up device \"%s\" in \"%s\".\n", name, sysfs_root);
+	stats_start(STATS_PHASE_SCAN);
+	if (kind == DEVICE_KIND_NET) {
+		if (sysfs_has_device("class/net", name))
+			rc = sysfs_handle_net(name);
+	} else if (sysfs_has_device("class/infiniband", name)) {
+		rc = sysfs_add_ib_ports(name, ib_port);
+	} else if (sysfs_has_device("bus/pci/devices", name)) {
+		rc = sysfs_handle_pci(name);
+	}
+	probe_cleanup();
+	stats_stop(STATS_PHASE_SCAN);
+	if (rc)
+		return SYSFS_SCAN_FAILED;
+	return SYSFS_OK;
+}
+
+/* scan devices in sysfs below sysfs_root without udev */
+int sysfs_scan_devices() {
+	int rc;
+
+	log_info("Scanning devices in \"%s\".\n", sysfs_root);
+	stats_start(STATS_PHASE_SCAN);
+	rc = sysfs_scan_dir("class/infiniband", sysfs_handle_ib);
+	if (!rc)
+		rc = sysfs_scan_dir("class/net", sysfs_handle_net);
+	if (!rc)
+		rc = sysfs_scan_dir("bus/pci/devices", sysfs_handle_pci);
+	probe_cleanup();
+	stats_stop(STATS_PHASE_SCAN);
+	if (rc)
+		return SYSFS_SCAN_FAILED;
+	return SYSFS_OK;
+}
@@ -0,0 +1,15 @@
+#ifndef _PNETCTL_SYSFS_H
+#define _PNETCTL_SYSFS_H
+
+#define SYSFS_ROOT "/sys" /* default sysfs root */
+
+/* root directory of sysfs */
+extern const char *sysfs_root;
+
+int read_util_string_at(int dir_fd, const char *file, char *buffer);
+int read_util_string(const char *file, char *buffer);
+int read_ccw_util_string(const char *parent_path, char *buffer);
+int sysfs_scan_device(int kind, const char *name, int ib_port);
+int sysfs_scan_devices();
+
+#endif
@@ -0,0 +1,165 @@
+/*
+ * test for sysfs
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "test.h"
+#include "devices.h"
+#include "fixture.h"
+#include "sysfs.h"
+
+/* find device with name and ib port in devices list */
+static struct device *find_device(const char *name, int ib_port) {
+	struct device *device = get_next_device(&devices_list);
+
+	for (; device; device = get_next_device(device))
+		if (!strcmp(device->name, name) && device->ib_port == ib_port)
+			return device;
+	return NULL;
+}
+
+/* check device with name and ib port against expected values */
+static int check_device(const char *name, int ib_port, int kind, int bus,
+			const char *lowest, const char *pnetid) {
+	struct device *device = find_device(name, ib_port);
+
+	if (!device) {
+		printf("Device %s not found.\n", name);
+		return -1;
+	}
+	if (device->kind != kind || device->bus != bus ||
+	    strcmp(device->lowest ? device->lowest : "", lowest) ||
+	    strcmp(device->pnetid, pnetid) ||
+	    strcmp(device->util_pnetid, pnetid)) {
+		printf("Device %s is wrong.\n", name);
+		return -1;
+	}
+	return 0;
+}
+
+// test the function sysfs_scan_devices()
+int test_sysfs_scan_devices() {
+	struct fixture_config config = {
+		.net_devices = 4,
+		.stacks = 1,
+		.ib_devices = 1,
+		.ib_ports = 2,
+		.ccw_devices = 1,
+		.ism_devices = 1,
+	};
+	char root[] = "/tmp/pnetctl_test_sysfs.XXXXXX";
+	struct device *device;
+	int count = 0;
+	int rc = -1;
+
+	if (!mkdtemp(root))
+		return -1;
+	if (fixture_create(root, &config))
+		goto out;
+	sysfs_root = root;
+	if (sysfs_scan_devices())
+		goto out;
+
+	device = get_next_device(&devices_list);
+	for (; device; device = get_next_device(device))
+		count++;
+	if (count != 12) {
+		printf("Found %d devices.\n", count);
+		goto out;
+	}
+
+	if (check_device("mlx5_0", 1, DEVICE_KIND_IB, DEVICE_BUS_PCI, "",
+			 "PNET0") ||
+	    check_device("mlx5_0", 2, DEVICE_KIND_IB, DEVICE_BUS_PCI, "",
+			 "PNET0") ||
+	    check_device("eth0", -1, DEVICE_KIND_NET, DEVICE_BUS_PCI, "eth0",
+			 "PNET0") ||
+	    check_device("eth1", -1, DEVICE_KIND_NET, DEVICE_BUS_PCI, "eth1",
+			 "") ||
+	    check_device("eth2", -1, DEVICE_KIND_NET, DEVICE_BUS_PCI, "eth2",
+			 "PNET1") ||
+	    check_device("bond0", -1, DEVICE_KIND_NET, DEVICE_BUS_NONE, "eth0",
+			 "") ||
+	    check_device("bond1.10", -1, DEVICE_KIND_NET, DEVICE_BUS_NONE,
+			 "eth2", "") ||
+	    check_device("enc0", -1, DEVICE_KIND_NET, DEVICE_BUS_CCWGROUP,
+			 "enc0", "PNET0") ||
+	    check_device("0000:00:00.5", -1, DEVICE_KIND_ISM, DEVICE_BUS_PCI,
+			 "", "PNET0"))
+		goto out;
+	rc = 0;
+out:
+	free_devices();
+	sysfs_root = SYSFS_ROOT;
+	fixture_remove(root);
+	return rc;
+}
+
+// test the function sysfs_scan_device()
+int test_sysfs_scan_device() {
+	struct fixture_config config = {
+		.net_devices = 4,
+		.stacks = 1,
+		.ib_devices = 1,
+		.ib_ports = 2,
+		.ism_devices = 1,
+	};
+	char root[] = "/tmp/pnetctl_test_sysfs.XXXXXX";
+	struct device *device;
+	int count = 0;
+	int rc = -1;
+
+	if (!mkdtemp(root))
+		return -1;
+	if (fixture_create(root, &config))
+		goto out;
+	sysfs_root = root;
+
+	/* only the named devices are added */
+	if (sysfs_scan_device(DEVICE_KIND_NET, "bond1.10", -1) ||
+	    sysfs_scan_device(DEVICE_KIND_IB, "mlx5_0", 2) ||
+	    sysfs_scan_device(DEVICE_KIND_IB, "0000:00:00.5", -1))
+		goto out;
+	device = get_next_device(&devices_list);
+	for (; device; device = get_next_device(device))
+		count++;
+	if (count != 3) {
+		printf("Found %d devices.\n", count);
+		goto out;
+	}
+	if (check_device("bond1.10", -1, DEVICE_KIND_NET, DEVICE_BUS_NONE,
+			 "eth2", "") ||
+	    check_device("mlx5_0", 2, DEVICE_KIND_IB, DEVICE_BUS_PCI, "",
+			 "PNET0") ||
+	    check_device("0000:00:00.5", -1, DEVICE_KIND_ISM, DEVICE_BUS_PCI,
+			 "", "PNET0"))
+		goto out;
+
+	/* unknown devices and names outside of sysfs are not added */
+	if (sysfs_scan_device(DEVICE_KIND_NET, "eth9", -1) ||
+	    !sysfs_scan_device(DEVICE_KIND_NET, "../net/eth0", -1) ||
+	    get_next_device(get_next_device(get_next_device(
+			    get_next_device(&devices_list)))))
+		goto out;
+	rc = 0;
+out:
+	free_devices();
+	sysfs_root = SYSFS_ROOT;
+	fixture_remove(root);
+	return rc;
+}
+
+struct test tests[] = {
+	{"sysfs_scan_devices", test_sysfs_scan_devices},
+	{"sysfs_scan_device", test_sysfs_scan_device},
+	{NULL, NULL},
+};
+
+int main(int argc, char** argv) {
+	return run_test(tests, argc, argv);
+}
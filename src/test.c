@@ -1,14 +1,133 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
 #include "test.h"
 
-/* run a specific test with name in tests or all tests if name is NULL */
-int run_test(struct test tests[], const char *name) {
+/* repetitions and warm-up runs of each test, timing is only reported if
+ * one of them is set on the command line
+ */
+static int test_runs = 1;
+static int test_warmups;
+static int test_timing;
+
+/* get the current time of the monotonic clock in nanoseconds */
+static uint64_t test_now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* compare two run times for sorting */
+static int test_compare(const void *a, const void *b) {
+	uint64_t x = *(const uint64_t *) a;
+	uint64_t y = *(const uint64_t *) b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* get the nearest-rank percentile of the sorted run times */
+static uint64_t test_percentile(uint64_t *times, int count, int percent) {
+	int rank = (count * percent + 99) / 100;
+
+	return times[rank > 0 ? rank - 1 : 0];
+}
+
+/* run a test with the warm-up runs and repetitions and print the min,
+ * median, and 99th percentile of its run times if timing is enabled
+ */
+static int run_one_test(struct test *test) {
+	uint64_t *times;
+	uint64_t start;
+	int rc;
+
+	printf("Testing %s.\n", test->name);
+	if (!test_timing)
+		return test->func();
+
+	times = calloc(test_runs, sizeof(*times));
+	if (!times)
+		return -1;
+	for (int i = 0; i < test_warmups; i++) {
+		rc = test->func();
+		if (rc)
+			goto out;
+	}
+	for (int i = 0; i < test_runs; i++) {
+		start = test_now();
+		rc = test->func();
+		times[i] = test_now() - start;
+		if (rc)
+			goto out;
+	}
+
+	qsort(times, test_runs, sizeof(*times), test_compare);
+	printf("%s: %d runs, %d warm-up runs, min %.3f us, median %.3f us, "
+	       "p99 %.3f us\n", test->name, test_runs, test_warmups,
+	       times[0] / 1000.0, test_percentile(times, test_runs, 50) /
+	       1000.0, test_percentile(times, test_runs, 99) / 1000.0);
+out:
+	free(times);
+	return rc;
+}
+
+/* parse the count of option opt at argv[i] */
+static int parse_count(int argc, char **argv, int i, int min, int *count) {
+	char *end;
+	long n;
+
+	if (i + 1 >= argc)
+		return -1;
+	n = strtol(argv[i + 1], &end, 10);
+	if (*end || end == argv[i + 1] || n < min || n > 1000000)
+		return -1;
+	*count = n;
+	test_timing = 1;
+	return 0;
+}
+
+/* add a device with parent (NULL if none) and pnetid to the devices list */
+struct device *test_add_device(const char *subsystem, const char *name,
+			       int ib_port, const char *parent,
+			       const char *pnetid) {
+	struct device *device = new_device();
+
+	device->subsystem = subsystem;
+	device->name = name;
+	device->ib_port = ib_port;
+	device->parent = parent;
+	device->parent_subsystem = parent ? "pci" : NULL;
+	strncpy(device->pnetid, pnetid, SMC_MAX_PNETID_LEN);
+	classify_device(device);
+	return device;
+}
+
+/* run the tests selected by the command line arguments
+ * "[-r <runs>] [-w <runs>] [test]" with repetitions and warm-up runs
+ */
+int run_test(struct test tests[], int argc, char **argv) {
+	const char *name = NULL;
 	int rc;
 
-	// no command line argument -> run all tests
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-r")) {
+			if (parse_count(argc, argv, i++, 1, &test_runs))
+				goto usage;
+		} else if (!strcmp(argv[i], "-w")) {
+			if (parse_count(argc, argv, i++, 0, &test_warmups))
+				goto usage;
+		} else if (argv[i][0] == '-' || name) {
+			goto usage;
+		} else {
+			name = argv[i];
+		}
+	}
+
+	// no test name -> run all tests
 	if (!name) {
 		for (int i=0; tests[i].name != NULL; i++) {
-			printf("Testing %s.\n", tests[i].name);
-			rc = tests[i].func();
+			rc = run_one_test(&tests[i]);
 			if (rc) {
 				return rc;
 			}
@@ -16,14 +135,18 @@ int run_test(struct test tests[], const char *name) {
 		return 0;
 	}
 
-	// run specific test given as first command line argument
+	// run specific test given as command line argument
 	for (int i=0; tests[i].name != NULL; i++) {
 		if (!strcmp(tests[i].name, name)) {
-			printf("Testing %s.\n", tests[i].name);
-			return tests[i].func();
+			return run_one_test(&tests[i]);
 		}
 	}
 	printf("Test not found.\n");
 	return -1;
+usage:
+	printf("Usage: %s [-r <runs>] [-w <runs>] [test]\n"
+	       "-r	Run each test <runs> times and print its run times\n"
+	       "-w	Run each test <runs> times before timing it\n",
+	       argv[0]);
+	return -1;
 }
-
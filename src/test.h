@@ -4,6 +4,8 @@
 #include <string.h>
 #include <stdio.h>
 
+#include "devices.h"
+
 /* test structure: name of test and the test's function */
 struct test {
 	const char *name;
@@ -11,7 +13,14 @@ struct test {
 };
 
 
-/* run a specific test with name in tests or all tests if name is NULL */
-int run_test(struct test tests[], const char *name);
+/* run the tests selected by the command line arguments
+ * "[-r <runs>] [-w <runs>] [test]" with repetitions and warm-up runs
+ */
+int run_test(struct test tests[], int argc, char **argv);
+
+/* add a device with parent (NULL if none) and pnetid to the devices list */
+struct device *test_add_device(const char *subsystem, const char *name,
+			       int ib_port, const char *parent,
+			       const char *pnetid);
 
 #endif
@@ -0,0 +1,70 @@
+/*
+ * ******************
+ * *** TRACE PART ***
+ * ******************
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/syscall.h>
+
+#include "trace.h"
+#include "stats.h"
+
+/* chrome trace output file, disabled by default */
+FILE *trace_file = NULL;
+
+/* number of events written to trace file */
+static int trace_events;
+
+/* open chrome trace file and start the json event array */
+int trace_open(const char *path) {
+	trace_close();
+	trace_file = fopen(path, "w");
+	if (!trace_file)
+		return -1;
+	trace_events = 0;
+	fprintf(trace_file, "[\n");
+	return 0;
+}
+
+/* terminate the json event array and close chrome trace file */
+void trace_close() {
+	if (!trace_file)
+		return;
+	fprintf(trace_file, "\n]\n");
+	fclose(trace_file);
+	trace_file = NULL;
+}
+
+/* write string to trace file with json escaping */
+static void trace_write_string(const char *s) {
+	fputc('"', trace_file);
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			fputc('\\', trace_file);
+		if ((unsigned char) *s < 0x20)
+			fprintf(trace_file, "\\u%04x", *s);
+		else
+			fputc(*s, trace_file);
+	}
+	fputc('"', trace_file);
+}
+
+/* write a single chrome trace event to trace file */
+void trace_event(char phase, const char *name, const char *detail,
+		 int64_t value) {
+	if (!trace_file)
+		return;
+
+	fprintf(trace_file, "%s{\"name\":\"%s\",\"cat\":\"pnetctl\","
+		"\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,",
+		trace_events++ ? ",\n" : "", name, phase, stats_now() / 1000.0,
+		getpid(), (int) syscall(SYS_gettid));
+	if (phase == 'i')
+		fprintf(trace_file, "\"s\":\"t\",");
+	fprintf(trace_file, "\"args\":{\"detail\":");
+	trace_write_string(detail ? detail : "");
+	fprintf(trace_file, ",\"value\":%" PRId64 "}}", value);
+}
@@ -0,0 +1,39 @@
+#ifndef _PNETCTL_TRACE_H
+#define _PNETCTL_TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* usdt probes in provider "pnetctl" if sys/sdt.h is available */
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#define trace_probe(name, detail, value) \
+	DTRACE_PROBE2(pnetctl, name, detail, value)
+#else
+#define trace_probe(name, detail, value) do {} while (0)
+#endif
+
+/* chrome trace output file, disabled by default */
+extern FILE *trace_file;
+
+int trace_open(const char *path);
+void trace_close();
+void trace_event(char phase, const char *name, const char *detail,
+		 int64_t value);
+
+/* fire usdt probe and write chrome trace event if trace file is open */
+#define trace_at(phase, probe, name, detail, value) do {	\
+	trace_probe(probe, detail, value);			\
+	if (trace_file)						\
+		trace_event(phase, #name, detail, value);	\
+} while (0)
+
+/* trace begin and end of a span or an instant event */
+#define trace_begin(name, detail, value) \
+	trace_at('B', name##__start, name, detail, value)
+#define trace_end(name, detail, value) \
+	trace_at('E', name##__end, name, detail, value)
+#define trace_instant(name, detail, value) \
+	trace_at('i', name, name, detail, value)
+
+#endif
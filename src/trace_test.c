@@ -0,0 +1,106 @@
+/*
+ * test for trace
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "test.h"
+#include "trace.h"
+
+// read the trace file into buffer
+static int read_trace(const char *path, char *buffer, size_t len) {
+	FILE *f = fopen(path, "r");
+	size_t count;
+
+	if (!f) {
+		return -1;
+	}
+	count = fread(buffer, 1, len - 1, f);
+	buffer[count] = 0;
+	fclose(f);
+	return 0;
+}
+
+// test the functions trace_open() and trace_close()
+int test_trace_open() {
+	char path[] = "/tmp/pnetctl_trace_XXXXXX";
+	char buffer[64];
+	int fd;
+
+	// cannot open trace file
+	if (!trace_open("/does/not/exist/trace.json")) {
+		return -1;
+	}
+
+	fd = mkstemp(path);
+	if (fd == -1) {
+		return -1;
+	}
+	close(fd);
+
+	// empty trace is a valid json array
+	if (trace_open(path)) {
+		return -1;
+	}
+	trace_close();
+	trace_close();
+	if (read_trace(path, buffer, sizeof(buffer))) {
+		return -1;
+	}
+	unlink(path);
+	if (strcmp(buffer, "[\n\n]\n")) {
+		return -1;
+	}
+	return 0;
+}
+
+// test the function trace_event() and the trace macros
+int test_trace_event() {
+	char path[] = "/tmp/pnetctl_trace_XXXXXX";
+	char buffer[1024];
+	int fd;
+
+	// no trace file
+	trace_begin(device, "lo", 0);
+	trace_end(device, "lo", 0);
+
+	fd = mkstemp(path);
+	if (fd == -1) {
+		return -1;
+	}
+	close(fd);
+
+	if (trace_open(path)) {
+		return -1;
+	}
+	trace_begin(device, "lo", 0);
+	trace_instant(nl_error, "\"quoted\"", -2);
+	trace_end(device, "lo", 0);
+	trace_close();
+	if (read_trace(path, buffer, sizeof(buffer))) {
+		return -1;
+	}
+	unlink(path);
+	printf("%s", buffer);
+
+	if (!strstr(buffer, "\"name\":\"device\"") ||
+	    !strstr(buffer, "\"ph\":\"B\"") ||
+	    !strstr(buffer, "\"ph\":\"E\"") ||
+	    !strstr(buffer, "\"detail\":\"\\\"quoted\\\"\",\"value\":-2")) {
+		return -1;
+	}
+	return 0;
+}
+
+struct test tests[] = {
+	{"trace_open", test_trace_open},
+	{"trace_event", test_trace_event},
+	{NULL, NULL},
+};
+
+int main(int argc, char** argv) {
+	return run_test(tests, argc, argv);
+}
@@ -7,21 +7,20 @@
 #include <libudev.h>
 #include <unistd.h>
 #include <stdio.h>
-#include <fcntl.h>
 #include <sys/stat.h>
+#include <limits.h>
 #include <dirent.h>
-#include <iconv.h>
 #include <string.h>
 #include <stdlib.h>
 
 #include "devices.h"
+#include "filter.h"
+#include "probe.h"
+#include "sysfs.h"
 #include "verbose.h"
-
-#define DEV_TYPE_ISM "ism" /* device type for ISM devices */
-
-/* CCW device constants */
-#define CCW_CHPID_LEN 128 /* maximum chpid length */
-#define CCW_UTIL_PREFIX "/sys/devices/css0/chp0." /* util string path prefix */
+#include "stats.h"
+#include "trace.h"
+#include "lazy.h"
 
 /* udev return codes */
 enum udev_rc {
@@ -34,63 +33,35 @@ enum udev_rc {
 	UDEV_HANDLE_FAILED,
 };
 
-/* read pnetid from util_string into buffer */
-int read_util_string(const char *file, char *buffer) {
-	char read_buffer[SMC_MAX_PNETID_LEN];
-	char *read_ptr = read_buffer;
-	size_t read_count;
-	size_t conv_count;
-	iconv_t cd;
-	int fd;
-	int rc;
+/* udev context of the scanned devices, released by udev_cleanup() */
+static struct udev *udev_scan_ctx;
 
-	/* open and read file to temporary buffer*/
-	verbose("Reading util string from file \"%s\".\n", file);
-	fd  = open(file, O_RDONLY);
-	if (fd == -1)
-		return -1;
-	read_count = read(fd, read_buffer, SMC_MAX_PNETID_LEN);
-	close(fd);
-	if (read_count == -1)
-		return -1;
-
-	/* initialize ebcdic to ascii converter */
-	cd = iconv_open("ASCII", "CP500");
-	if (cd == (iconv_t) -1)
-		return -1;
-
-	/* convert pnetid from ebcdic to ascii; write to output buffer */
-	conv_count = SMC_MAX_PNETID_LEN;
-	rc = iconv(cd, &read_ptr, &read_count, &buffer, &conv_count);
-	iconv_close(cd);
-	if (rc == -1)
-		return -1;
-
-	verbose("Read util string \"%s\" from file \"%s\".\n", buffer, file);
-	return 0;
+/* get the udev context for scanning devices, create it on first use */
+static struct udev *udev_context() {
+	if (udev_scan_ctx)
+		return udev_scan_ctx;
+	if (lazy_load_udev())
+		return NULL;
+	udev_scan_ctx = udev_new();
+	if (udev_scan_ctx)
+		stats_inc(STATS_UDEV_OBJECTS);
+	return udev_scan_ctx;
 }
 
 /* helper for finding util strings of pci devices */
 int find_pci_util_string(struct device *device) {
 	const char *udev_path = udev_device_get_syspath(device->udev_parent);
-	int path_len = strlen(udev_path) + strlen("/util_string") + 1;
-	char util_string_path[path_len];
-	struct udev_list_entry *next;
+	int dir_fd;
 
-	verbose("Trying to find util_string for pci device \"%s\".\n",
+	log_trace("Trying to find util_string for pci device \"%s\".\n",
 		device->name);
 
-	next = udev_device_get_sysattr_list_entry(device->udev_parent);
-	while (next) {
-		const char *name = udev_list_entry_get_name(next);
-		if (!strncmp(name, "util_string", 11)) {
-			snprintf(util_string_path, sizeof(util_string_path),
-				 "%s/util_string", udev_path);
-			read_util_string(util_string_path, device->pnetid);
-			break;
-		}
-		next = udev_list_entry_get_next(next);
-	}
+	/* probe the attribute directly instead of reading the attribute list
+	 * of the whole device directory
+	 */
+	dir_fd = probe_dir(udev_path);
+	if (dir_fd != -1)
+		read_util_string_at(dir_fd, "util_string", device->pnetid);
 
 	return 0;
 }
@@ -98,49 +69,28 @@ int find_pci_util_string(struct device *device) {
 /* helper for finding util strings of ccwgroup devices */
 int find_ccw_util_string(struct device *device) {
 	const char *udev_path = udev_device_get_syspath(device->udev_parent);
-	int util_path_len = strlen(CCW_UTIL_PREFIX) + CCW_CHPID_LEN +
-		strlen("/util_string") + 1;
-	int chpid_path_len = strlen(udev_path) + strlen("/chpid") + 1;
-	char util_string_path[util_path_len];
-	char chpid[CCW_CHPID_LEN + 1] = {0};
-	char chpid_path[chpid_path_len];
-	int count;
-	int fd;
-
-	verbose("Trying to find util_string for ccw device \"%s\".\n",
-		device->name);
 
-	/* try to read chpid */
-	snprintf(chpid_path, sizeof(chpid_path), "%s/chpid", udev_path);
-	verbose("Reading chpid from file \"%s\".\n", chpid_path);
-	fd = open(chpid_path, O_RDONLY);
-	if (fd == -1)
-		return -1;
-	count = read(fd, chpid, CCW_CHPID_LEN);
-	close(fd);
-	if (count <= 0)
-		return count;
-	chpid[strcspn(chpid, "\r\n")] = 0;
-	verbose("Read chpid \"%s\" from file \"%s\".\n", chpid, chpid_path);
-
-	/* try to read util string */
-	snprintf(util_string_path, sizeof(util_string_path), "%s%s/util_string",
-		 CCW_UTIL_PREFIX, chpid);
-	return read_util_string(util_string_path, device->pnetid);
+	log_trace("Trying to find util_string for ccw device \"%s\".\n",
+		device->name);
+	return read_ccw_util_string(udev_path, device->pnetid);
 }
 
+/* util_string handlers of parent bus types */
+static int (*udev_util_string_handlers[DEVICE_BUS_MAX])(struct device *) = {
+	[DEVICE_BUS_PCI] = find_pci_util_string,
+	[DEVICE_BUS_CCWGROUP] = find_ccw_util_string,
+};
+
 /* try to find a util_string for the device and read the pnetid */
 int find_util_string(struct device *device) {
-	/* pci device */
-	if (device->parent_subsystem &&
-	    !strncmp(device->parent_subsystem, "pci", 3))
-		find_pci_util_string(device);
+	stats_start(STATS_PHASE_UTIL_STRING);
+	trace_begin(util_string, device->name, 0);
 
-	/* ccw group device */
-	if (device->parent_subsystem &&
-	    !strncmp(device->parent_subsystem, "ccwgroup", 8))
-		find_ccw_util_string(device);
+	if (udev_util_string_handlers[device->bus])
+		udev_util_string_handlers[device->bus](device);
 
+	trace_end(util_string, device->name, !!device->pnetid[0]);
+	stats_stop(STATS_PHASE_UTIL_STRING);
 	return 0;
 }
 
@@ -155,10 +105,13 @@ struct device *_handle_device(struct udev_device *udev_device,
 	if (!device)
 		return NULL;
 
-	/* initialize struct members */
-	device->udev_device = udev_device;
+	/* initialize struct members, the device holds its own references of
+	 * the udev devices, the parent belongs to udev_device
+	 */
+	device->udev_device = udev_device_ref(udev_device);
 	device->udev_parent = udev_parent;
-	device->udev_lowest = udev_lowest;
+	device->udev_lowest = udev_lowest ? udev_device_ref(udev_lowest) :
+		NULL;
 
 	device->name = udev_device_get_sysname(udev_device);
 	device->subsystem = udev_device_get_subsystem(udev_device);
@@ -166,10 +119,13 @@ struct device *_handle_device(struct udev_device *udev_device,
 	device->parent_subsystem = udev_device_get_subsystem(udev_parent);
 	device->lowest = udev_device_get_sysname(udev_lowest);
 	device->ib_port = ib_port;
-	verbose("Added device \"%s\" to device table.\n", device->name);
+	classify_device(device);
+	stats_inc(STATS_DEVICES_ADDED);
+	log_debug("Added device \"%s\" to device table.\n", device->name);
 
 	/* try to initialize pnetid from util_string */
 	find_util_string(device);
+	memcpy(device->util_pnetid, device->pnetid, sizeof(device->pnetid));
 
 	return device;
 }
@@ -192,46 +148,44 @@ int handle_ism_device(struct udev_device *udev_device) {
 	device = _handle_device(udev_device, udev_device, NULL, -1);
 	if (!device)
 		return UDEV_HANDLE_FAILED;
-	device->subsystem = DEV_TYPE_ISM;
+	device->kind = DEVICE_KIND_ISM;
 	return 0;
 }
 
 /* find "lower" device of a net device */
 struct udev_device *udev_find_lower(struct udev_device *udev_device) {
-	struct udev_list_entry *next;
-	const char *lower_name = NULL;
+	char lower_name[NAME_MAX + 1];
 	struct udev_device *lower_dev;
 	struct udev *udev_ctx;
+	int dir_fd;
 
-	next = udev_device_get_sysattr_list_entry(udev_device);
-	while (next) {
-		const char *name = udev_list_entry_get_name(next);
-		if (!strncmp(name, "lower_", 6)) {
-			lower_name = name + 6;
-			break;
-		}
-		next = udev_list_entry_get_next(next);
-	}
-
-	if (!lower_name)
+	dir_fd = probe_dir(udev_device_get_syspath(udev_device));
+	if (dir_fd == -1 ||
+	    probe_find_prefix(dir_fd, "lower_", lower_name, sizeof(lower_name)))
 		return NULL;
 	udev_ctx = udev_device_get_udev(udev_device);
 	lower_dev = udev_device_new_from_subsystem_sysname(udev_ctx, "net",
 							   lower_name);
+	if (lower_dev)
+		stats_inc(STATS_UDEV_OBJECTS);
 	return lower_dev;
 }
 
-/* find lowest "lower" device of a net device */
+/* find lowest "lower" device of a net device, returns a new reference */
 struct udev_device *udev_find_lowest(struct udev_device *udev_device) {
-	struct udev_device *lowest = udev_device;
+	struct udev_device *lowest = udev_device_ref(udev_device);
 	struct udev_device *lower;
 
+	stats_start(STATS_PHASE_LOWER);
+	trace_begin(lower, udev_device_get_sysname(udev_device), 0);
 	lower = udev_find_lower(udev_device);
 	while (lower) {
-		// TODO: unref lower at some point?
+		udev_device_unref(lowest);
 		lowest = lower;
 		lower = udev_find_lower(lower);
 	}
+	trace_end(lower, udev_device_get_sysname(lowest), 0);
+	stats_stop(STATS_PHASE_LOWER);
 
 	return lowest;
 }
@@ -249,6 +203,7 @@ int udev_find_ibports(struct udev_device *udev_device, int *first, int *last) {
 	snprintf(ports_dir, sizeof(ports_dir), "%s/ports", udev_path);
 	dir = opendir(ports_dir);
 	if (dir) {
+		stats_inc(STATS_SYSFS_READS);
 		*first = -1;
 		*last = -1;
 		while ((dir_ent = readdir(dir)) != NULL) {
@@ -265,87 +220,233 @@ int udev_find_ibports(struct udev_device *udev_device, int *first, int *last) {
 	return num_ports;
 }
 
+/* check if device may match the discovery filter */
+static int udev_may_discover(int kind, struct udev_device *udev_device,
+			     struct udev_device *udev_parent) {
+	return filter_may_discover(kind, udev_device_get_sysname(udev_device),
+				   udev_device_get_sysname(udev_parent),
+				   udev_device_get_subsystem(udev_parent));
+}
+
+/* handle a net device */
+static int udev_handle_net(struct udev_device *udev_device,
+			   struct udev_device *udev_parent) {
+	struct udev_device *udev_lowest;
+	int rc;
+
+	if (!udev_may_discover(DEVICE_KIND_NET, udev_device, udev_parent))
+		return 0;
+	udev_lowest = udev_find_lowest(udev_device);
+	rc = handle_device(udev_device, udev_parent, udev_lowest, -1);
+	udev_device_unref(udev_lowest);
+	return rc;
+}
+
+/* add a device for ib_port or each port of an infiniband device if ib_port
+ * is -1
+ */
+static int udev_add_ib_ports(struct udev_device *udev_device,
+			     struct udev_device *udev_parent, int ib_port) {
+	int ib_port_first = -1;
+	int ib_port_last = -1;
+	int ib_ports;
+	int rc = 0;
+
+	if (!udev_may_discover(DEVICE_KIND_IB, udev_device, udev_parent))
+		return 0;
+	ib_ports = udev_find_ibports(udev_device, &ib_port_first,
+				     &ib_port_last);
+	for (int i = ib_port_first; i < ib_port_first + ib_ports; i++)
+		if (ib_port == -1 || i == ib_port)
+			rc = handle_device(udev_device, udev_parent, NULL, i);
+	return rc;
+}
+
+/* handle an infiniband device, adds a device for each port */
+static int udev_handle_ib(struct udev_device *udev_device,
+			  struct udev_device *udev_parent) {
+	return udev_add_ib_ports(udev_device, udev_parent, -1);
+}
+
+/* handle a pci device, only ism devices are added */
+static int udev_handle_pci(struct udev_device *udev_device,
+			   struct udev_device *udev_parent) {
+	const char *driver;
+
+	driver = udev_device_get_driver(udev_device);
+	if (driver && !strncmp(driver, "ism", 3) &&
+	    udev_may_discover(DEVICE_KIND_ISM, udev_device, udev_device))
+		return handle_ism_device(udev_device);
+	return 0;
+}
+
+/* handlers of the scanned subsystems */
+static struct udev_handler {
+	const char *subsystem;
+	int (*handle)(struct udev_device *udev_device,
+		      struct udev_device *udev_parent);
+} udev_handlers[] = {
+	{"infiniband", udev_handle_ib},
+	{"net", udev_handle_net},
+	{"pci", udev_handle_pci},
+	{NULL, NULL},
+};
+
 /* handle the found udev device */
 int udev_handle_device(struct udev_device *udev_device) {
 	struct udev_device *udev_parent = NULL;
-	struct udev_device *udev_lowest = NULL;
-	int ib_port_first = -1;
-	int ib_port_last = -1;
+	struct udev_handler *handler;
 	const char *subsystem;
-	const char * driver;
-	int ib_ports = 0;
 	int rc = 0;
 
+	trace_begin(device, udev_device_get_sysname(udev_device), 0);
 	subsystem = udev_device_get_subsystem(udev_device);
 	udev_parent = udev_device_get_parent(udev_device);
 
-	if (!strncmp(subsystem, "net", 3)) {
-		udev_lowest = udev_find_lowest(udev_device);
-		rc = handle_device(udev_device, udev_parent, udev_lowest, -1);
-	}
-
-	if (!strncmp(subsystem, "infiniband", 10)) {
-	       ib_ports = udev_find_ibports(udev_device, &ib_port_first,
-					    &ib_port_last);
-	       for (int i = ib_port_first; i < ib_port_first + ib_ports; i++)
-		       rc = handle_device(udev_device, udev_parent, udev_lowest,
-					  i);
-	}
-
-	if (!strncmp(subsystem, "pci", 3)) {
-		driver = udev_device_get_driver(udev_device);
-		if (driver && !strncmp(driver, "ism", 3))
-			rc = handle_ism_device(udev_device);
+	for (handler = udev_handlers; handler->subsystem; handler++) {
+		if (!strcmp(subsystem, handler->subsystem)) {
+			rc = handler->handle(udev_device, udev_parent);
+			break;
+		}
 	}
 
+	trace_end(device, udev_device_get_sysname(udev_device), rc);
 	if (rc)
 		return rc;
 
 	return UDEV_OK;
 }
 
-/* scan devices and call handle_device on each */
-int udev_scan_devices() {
+/* open the device with name in subsystem and add it to the devices list */
+static int udev_add_device(struct udev *udev_ctx, const char *subsystem,
+			   const char *name, int ib_port) {
+	struct udev_device *udev_device;
+	struct udev_device *udev_parent;
+	int rc = UDEV_OK;
+
+	udev_device = udev_device_new_from_subsystem_sysname(udev_ctx,
+							     subsystem, name);
+	if (!udev_device)
+		return UDEV_DEV_FAILED;
+	stats_inc(STATS_UDEV_OBJECTS);
+	stats_inc(STATS_DEVICES_SEEN);
+
+	trace_begin(device, name, 0);
+	udev_parent = udev_device_get_parent(udev_device);
+	if (!strcmp(subsystem, "net"))
+		rc = udev_handle_net(udev_device, udev_parent);
+	else if (!strcmp(subsystem, "infiniband"))
+		rc = udev_add_ib_ports(udev_device, udev_parent, ib_port);
+	else
+		rc = udev_handle_pci(udev_device, udev_parent);
+	trace_end(device, name, rc);
+	udev_device_unref(udev_device);
+	return rc;
+}
+
+/* find a single net device with name or an infiniband or ism device with
+ * name and ib_port (-1 for all ports) without scanning all devices
+ */
+int udev_scan_device(int kind, const char *name, int ib_port) {
+	struct udev *udev_ctx = udev_context();
+	int rc;
+
+	if (!udev_ctx)
+		return UDEV_FAILED;
+
+	log_info("Looking up device \"%s\" with udev.\n", name);
+	stats_start(STATS_PHASE_SCAN);
+	if (kind == DEVICE_KIND_NET) {
+		rc = udev_add_device(udev_ctx, "net", name, -1);
+	} else {
+		rc = udev_add_device(udev_ctx, "infiniband", name, ib_port);
+		if (rc == UDEV_DEV_FAILED)
+			rc = udev_add_device(udev_ctx, "pci", name, -1);
+	}
+	probe_cleanup();
+	stats_stop(STATS_PHASE_SCAN);
+	return rc;
+}
+
+/* scan devices helper */
+int _udev_scan_devices() {
+	struct udev *udev_ctx = udev_context();
 	struct udev_enumerate *udev_enum;
 	struct udev_list_entry *next;
-	struct udev *udev_ctx;
+	int rc = UDEV_OK;
 
-	udev_ctx = udev_new();
 	if (!udev_ctx)
 		return UDEV_FAILED;
-
 	udev_enum = udev_enumerate_new(udev_ctx);
 	if (!udev_enum)
 		return UDEV_ENUM_FAILED;
+	stats_inc(STATS_UDEV_OBJECTS);
 
-	if (udev_enumerate_add_match_subsystem(udev_enum, "infiniband"))
-		return UDEV_MATCH_FAILED;
-
-	if (udev_enumerate_add_match_subsystem(udev_enum, "net"))
-		return UDEV_MATCH_FAILED;
-
-	if (udev_enumerate_add_match_subsystem(udev_enum, "pci"))
-		return UDEV_MATCH_FAILED;
+	for (int i = 0; udev_handlers[i].subsystem; i++) {
+		if (udev_enumerate_add_match_subsystem(
+			    udev_enum, udev_handlers[i].subsystem)) {
+			rc = UDEV_MATCH_FAILED;
+			goto out;
+		}
+	}
 
-	verbose("Scanning devices with udev.\n");
-	if (udev_enumerate_scan_devices(udev_enum) < 0)
-		return UDEV_SCAN_FAILED;
+	log_info("Scanning devices with udev.\n");
+	if (udev_enumerate_scan_devices(udev_enum) < 0) {
+		rc = UDEV_SCAN_FAILED;
+		goto out;
+	}
 
-	/* enumerate all devices and handle them */
+	/* enumerate all devices and handle them, the devices in the devices
+	 * list hold their own references
+	 */
 	next = udev_enumerate_get_list_entry(udev_enum);
-	while (next) {
+	while (next && !rc) {
 		const char *name = udev_list_entry_get_name(next);
 		struct udev_device *udev_device;
-		int rc;
 
 		udev_device = udev_device_new_from_syspath(udev_ctx, name);
-		if (!udev_device)
-			return UDEV_DEV_FAILED;
+		if (!udev_device) {
+			rc = UDEV_DEV_FAILED;
+			break;
+		}
+		stats_inc(STATS_UDEV_OBJECTS);
+		stats_inc(STATS_DEVICES_SEEN);
 
 		rc = udev_handle_device(udev_device);
-		if (rc)
-			return rc;
+		udev_device_unref(udev_device);
 		next = udev_list_entry_get_next(next);
 	}
-	return UDEV_OK;
+out:
+	udev_enumerate_unref(udev_enum);
+	return rc;
+}
+
+/* scan devices and call handle_device on each */
+int udev_scan_devices() {
+	int rc;
+
+	stats_start(STATS_PHASE_SCAN);
+	rc = _udev_scan_devices();
+	probe_cleanup();
+	stats_stop(STATS_PHASE_SCAN);
+	return rc;
+}
+
+/* drop the references of device to its udev devices */
+void udev_release_device(struct device *device) {
+	if (device->udev_device)
+		udev_device_unref(device->udev_device);
+	if (device->udev_lowest)
+		udev_device_unref(device->udev_lowest);
+	device->udev_device = NULL;
+	device->udev_parent = NULL;
+	device->udev_lowest = NULL;
+}
+
+/* release the udev context after all devices are freed */
+void udev_cleanup() {
+	if (!udev_scan_ctx)
+		return;
+	udev_unref(udev_scan_ctx);
+	udev_scan_ctx = NULL;
 }
@@ -1,6 +1,11 @@
 #ifndef _PNETCTL_UDEV_H
 #define _PNETCTL_UDEV_H
 
+#include "devices.h"
+
 int udev_scan_devices();
+int udev_scan_device(int kind, const char *name, int ib_port);
+void udev_release_device(struct device *device);
+void udev_cleanup();
 
 #endif
@@ -6,6 +6,7 @@
 #include <stdio.h>
 
 #include "test.h"
+#include "devices.h"
 #include "udev.h"
 
 // test the function udev_scan_devices()
@@ -13,15 +14,23 @@ int test_udev_scan_devices() {
 	return udev_scan_devices();
 }
 
+// test the function udev_scan_device()
+int test_udev_scan_device() {
+	int rc;
+
+	rc = udev_scan_device(DEVICE_KIND_NET, "lo", -1);
+	if (!rc && !get_next_device(&devices_list))
+		rc = -1;
+	free_devices();
+	return rc;
+}
+
 struct test tests[] = {
 	{"udev_scan_devices", test_udev_scan_devices},
+	{"udev_scan_device", test_udev_scan_device},
 	{NULL, NULL},
 };
 
 int main(int argc, char** argv) {
-	const char *name = NULL;
-	if (argc > 1) {
-		name = argv[1];
-	}
-	return run_test(tests, name);
+	return run_test(tests, argc, argv);
 }
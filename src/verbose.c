@@ -3,12 +3,11 @@
 
 #include "verbose.h"
 
-/* print verbose output to the screen if in verbose mode */
-void verbose(const char *format, ...) {
+/* print log output to stderr, level checks are done by the log macros */
+void log_print(const char *format, ...) {
 	va_list args;
 
 	va_start(args, format);
-	if (verbose_mode)
-		vprintf(format, args);
+	vfprintf(stderr, format, args);
 	va_end(args);
 }
@@ -1,9 +1,36 @@
 #ifndef _PNETCTL_VERBOSE_H
 #define _PNETCTL_VERBOSE_H
 
-/* verbose output, disabled by default */
-extern int verbose_mode;
+/* log levels, each level includes all levels below it */
+enum log_levels {
+	LOG_LEVEL_ERROR,
+	LOG_LEVEL_INFO,
+	LOG_LEVEL_DEBUG,
+	LOG_LEVEL_TRACE,
+};
 
-void verbose(const char *format, ...);
+/* current log level, only errors by default */
+extern int log_level;
+
+void log_print(const char *format, ...)
+	__attribute__((format(printf, 1, 2)));
+
+/* check the log level before evaluating any arguments */
+#define log_at(level, ...) do {				\
+	if (log_level >= (level))				\
+		log_print(__VA_ARGS__);				\
+} while (0)
+
+#define log_error(...) log_at(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define log_info(...) log_at(LOG_LEVEL_INFO, __VA_ARGS__)
+
+/* debug and trace output can be compiled out with -Ddebug_log=false */
+#ifdef PNETCTL_NO_DEBUG_LOG
+#define log_debug(...) do { if (0) log_print(__VA_ARGS__); } while (0)
+#define log_trace(...) do { if (0) log_print(__VA_ARGS__); } while (0)
+#else
+#define log_debug(...) log_at(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define log_trace(...) log_at(LOG_LEVEL_TRACE, __VA_ARGS__)
+#endif
 
 #endif
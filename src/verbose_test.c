@@ -8,32 +8,57 @@
 #include "test.h"
 #include "verbose.h"
 
-// test the function verbose()
-int test_verbose() {
-	verbose_mode = 0;
-	verbose("");
-	verbose("Hello World\n");
-	verbose("Hello %s\n", "World");
-	verbose("Verbose_mode: %d\n", verbose_mode);
-
-	verbose_mode = 1;
-	verbose("");
-	verbose("Hello World\n");
-	verbose("Hello %s\n", "World");
-	verbose("Verbose_mode: %d\n", verbose_mode);
+// count evaluations of log arguments
+static int evaluated;
 
+static const char *count_eval(const char *s) {
+	evaluated++;
+	return s;
+}
+
+// test the function log_print()
+int test_log_print() {
+	log_print("%s", "");
+	log_print("Hello World\n");
+	log_print("Hello %s\n", "World");
+	return 0;
+}
+
+// test the log level macros
+int test_log_levels() {
+	// arguments must not be evaluated above the current log level
+	evaluated = 0;
+	log_level = LOG_LEVEL_ERROR;
+	log_info("Hello %s\n", count_eval("World"));
+	log_debug("Hello %s\n", count_eval("World"));
+	log_trace("Hello %s\n", count_eval("World"));
+	if (evaluated) {
+		return -1;
+	}
+
+	// errors are always printed
+	log_error("Log_level: %d\n", log_level);
+
+	log_level = LOG_LEVEL_INFO;
+	log_info("Hello %s\n", count_eval("World"));
+	if (evaluated != 1) {
+		return -1;
+	}
+
+	log_level = LOG_LEVEL_TRACE;
+	log_debug("Hello %s\n", "World");
+	log_trace("Log_level: %d\n", log_level);
+
+	log_level = LOG_LEVEL_ERROR;
 	return 0;
 }
 
 struct test tests[] = {
-	{"verbose", test_verbose},
+	{"log_print", test_log_print},
+	{"log_levels", test_log_levels},
 	{NULL, NULL},
 };
 
 int main(int argc, char** argv) {
-	const char *name = NULL;
-	if (argc > 1) {
-		name = argv[1];
-	}
-	return run_test(tests, name);
+	return run_test(tests, argc, argv);
 }